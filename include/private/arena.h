@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_ARENA_H_
+#define PRIVATE_ARENA_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/lltl/parray.h>
+
+#define ARENA_ALIGN                 64
+#define ARENA_GRANULARITY           0x4000      // Capacity of blocks is rounded up to 64 KiB
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * The memory block owned by the arena
+     */
+    typedef struct arena_block_t
+    {
+        float          *vData;          // Aligned data of the block
+        size_t          nCapacity;      // Capacity of the block in samples
+        uint8_t        *pData;          // Allocated data
+    } arena_block_t;
+
+    /**
+     * The arena of aligned buffers. The pipeline stages borrow temporary buffers from
+     * the arena and return them back after use, the returned blocks are kept and reused
+     * by the next borrows, so processing of the series of files of the same size does
+     * not touch the system allocator after the first file. The arena is not thread-safe,
+     * each worker thread should use its own arena.
+     */
+    struct arena_t
+    {
+        private:
+            arena_t & operator = (const arena_t &);
+
+        public:
+            lltl::parray<arena_block_t> vFree;          // Blocks available for borrowing
+            lltl::parray<arena_block_t> vBusy;          // Borrowed blocks
+            size_t                      nBorrowed;      // Number of currently borrowed bytes
+            size_t                      nPeak;          // The high-water mark of borrowed bytes
+            size_t                      nReserved;      // Number of bytes allocated by the arena
+            size_t                      nAllocations;   // Number of allocations performed by the arena
+
+        public:
+            explicit arena_t();
+            ~arena_t();
+
+        public:
+            void clear();
+    };
+
+    /**
+     * Borrow the aligned buffer from the arena. The best fitting free block is reused,
+     * the new block is allocated only if there is no free block of sufficient capacity.
+     * The contents of the buffer are undefined.
+     *
+     * @param arena the arena
+     * @param count the number of samples in the buffer
+     * @return pointer to the buffer or NULL if there is not enough memory
+     */
+    float *arena_borrow(arena_t *arena, size_t count);
+
+    /**
+     * Borrow the set of aligned planar buffers from the arena as a single block.
+     * The buffers of channels are placed one after another with aligned stride.
+     *
+     * @param arena the arena
+     * @param dst array to store pointers to the buffers of channels
+     * @param channels number of channels
+     * @param length number of samples per channel
+     * @return pointer to the borrowed block which should be returned to the arena,
+     *   or NULL if there is not enough memory
+     */
+    float *arena_borrow_planar(arena_t *arena, float **dst, size_t channels, size_t length);
+
+    /**
+     * Return the borrowed buffer back to the arena
+     *
+     * @param arena the arena
+     * @param buf the buffer returned by arena_borrow() or arena_borrow_planar(), may be NULL
+     */
+    void arena_return(arena_t *arena, float *buf);
+
+    /**
+     * Compute the overall high-water mark of borrowed data for the set of arenas
+     *
+     * @param arenas array of arenas
+     * @param count number of arenas
+     * @return the sum of high-water marks in bytes
+     */
+    size_t arena_peak(const arena_t *arenas, size_t count);
+
+    /**
+     * Compute the overall number of bytes allocated by the set of arenas
+     *
+     * @param arenas array of arenas
+     * @param count number of arenas
+     * @return the number of bytes allocated by arenas
+     */
+    size_t arena_reserved(const arena_t *arenas, size_t count);
+}
+
+#endif /* PRIVATE_ARENA_H_ */
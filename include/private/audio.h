@@ -26,14 +26,50 @@
 #include <lsp-plug.in/runtime/LSPString.h>
 #include <lsp-plug.in/dsp-units/sampling/Sample.h>
 #include <lsp-plug.in/expr/Resolver.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/mm/types.h>
 
+#include <private/arena.h>
 #include <private/config/data.h>
 #include <private/config/config.h>
+#include <private/fftconv.h>
+#include <private/naming.h>
+#include <private/profile.h>
 
 namespace timbremill
 {
     using namespace lsp;
 
+    /**
+     * The averaging of the frame magnitudes for the spectral profile
+     */
+    typedef struct spc_average_t
+    {
+        ssize_t                 nMethod;        // Averaging method, see average_t
+        float                   fPower;         // Exponent of the power mean
+        float                   fPercentile;    // Percentile of frame magnitudes (0..100)
+    } spc_average_t;
+
+    /**
+     * Compute the path of the input file
+     *
+     * @param path the path to store the result
+     * @param base base directory for relative file names
+     * @param name name of the file
+     * @return status of operation
+     */
+    status_t input_file_path(io::Path *path, const LSPString *base, const LSPString *name);
+
+    /**
+     * Read the parameters of the audio file from it's header without decoding the audio data
+     *
+     * @param info the parameters of the audio stream to store
+     * @param base base directory
+     * @param name name of the file
+     * @return status of operation, STATUS_NOT_FOUND if the file does not exist
+     */
+    status_t read_audio_info(mm::audio_stream_t *info, const LSPString *base, const LSPString *name);
+
     /**
      * Load audio file and perform resampling
      *
@@ -46,6 +82,32 @@ namespace timbremill
      */
     status_t load_audio_file(dspu::Sample *sample, size_t *file_srate, size_t srate, const LSPString *base, const LSPString *name);
 
+    /**
+     * Load audio data from the in-memory sample and perform resampling
+     *
+     * @param sample sample to store audio data
+     * @param file_srate pointer to save original sample rate of the data
+     * @param srate desired sample rate
+     * @param src source sample
+     * @return status of operation
+     */
+    status_t load_audio_file(dspu::Sample *sample, size_t *file_srate, size_t srate, const dspu::Sample *src);
+
+    /**
+     * Load audio data from the in-memory planar buffers and perform resampling
+     *
+     * @param sample sample to store audio data
+     * @param file_srate pointer to save original sample rate of the data
+     * @param srate desired sample rate
+     * @param data array of pointers to the channel data
+     * @param channels number of channels
+     * @param length number of samples per channel
+     * @param sample_rate sample rate of the data
+     * @return status of operation
+     */
+    status_t load_audio_file(dspu::Sample *sample, size_t *file_srate, size_t srate,
+        const float * const *data, size_t channels, size_t length, size_t sample_rate);
+
     /**
      * Save audio file
      *
@@ -58,50 +120,213 @@ namespace timbremill
     status_t save_audio_file(dspu::Sample *sample, const LSPString *base, const LSPString *fmt, expr::Resolver *vars);
 
     /**
-     * Compute the spectral profile for the input signal
+     * Save audio file with the specified format. The gain and the dither are applied
+     * while encoding the data, the sample is not modified.
+     *
+     * @param sample sample to save
+     * @param naming the naming context of output files
+     * @param fmt output file name format
+     * @param vars variable to parametrize the output file name format
+     * @param format the format of the output file
+     * @param gain the gain to apply to the sample data
+     * @return status of operation
+     */
+    status_t save_audio_file(const dspu::Sample *sample, naming_t *naming, const LSPString *fmt, expr::Resolver *vars,
+        const fformat_t *format, float gain);
+
+    /**
+     * Save audio data to the in-memory planar buffers. If the sample is shorter than
+     * the buffers, the rest of the buffers is filled with zeros.
+     *
+     * @param data array of pointers to the channel data
+     * @param channels number of channels, should match the number of channels in the sample
+     * @param length number of samples per channel
+     * @param sample sample to save
+     * @return status of operation
+     */
+    status_t save_audio_file(float * const *data, size_t channels, size_t length, const dspu::Sample *sample);
+
+    /**
+     * Load the spectral profile from the binary profile file
+     *
+     * @param profile the spectral profile to store the data
+     * @param info the profile description to store the data
+     * @param base base directory
+     * @param name name of the file (absolute or relative to the base directory)
+     * @return status of operation
+     */
+    status_t load_profile_file(dspu::Sample *profile, profile_info_t *info, const LSPString *base, const LSPString *name);
+
+    /**
+     * Save the spectral profile to the binary profile file
      *
-     * @param profile spectral profile containing 2^precision averaged spectrum magnitude values.
+     * @param profile the spectral profile to save
+     * @param info the profile description
+     * @param naming the naming context of output files
+     * @param fmt output file name format
+     * @param vars variable to parametrize the output file name format
+     * @param encoding the encoding of the spectrum bins, see prof_encoding_t
+     * @return status of operation
+     */
+    status_t save_profile_file(const dspu::Sample *profile, const profile_info_t *info,
+        naming_t *naming, const LSPString *fmt, expr::Resolver *vars, ssize_t encoding);
+
+    /**
+     * Compute the number of FFT frames averaged by the spectral profile
+     *
+     * @param length number of samples per channel of the analyzed data
+     * @param precision the precision of the spectral profile
+     * @return number of averaged FFT frames
+     */
+    wsize_t spectral_profile_frames(size_t length, size_t precision);
+
+    /**
+     * Get the number of points of the spectral profile. The profile on the linear grid contains
+     * 2^(precision-1)+1 bins of the half-spectrum, the profile on the logarithmic grid contains
+     * the requested number of points limited from below, each point is the mean of the band
+     * of bins, bands are distributed geometrically from the bin 1 to the niquist bin.
+     *
+     * @param grid the requested number of points of the logarithmic grid, zero or not less than the number
+     *   of bins for the linear grid
+     * @param precision the precision of the spectral profile
+     * @return number of points of the spectral profile
+     */
+    size_t profile_points(size_t grid, size_t precision);
+
+    /**
+     * Get the parameter of the averaging method stored in the profile description:
+     * the exponent for the power mean, the percentile for the median and percentile averaging
+     *
+     * @param avg the averaging of frame magnitudes, NULL for the arithmetic mean
+     * @return the parameter of the averaging method, zero if the method has no parameters
+     */
+    float spectral_average_param(const spc_average_t *avg);
+
+    /**
+     * Compute the spectral profile for the input signal. The frame magnitudes are averaged by
+     * the arithmetic mean, the power mean or the mean in the logarithmic domain, or the percentile
+     * of the magnitudes is estimated for each bin from the fixed-size histogram with logarithmic
+     * buckets, so the memory does not depend on the length of the signal.
+     *
+     * @param profile spectral profile containing 2^(precision-1)+1 averaged spectrum magnitude values
+     *   from zero to niquist frequency, or the values on the logarithmic grid, see profile_points()
      * @param src source sample
      * @param precision the precision of the spectral profile.
+     * @param grid the number of points of the logarithmic grid, zero for the linear grid. The bins of
+     *   each frame are aggregated into the bands of the grid before averaging
+     * @param avg the averaging of frame magnitudes, NULL for the arithmetic mean
+     * @param arena the arena to borrow the temporary buffers from, NULL for private temporary buffers
+     * @return status of operation
+     */
+    status_t spectral_profile(dspu::Sample *profile, const dspu::Sample *src, size_t precision, size_t grid,
+        const spc_average_t *avg, arena_t *arena);
+
+    /**
+     * Compute the spectral profile for the input signal stored in planar buffers
+     *
+     * @param profile spectral profile containing 2^(precision-1)+1 averaged spectrum magnitude values
+     *   from zero to niquist frequency, or the values on the logarithmic grid, see profile_points()
+     * @param data array of pointers to the channel data
+     * @param channels number of channels
+     * @param length number of samples per channel
+     * @param sample_rate sample rate of the data
+     * @param precision the precision of the spectral profile.
+     * @param grid the number of points of the logarithmic grid, zero for the linear grid
+     * @param avg the averaging of frame magnitudes, NULL for the arithmetic mean
+     * @param arena the arena to borrow the temporary buffers from, NULL for private temporary buffers
      * @return status of operation
      */
-    status_t spectral_profile(dspu::Sample *profile, const dspu::Sample *src, size_t precision);
+    status_t spectral_profile(dspu::Sample *profile,
+        const float * const *data, size_t channels, size_t length, size_t sample_rate,
+        size_t precision, size_t grid, const spc_average_t *avg, arena_t *arena);
 
     /**
      * Compute the impulse response for timbral correction. The spectral correction is computed
      * as a result of division of the child spectral characteristics by master spectral
      * characteristics. Frequencies above the niquist frequency with subtracted transition octaves
-     * are considered as transitional and are not affected by the timbral correction
+     * are considered as transitional and are not affected by the timbral correction.
+     * The correction gain is limited to the +/- db_range, the divisor spectrum is limited from
+     * below by the spectral floor which is db_range decibels below it's peak value.
      *
      * @param dst destination sample to store the impulse response
      * @param master the master profile
      * @param child the child file profile
      * @param precision the FFT precision
-     * @param db_range the dynamic range
+     * @param db_range the dynamic range of the correction in decibels, zero or negative value disables the limit
      * @param sample rate the actual signal limiting sample rate
      * @param transition transition zone in octaves (number of transition octaves)
+     * @param smoothing the width of the fractional-octave smoothing of both profiles in octaves, zero disables smoothing
      * @return status of operation
      */
     status_t timbre_impulse_response(
         dspu::Sample *dst,
         const dspu::Sample *master, const dspu::Sample *child,
         size_t precision, float db_range, size_t sample_rate,
-        float transition);
+        float transition, float smoothing);
+
+    /**
+     * Compute the impulse responses for timbral correction of multiple child files
+     * respective to the same master file. The reciprocal of the master spectrum is computed
+     * once per channel, the spectral division for all children is performed in one sweep
+     * and all inverse FFTs are issued back-to-back with shared window and temporary buffers.
+     * If profiles are on the logarithmic grid, the correction is computed for points of the grid
+     * and expanded to bins only to synthesize the impulse response.
+     *
+     * @param dst array of destination samples to store the impulse responses
+     * @param master the master profile
+     * @param children array of child file profiles
+     * @param sample_rates array of actual signal limiting sample rates for each child
+     * @param count number of child profiles
+     * @param reverse compute the correction of the master profile respective to the child profiles
+     *   instead of the correction of child profiles respective to the master profile
+     * @param phase the phase of the impulse response: PHASE_LINEAR produces symmetric impulse responses
+     *   of 2^precision samples centered at the middle, PHASE_MINIMUM produces front-loaded impulse
+     *   responses of 2^(precision-1) samples built from the same magnitude using the real cepstrum
+     * @param precision the FFT precision
+     * @param db_range the dynamic range of the correction in decibels, zero or negative value disables the limit
+     * @param transition transition zone in octaves (number of transition octaves)
+     * @param smoothing the width of the fractional-octave smoothing of profiles in octaves, zero disables smoothing.
+     *   The smoothing is applied to the master and child profiles before the division, so the bin-level noise
+     *   does not get into the correction and the impulse responses are shorter
+     * @param arena the arena to borrow the temporary buffers from, NULL for private temporary buffers
+     * @return status of operation
+     */
+    status_t timbre_impulse_responses(
+        dspu::Sample * const *dst,
+        const dspu::Sample *master, const dspu::Sample * const *children,
+        const size_t *sample_rates, size_t count, bool reverse, ssize_t phase,
+        size_t precision, float db_range, float transition, float smoothing, arena_t *arena);
 
     /**
      * Produce the linear impulse response from the spectral profile
      *
      * @param dst destination sample to store the impulse response
-     * @param profile the original profile
+     * @param profile the original profile on the linear or the logarithmic grid
      * @param precision the FFT precision
      * @param top_sr
+     * @param arena the arena to borrow the temporary buffers from, NULL for private temporary buffers
      * @return status of operation
      */
-    status_t profile_to_impulse_response(dspu::Sample *dst, const dspu::Sample *profile, size_t precision);
+    status_t profile_to_impulse_response(dspu::Sample *dst, const dspu::Sample *profile, size_t precision, arena_t *arena);
 
 
     /**
-     * Perform trimming of impulse response file
+     * Find the shortest window around the peak of the impulse response that retains
+     * the desired amount of energy
+     *
+     * @param head pointer to store the first sample of the window
+     * @param count pointer to store the number of samples in the window
+     * @param src impulse response
+     * @param energy the maximum energy (in dB) relative to the overall energy of the impulse response
+     *   allowed to be left outside of the window
+     */
+    void energy_window(size_t *head, size_t *count, const dspu::Sample *src, float energy);
+
+    /**
+     * Perform trimming of impulse response file. If the automatic trimming is enabled,
+     * the fixed head and tail cuts are ignored and the window is computed from
+     * the energy distribution of the impulse response, fades are applied relative
+     * to the length of the window.
      *
      * @param dst destination sample to store trimmed data
      * @param src non-trimmed IR file
@@ -124,18 +349,123 @@ namespace timbremill
      * @param latency
      * @param dry the amount of dry (unprocessed signal) in gain units (1.0f = 0 dB)
      * @param wet the amount of wet (processed signal) in gain units (1.0f = 0 dB)
+     * @param engine the convolution engine, see convolver_t
+     * @param threads maximum number of threads used for rendering
+     * @return status of operation
+     */
+    status_t convolve(dspu::Sample *dst, const dspu::Sample *src, const dspu::Sample *ir, ssize_t latency, float dry, float wet, ssize_t engine, size_t threads);
+
+    /**
+     * Convolve impulse response with the audio data stored in planar buffers and store
+     * the result in another set of planar buffers. If the output buffers are shorter than
+     * the convolution result, the result is truncated. Channels are rendered in parallel,
+     * if there are less channels than threads, long channels are split into time segments
+     * which are convolved independently and stitched together with overlap-add.
+     *
+     * @param dst array of pointers to the output channel data
+     * @param dst_length number of samples per output channel
+     * @param src array of pointers to the input channel data
+     * @param channels number of channels, should match the number of channels in the impulse response
+     * @param length number of samples per input channel
+     * @param ir impulse response to convolve
+     * @param latency
+     * @param dry the amount of dry (unprocessed signal) in gain units (1.0f = 0 dB)
+     * @param wet the amount of wet (processed signal) in gain units (1.0f = 0 dB)
+     * @param engine the convolution engine, see convolver_t
+     * @param threads maximum number of threads used for rendering
      * @return status of operation
      */
-    status_t convolve(dspu::Sample *dst, const dspu::Sample *src, const dspu::Sample *ir, ssize_t latency, float dry, float wet);
+    status_t convolve(
+        float * const *dst, size_t dst_length,
+        const float * const *src, size_t channels, size_t length,
+        const dspu::Sample *ir, ssize_t latency, float dry, float wet, ssize_t engine, size_t threads);
 
     /**
-     * Normalize sample to the specified gain
-     * @param dst sample to normalize
+     * Convolve the precomputed spectrum of the impulse response with the audio sample
+     * using the offline convolution engine and store the result in another audio sample.
+     * The spectrum is not modified and can be shared between multiple renders.
+     *
+     * @param dst destination sample to store data
+     * @param src source sample to convolve
+     * @param ir spectrum of the impulse response to convolve
+     * @param latency
+     * @param dry the amount of dry (unprocessed signal) in gain units (1.0f = 0 dB)
+     * @param wet the amount of wet (processed signal) in gain units (1.0f = 0 dB)
+     * @param threads maximum number of threads used for rendering
+     * @return status of operation
+     */
+    status_t convolve(dspu::Sample *dst, const dspu::Sample *src, const ir_spectrum_t *ir, ssize_t latency, float dry, float wet, size_t threads);
+
+    /**
+     * Convolve the precomputed spectrum of the impulse response with the audio data stored
+     * in planar buffers using the offline convolution engine and store the result in another
+     * set of planar buffers. The spectrum is not modified and can be shared between multiple
+     * renders.
+     *
+     * @param dst array of pointers to the output channel data
+     * @param dst_length number of samples per output channel
+     * @param src array of pointers to the input channel data
+     * @param channels number of channels, should match the number of channels in the impulse response
+     * @param length number of samples per input channel
+     * @param ir spectrum of the impulse response to convolve
+     * @param latency
+     * @param dry the amount of dry (unprocessed signal) in gain units (1.0f = 0 dB)
+     * @param wet the amount of wet (processed signal) in gain units (1.0f = 0 dB)
+     * @param threads maximum number of threads used for rendering
+     * @return status of operation
+     */
+    status_t convolve(
+        float * const *dst, size_t dst_length,
+        const float * const *src, size_t channels, size_t length,
+        const ir_spectrum_t *ir, ssize_t latency, float dry, float wet, size_t threads);
+
+    /**
+     * Compute the full length of the convolution result
+     *
+     * @param length number of samples in the input signal
+     * @param ir_length number of samples in the impulse response
+     * @param latency the output latency of the impulse response
+     * @return number of samples in the convolution result
+     */
+    size_t convolution_length(size_t length, size_t ir_length, ssize_t latency);
+
+    /**
+     * Render the processed audio file in one pass: convolve the impulse response with the audio
+     * sample, mix dry and wet signals, compensate the latency and match the length of the output
+     * to the input. Each output sample is written once and the peak value of the output is
+     * computed on the fly, so the normalization can be applied as a single scale. If the
+     * destination sample has enough capacity, its data is reused for the output.
+     *
+     * @param dst destination sample to store data
+     * @param peak pointer to store the peak value of the output, may be NULL
+     * @param src source sample to convolve
+     * @param ir impulse response to convolve
+     * @param latency the output latency of the impulse response
+     * @param dry the amount of dry (unprocessed signal) in gain units (1.0f = 0 dB)
+     * @param wet the amount of wet (processed signal) in gain units (1.0f = 0 dB)
+     * @param compensate remove the samples that introduce the latency from the beginning of the output
+     * @param match_length match the length of the output to the length of the source sample
+     * @param engine the convolution engine, see convolver_t
+     * @param threads maximum number of threads used for rendering
+     * @param arenas array of at least threads arenas, one per worker thread, to borrow the temporary
+     *   buffers from, NULL for private temporary buffers
+     * @return status of operation
+     */
+    status_t render_audio(
+        dspu::Sample *dst, float *peak,
+        const dspu::Sample *src, const dspu::Sample *ir,
+        ssize_t latency, float dry, float wet,
+        bool compensate, bool match_length,
+        ssize_t engine, size_t threads, arena_t *arenas);
+
+    /**
+     * Compute the gain to apply for normalization of the signal with the known peak value
+     * @param peak the peak value of the signal
      * @param gain the maximum peak gain
      * @param mode the normalization mode
-     * @return status of operation
+     * @return the gain to apply to the signal
      */
-    status_t normalize(dspu::Sample *dst, float gain, size_t mode);
+    float normalizing_gain(float peak, float gain, size_t mode);
 
     /**
      * Cut the first amount of samples from the sample file to compensate the latency
@@ -83,6 +83,16 @@ namespace timbremill
      */
     status_t parse_config(config_t *cfg, io::IInSequence *is);
 
+    /**
+     * Read the next job from the file with groups in JSON-lines format, each non-empty
+     * line of the file contains the JSON object with the description of one group
+     * @param grp the empty group to fill
+     * @param is input character sequence
+     * @param line the counter of read lines to update
+     * @return status of operation, STATUS_EOF if there are no more jobs
+     */
+    status_t read_job(fgroup_t *grp, io::IInSequence *is, size_t *line);
+
 }
 
 #endif /* PRIVATE_CONFIG_CONFIG_H_ */
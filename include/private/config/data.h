@@ -23,10 +23,13 @@
 #define PRIVATE_CONFIG_DATA_H_
 
 #include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
 #include <lsp-plug.in/lltl/parray.h>
 #include <lsp-plug.in/lltl/pphash.h>
 #include <lsp-plug.in/runtime/LSPString.h>
 
+#define SMOOTHING_MAX           2.0f        // The maximum width of the fractional-octave smoothing in octaves
+
 namespace timbremill
 {
     using namespace lsp;
@@ -38,10 +41,23 @@ namespace timbremill
         OUT_AUDIO   = 1 << 2,
         OUT_FRM     = 1 << 3,
         OUT_FRC     = 1 << 4,
+        OUT_PRM     = 1 << 5,
+        OUT_PRC     = 1 << 6,
 
         OUT_ALL     = OUT_IR | OUT_RAW | OUT_AUDIO | OUT_FRM | OUT_FRC
     };
 
+    enum foutput_t
+    {
+        FOUT_IR,        // Index of the format for OUT_IR files
+        FOUT_RAW,       // Index of the format for OUT_RAW files
+        FOUT_AUDIO,     // Index of the format for OUT_AUDIO files
+        FOUT_FRM,       // Index of the format for OUT_FRM files
+        FOUT_FRC,       // Index of the format for OUT_FRC files
+
+        FOUT_TOTAL
+    };
+
     enum normalize_t
     {
         NORM_NONE,      // No normalization
@@ -50,12 +66,87 @@ namespace timbremill
         NORM_ALWAYS     // Always normalize
     };
 
+    enum phase_t
+    {
+        PHASE_LINEAR,   // Linear-phase impulse response
+        PHASE_MINIMUM   // Minimum-phase impulse response
+    };
+
+    enum convolver_t
+    {
+        CONV_REALTIME,  // Low-latency partitioned convolver designed for real-time processing
+        CONV_OFFLINE    // Uniformly-partitioned FFT convolver with large blocks for offline processing
+    };
+
+    enum encoding_t
+    {
+        ENC_PCM16,      // 16-bit signed integer PCM
+        ENC_PCM24,      // 24-bit signed integer PCM
+        ENC_PCM32,      // 32-bit signed integer PCM
+        ENC_FLOAT32     // 32-bit IEEE floating point
+    };
+
+    enum dither_t
+    {
+        DITHER_NONE,    // No dither
+        DITHER_TPDF,    // Triangular probability density function dither
+        DITHER_SHAPED   // TPDF dither with noise shaping
+    };
+
+    enum container_t
+    {
+        CONT_WAV,       // RIFF WAVE file
+        CONT_W64,       // Sony Wave64 file
+        CONT_RF64,      // RF64 file (WAVE file with 64-bit sizes)
+        CONT_FLAC,      // FLAC file
+        CONT_RAW        // Raw interleaved little-endian data without header
+    };
+
+    enum prof_encoding_t
+    {
+        PROF_FLOAT32,   // 32-bit IEEE floating point spectrum bins
+        PROF_FLOAT16    // 16-bit IEEE floating point spectrum bins
+    };
+
+    enum numa_t
+    {
+        NUMA_NONE,      // Default memory placement of the system
+        NUMA_INTERLEAVE,// Interleave memory pages between all NUMA nodes
+        NUMA_LOCAL      // Pin worker threads to NUMA nodes and place data at the node of the worker
+    };
+
+    enum progress_t
+    {
+        PROGRESS_NONE,  // Do not report the progress
+        PROGRESS_TTY,   // Compact status line updated in place on the terminal
+        PROGRESS_JSON   // Periodic JSON lines written to the status file descriptor
+    };
+
+    enum average_t
+    {
+        AVG_MEAN,       // Arithmetic mean of frame magnitudes
+        AVG_POWER,      // Power mean of frame magnitudes with the configured exponent
+        AVG_LOG,        // Mean of frame magnitudes in the logarithmic domain (geometric mean)
+        AVG_MEDIAN,     // Median of frame magnitudes
+        AVG_PERCENTILE  // Configured percentile of frame magnitudes
+    };
+
     typedef struct cfg_flag_t
     {
         const char     *name;
         ssize_t         value;
     } cfg_flag_t;
 
+    /**
+     * Format of the output file
+     */
+    typedef struct fformat_t
+    {
+        ssize_t                 nContainer;     // File container
+        ssize_t                 nEncoding;      // Sample encoding
+        ssize_t                 nDither;        // Dither for integer encodings
+    } fformat_t;
+
     /**
      * File group
      */
@@ -67,7 +158,12 @@ namespace timbremill
         public:
             LSPString               sName;
             LSPString               sMaster;
+            LSPString               sMasterProfile; // Profile of the master file, computed from the file if empty
             lltl::parray<LSPString> vFiles;
+            lltl::parray<LSPString> vProfiles;      // Profiles of the child files, computed from the file if empty
+            LSPString               sGlobBase;      // Directory the glob patterns are relative to, relative to the source path
+            LSPString               sMasterGlob;    // Glob pattern of the master file, resolved when the group is processed
+            LSPString               sGlob;          // Glob pattern of the child files, resolved when the group is processed
 
         public:
             explicit fgroup_t();
@@ -90,6 +186,9 @@ namespace timbremill
             float                   fTailCut;       // Tail cut (%)
             float                   fFadeIn;        // Head fade-out (%)
             float                   fFadeOut;       // Tail fade-out (%)
+            bool                    bAutoTrim;      // Automatic trimming based on energy
+            float                   fTrimEnergy;    // The amount of energy (dB) allowed to be trimmed
+            ssize_t                 nPhase;         // Phase of the impulse response
             LSPString               sFile;          // Format of IR file name with modifications
             LSPString               sRaw;           // Format of IR file name without modifications
             LSPString               sFRMaster;      // Format of IR file for the frquency response of the master
@@ -99,6 +198,24 @@ namespace timbremill
             explicit irfile_t();
     };
 
+    /**
+     * Discovery of file groups by the directory layout
+     */
+    struct discover_t
+    {
+        private:
+            discover_t & operator = (const discover_t &);
+
+        public:
+            bool                    bEnabled;       // Discovery is enabled
+            LSPString               sPath;          // Directory with one subdirectory per group, relative to the source path
+            LSPString               sMaster;        // Glob pattern of the master file in the group directory
+            LSPString               sFiles;         // Glob pattern of the child files in the group directory
+
+        public:
+            explicit discover_t();
+    };
+
     /**
      * Overall configuration
      */
@@ -113,9 +230,14 @@ namespace timbremill
             LSPString                               sFile;                  // Format of data output file name
             ssize_t                                 nSampleRate;            // Sample rate for output files
             ssize_t                                 nFftRank;               // FFT rank
+            ssize_t                                 nGrid;                  // Number of points of the logarithmic grid of profiles, 0 = linear grid
+            ssize_t                                 nAverage;               // Averaging method of frame magnitudes
+            float                                   fAvgPower;              // Exponent of the power mean
+            float                                   fPercentile;            // Percentile of frame magnitudes (0..100)
             ssize_t                                 nProduce;               // List of files to produce (flags)
             float                                   fGainRange;             // Gain range (in decibels)
             float                                   fTransition;            // Transition range in octaves
+            float                                   fSmoothing;             // Width of the fractional-octave smoothing in octaves, 0 = disabled
             float                                   fDry;                   // Amount of dry signal
             float                                   fWet;                   // Amount of wet signal
             bool                                    bMastering;             // 'Mastering' feature
@@ -123,8 +245,26 @@ namespace timbremill
             float                                   fNormGain;              // Normalization gain
             bool                                    bLatencyCompensation;   // Compensate latency for processed tracks
             bool                                    bMatchLength;           // Match the length of the output sample to the input sample
+            ssize_t                                 nConvolver;             // Convolution engine
+            ssize_t                                 nThreads;               // Number of worker threads, 0 = number of CPU cores
+            fformat_t                               vFormat[FOUT_TOTAL];    // Formats of output files
+            LSPString                               sPRMaster;              // Format of the profile file name for the master
+            LSPString                               sPRChild;               // Format of the profile file name for the child
+            ssize_t                                 nPREncoding;            // Encoding of the profile files
+            bool                                    bHugePages;             // Use huge pages for large buffers
+            ssize_t                                 nNuma;                  // NUMA memory placement policy
+            ssize_t                                 nProgress;              // Progress reporting mode
+            ssize_t                                 nStatusFd;              // File descriptor for progress reports
+            float                                   fProgressInterval;      // Interval between progress reports (seconds)
 
             irfile_t                                sIR;                    // IR file data
+            discover_t                              sDiscover;              // Discovery of file groups
+            LSPString                               sJobs;                  // File with groups in JSON-lines format
+            LSPString                               sPlan;                  // Plan the batch instead of processing, the output file or "-"
+            ssize_t                                 nShard;                 // Index of the shard to process starting with 1, 0 = no sharding
+            ssize_t                                 nShards;                // Overall number of shards
+            LSPString                               sManifest;              // Incremental manifest of processed work units
+            LSPString                               sTrace;                 // File to write the trace events at exit
             lltl::pphash<LSPString, fgroup_t>       vGroups;                // List of file groups
 
         public:
@@ -141,6 +281,15 @@ namespace timbremill
      */
     extern const cfg_flag_t     produce_flags[];
     extern const cfg_flag_t     normalize_flags[];
+    extern const cfg_flag_t     phase_flags[];
+    extern const cfg_flag_t     convolver_flags[];
+    extern const cfg_flag_t     encoding_flags[];
+    extern const cfg_flag_t     dither_flags[];
+    extern const cfg_flag_t     container_flags[];
+    extern const cfg_flag_t     prof_encoding_flags[];
+    extern const cfg_flag_t     numa_flags[];
+    extern const cfg_flag_t     progress_flags[];
+    extern const cfg_flag_t     average_flags[];
 
     /**
      * Find flag by given name
@@ -149,6 +298,16 @@ namespace timbremill
      * @return pointer to found flag descriptor or NULL
      */
     const cfg_flag_t           *find_config_flag(const LSPString *s, const cfg_flag_t *flags);
+
+    /**
+     * Parse the width of the fractional-octave smoothing set as the fraction "1/3 oct",
+     * the number of octaves "0.5 oct" (the "oct" unit is optional) or "none", the width
+     * should not exceed SMOOTHING_MAX octaves
+     * @param dst pointer to store the width in octaves, zero if the smoothing is disabled
+     * @param s the string to parse
+     * @return status of operation
+     */
+    status_t                    parse_smoothing(float *dst, const LSPString *s);
 }
 
 #endif /* PRIVATE_CONFIG_DATA_H_ */
@@ -38,6 +38,16 @@ namespace timbremill
      */
     status_t parse_json_config(config_t *cfg, io::IInSequence *is);
 
+    /**
+     * Parse the single job: the JSON object with the description of the group
+     * and the 'name' property which contains the name of the group
+     *
+     * @param grp the group to fill
+     * @param is input stream
+     * @return status of operation
+     */
+    status_t parse_json_job(fgroup_t *grp, io::IInSequence *is);
+
 }
 
 #endif /* PRIVATE_CONFIG_JSON_H_ */
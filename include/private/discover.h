@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_DISCOVER_H_
+#define PRIVATE_DISCOVER_H_
+
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <lsp-plug.in/lltl/parray.h>
+#include <private/config/config.h>
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * Match the path against the glob pattern. The '*' matches any sequence of characters
+     * within the path element, the '?' matches any single character within the path element,
+     * the '**' matches any number of path elements including none of them.
+     *
+     * @param pattern the glob pattern
+     * @param path the path with elements separated by '/'
+     * @return true if the path matches the pattern
+     */
+    bool glob_match(const LSPString *pattern, const LSPString *path);
+
+    /**
+     * Delete all strings of the list and flush the list
+     *
+     * @param list the list of strings, may contain NULL elements
+     */
+    void drop_strings(lltl::parray<LSPString> *list);
+
+    /**
+     * Find all files matching the glob pattern. The subdirectories of the first level
+     * are scanned in parallel, the literal leading path elements of the pattern are not
+     * scanned at all.
+     *
+     * @param files the list to append the file names to, the names are relative to
+     *   the root directory and sorted, the caller is responsible for deleting them
+     * @param root the root directory
+     * @param base the directory the pattern is relative to, relative to the root directory, may be NULL
+     * @param pattern the glob pattern
+     * @param threads maximum number of threads to use
+     * @return status of operation
+     */
+    status_t glob_files(
+        lltl::parray<LSPString> *files,
+        const LSPString *root, const LSPString *base, const LSPString *pattern,
+        size_t threads);
+
+    /**
+     * Create file groups for all subdirectories matched by the discovery rule of
+     * the configuration. Only the directory with the groups is listed, the files
+     * of each group are resolved later by resolve_group_files(). Groups which are
+     * explicitly specified by the configuration are not overridden.
+     *
+     * @param cfg the configuration
+     * @return status of operation
+     */
+    status_t discover_groups(config_t *cfg);
+
+    /**
+     * Resolve the glob patterns of the file group into the master file and the list of child files
+     *
+     * @param cfg the configuration
+     * @param fg the file group
+     * @param threads maximum number of threads to use
+     * @return status of operation
+     */
+    status_t resolve_group_files(const config_t *cfg, fgroup_t *fg, size_t threads);
+
+    /**
+     * Release the list of child files which was resolved from the glob pattern
+     *
+     * @param fg the file group
+     */
+    void release_group_files(fgroup_t *fg);
+}
+
+#endif /* PRIVATE_DISCOVER_H_ */
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_FFTCONV_H_
+#define PRIVATE_FFTCONV_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/dsp-units/sampling/Sample.h>
+
+#include <private/arena.h>
+
+#define FFT_CONV_MIN_RANK           8
+#define FFT_CONV_MAX_RANK           16
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * The spectrum of the impulse response prepared for the offline uniformly-partitioned
+     * FFT convolution. The impulse response is split into partitions of the half of the
+     * FFT size, each partition is zero-padded and transformed to the frequency domain once.
+     * The spectrum is immutable after creation and can be shared between threads and
+     * multiple renders, the lifetime is controlled by the reference counter.
+     */
+    typedef struct ir_spectrum_t
+    {
+        size_t          nRank;          // FFT rank
+        size_t          nPartSize;      // Size of the partition (half of the FFT size)
+        size_t          nParts;         // Number of partitions per channel
+        size_t          nChannels;      // Number of channels
+        size_t          nLength;        // Length of the impulse response
+        float          *vSpectrum;      // Packed complex spectra of partitions for all channels
+        uint8_t        *pData;          // Allocated data
+        int             nReferences;    // Number of references
+    } ir_spectrum_t;
+
+    /**
+     * Estimate the FFT rank which gives the lowest computational cost of the offline
+     * convolution for the specified lengths of the signal and the impulse response
+     *
+     * @param length the length of the signal
+     * @param ir_length the length of the impulse response
+     * @return the FFT rank in range of FFT_CONV_MIN_RANK to FFT_CONV_MAX_RANK
+     */
+    size_t fft_convolution_rank(size_t length, size_t ir_length);
+
+    /**
+     * Estimate the number of floating-point operations of the offline convolution
+     * of one channel for the specified FFT rank
+     *
+     * @param length the length of the signal
+     * @param ir_length the length of the impulse response
+     * @param rank the FFT rank
+     * @return the estimated number of floating-point operations
+     */
+    double fft_convolution_cost(size_t length, size_t ir_length, size_t rank);
+
+    /**
+     * Create the spectrum of the impulse response: compute the spectra of all partitions
+     * of the impulse response. The created spectrum has one reference.
+     *
+     * @param ir impulse response
+     * @param rank the FFT rank
+     * @return pointer to the spectrum or NULL if there is not enough memory
+     */
+    ir_spectrum_t *create_ir_spectrum(const dspu::Sample *ir, size_t rank);
+
+    /**
+     * Acquire the reference to the spectrum of the impulse response
+     *
+     * @param spc the spectrum of the impulse response
+     * @return the pointer to the spectrum
+     */
+    ir_spectrum_t *acquire_ir_spectrum(ir_spectrum_t *spc);
+
+    /**
+     * Release the reference to the spectrum of the impulse response, the spectrum
+     * is destroyed when the last reference is released
+     *
+     * @param spc the spectrum of the impulse response, may be NULL
+     */
+    void release_ir_spectrum(ir_spectrum_t *spc);
+
+    /**
+     * Perform the offline convolution of the signal with the channel of the impulse response
+     *
+     * @param dst destination buffer to store length + spc->nLength samples of the convolution
+     * @param src the source signal
+     * @param length the length of the source signal
+     * @param spc the spectrum of the impulse response
+     * @param channel the channel of the impulse response to use
+     * @param arena the arena to borrow the temporary buffers from, NULL for private temporary buffers
+     * @return status of operation
+     */
+    status_t fft_convolve(float *dst, const float *src, size_t length, const ir_spectrum_t *spc, size_t channel, arena_t *arena);
+}
+
+#endif /* PRIVATE_FFTCONV_H_ */
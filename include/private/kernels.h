@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_KERNELS_H_
+#define PRIVATE_KERNELS_H_
+
+#include <lsp-plug.in/common/types.h>
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /*
+     * The kernels below are not provided by lsp-dsp-lib. They are written as
+     * branchless loops over contiguous data so the compiler is able to vectorize them.
+     */
+
+    /**
+     * Compute the reciprocal of the values limited from below by the floor:
+     * dst[i] = 1 / max(src[i], floor)
+     *
+     * @param dst destination buffer
+     * @param src source buffer
+     * @param floor the floor value, should be positive
+     * @param count number of elements to process
+     */
+    void rcp_floor2(float *dst, const float *src, float floor, size_t count);
+
+    /**
+     * Multiply values and limit the result:
+     * dst[i] = limit(a[i] * b[i], min, max)
+     *
+     * @param dst destination buffer
+     * @param a first source buffer
+     * @param b second source buffer
+     * @param min the minimum allowed value
+     * @param max the maximum allowed value
+     * @param count number of elements to process
+     */
+    void mul_limit3(float *dst, const float *a, const float *b, float min, float max, size_t count);
+
+    /**
+     * Divide values with the divisor limited from below by the floor and limit the result:
+     * dst[i] = limit(a[i] / max(b[i], floor), min, max)
+     *
+     * @param dst destination buffer
+     * @param a the dividend buffer
+     * @param b the divisor buffer
+     * @param floor the floor value of the divisor, should be positive
+     * @param min the minimum allowed value
+     * @param max the maximum allowed value
+     * @param count number of elements to process
+     */
+    void div_limit3(float *dst, const float *a, const float *b, float floor, float min, float max, size_t count);
+
+    /**
+     * Multiply packed complex numbers and add the product to the destination:
+     * dst[i] = dst[i] + a[i] * b[i]
+     *
+     * @param dst destination buffer of packed complex numbers
+     * @param a first source buffer of packed complex numbers
+     * @param b second source buffer of packed complex numbers
+     * @param count number of complex numbers to process
+     */
+    void pcomplex_fmadd3(float *dst, const float *a, const float *b, size_t count);
+
+    /**
+     * Smooth the magnitude spectrum with the fractional-octave rectangular window: each
+     * element k > 0 becomes the mean of elements in the range [k / 2^(width/2), k * 2^(width/2)]
+     * rounded to the nearest elements, the element 0 (DC) is copied as is. Both bounds of the
+     * window only move forward, so the window sum is updated incrementally and the cost does
+     * not depend on the width. The source and destination buffers should not overlap.
+     *
+     * @param dst destination buffer
+     * @param src source buffer
+     * @param width the width of the window in octaves
+     * @param count number of elements to process
+     */
+    void octave_smooth2(float *dst, const float *src, float width, size_t count);
+
+    /**
+     * Smooth the spectrum on the logarithmic frequency grid with the fractional-octave rectangular
+     * window. Each point j > 0 becomes the mean of points with centers in the range
+     * [c[j] / 2^(width/2), c[j] * 2^(width/2)] weighted by the number of bins in bands, where
+     * c[j] = (edges[j] + edges[j+1] - 1) / 2 is the center of the band. The point 0 is copied as is.
+     * The source and destination buffers should not overlap.
+     *
+     * @param dst destination buffer of points elements
+     * @param src source buffer of points elements
+     * @param edges array of points+1 increasing bin indices, the band j covers bins [edges[j], edges[j+1])
+     * @param width the width of the window in octaves
+     * @param points number of points of the grid
+     */
+    void octave_smooth_grid2(float *dst, const float *src, const size_t *edges, float width, size_t points);
+
+    /**
+     * Aggregate the spectrum into the bands of the grid:
+     * dst[j] = mean(src[edges[j]] .. src[edges[j+1]-1]).
+     * The destination buffer may be the same as the source buffer.
+     *
+     * @param dst destination buffer of points elements
+     * @param src source buffer of edges[points] elements
+     * @param edges array of points+1 increasing bin indices, the band j covers bins [edges[j], edges[j+1])
+     * @param points number of points of the grid
+     */
+    void band_mean2(float *dst, const float *src, const size_t *edges, size_t points);
+
+    /**
+     * Expand the spectrum from the grid back to bins by the linear interpolation between the centers of bands,
+     * bins outside of the first and the last centers take the value of the nearest point.
+     * The source and destination buffers should not overlap.
+     *
+     * @param dst destination buffer of edges[points] elements
+     * @param src source buffer of points elements
+     * @param edges array of points+1 increasing bin indices, the band j covers bins [edges[j], edges[j+1])
+     * @param points number of points of the grid
+     */
+    void grid_expand2(float *dst, const float *src, const size_t *edges, size_t points);
+
+    /**
+     * Count values in the histograms of elements. The histograms are stored as rows of buckets,
+     * hist[b*count + i] is the counter of the bucket b of the element i. The bucket of the value is:
+     * b = limit(floor((src[i] - base) * scale), 0, buckets - 1)
+     *
+     * @param hist histograms of buckets*count counters
+     * @param src source buffer
+     * @param base the lower bound of the first bucket
+     * @param scale number of buckets per unit of the value
+     * @param buckets number of buckets in each histogram
+     * @param count number of elements to process
+     */
+    void histogram_add(float *hist, const float *src, float base, float scale, size_t buckets, size_t count);
+
+    /**
+     * Find the quantile of each element in the histograms filled by histogram_add(). The result
+     * is the position of the quantile in buckets linearly interpolated within the bucket:
+     * dst[i] = b + (rank - sum(hist[0..b-1][i])) / hist[b][i], where b is the first bucket
+     * having the cumulative count above the rank
+     *
+     * @param dst destination buffer
+     * @param cum temporary buffer of count elements for cumulative counts
+     * @param hist histograms of buckets*count counters
+     * @param rank the rank of the quantile: the quantile multiplied by the number of counted values,
+     *   should be less than the number of counted values, otherwise the quantile is not found
+     * @param buckets number of buckets in each histogram
+     * @param count number of elements to process
+     */
+    void histogram_quantile(float *dst, float *cum, const float *hist, float rank, size_t buckets, size_t count);
+}
+
+#endif /* PRIVATE_KERNELS_H_ */
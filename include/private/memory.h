@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_MEMORY_H_
+#define PRIVATE_MEMORY_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+
+#define HUGE_PAGE_SIZE              0x200000    // The size of huge page, 2 MiB
+#define HUGE_PAGE_THRESHOLD         0x100000    // Minimum size of the buffer to use huge pages, 1 MiB
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * Set the memory policy for the whole process. Should be called before any worker thread
+     * is started. The NUMA interleave policy is applied to all further allocations of the
+     * process, the NUMA local policy pins worker threads to NUMA nodes and moves the output
+     * data to the node of the worker which produces it. Policies which are not supported by
+     * the system are silently ignored.
+     *
+     * @param huge_pages use huge pages for large buffers
+     * @param numa NUMA memory placement policy, see numa_t
+     * @return status of operation
+     */
+    status_t set_memory_policy(bool huge_pages, ssize_t numa);
+
+    /**
+     * Get the alignment of the buffer of the specified size according to the memory policy
+     *
+     * @param bytes the size of the buffer in bytes
+     * @param align the minimum alignment
+     * @return the alignment of the buffer, huge page size for large buffers if huge pages are enabled
+     */
+    size_t memory_alignment(size_t bytes, size_t align);
+
+    /**
+     * Advise the system to back the memory range by huge pages if huge pages are enabled.
+     * Only the part of the range aligned to the huge page boundaries is affected.
+     *
+     * @param ptr pointer to the beginning of the range
+     * @param bytes the size of the range in bytes
+     */
+    void advise_memory(void *ptr, size_t bytes);
+
+    /**
+     * Move the memory range to the NUMA node of the calling thread if the NUMA local
+     * policy is set. Only the part of the range aligned to the page boundaries is affected.
+     *
+     * @param ptr pointer to the beginning of the range
+     * @param bytes the size of the range in bytes
+     */
+    void localize_memory(void *ptr, size_t bytes);
+
+    /**
+     * Pin the calling thread to the CPUs of the NUMA node assigned to the worker if the
+     * NUMA local policy is set. Workers are distributed between nodes in round-robin order.
+     *
+     * @param worker the index of the worker
+     */
+    void pin_worker(size_t worker);
+
+    /**
+     * Restore the CPU affinity of the calling thread after pin_worker()
+     */
+    void unpin_worker();
+}
+
+#endif /* PRIVATE_MEMORY_H_ */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_NAMING_H_
+#define PRIVATE_NAMING_H_
+
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <lsp-plug.in/expr/Expression.h>
+#include <lsp-plug.in/expr/Resolver.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/lltl/parray.h>
+#include <lsp-plug.in/lltl/pphash.h>
+#include <lsp-plug.in/lltl/phashset.h>
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * The naming context of output files: the base directory, the templates of file names
+     * compiled once per run and the set of parent directories which are already created
+     */
+    struct naming_t
+    {
+        private:
+            naming_t & operator = (const naming_t &);
+
+        public:
+            LSPString                                   sBase;          // Base directory of relative file names
+            lltl::pphash<LSPString, expr::Expression>   vTemplates;     // Compiled templates, the key is the text of the template
+            lltl::phashset<LSPString>                   vDirs;          // Directories which are already created
+            lltl::parray<LSPString>                    *pOutputs;       // The list to record the written output files, may be NULL
+
+        public:
+            explicit naming_t();
+            ~naming_t();
+
+        public:
+            void clear();
+    };
+
+    /**
+     * Compile the template of the output file name if it is not compiled yet
+     *
+     * @param naming the naming context
+     * @param fmt the template of the output file name
+     * @param x pointer to store the compiled template, may be NULL
+     * @return status of operation
+     */
+    status_t compile_file_name(naming_t *naming, const LSPString *fmt, expr::Expression **x);
+
+    /**
+     * Compute the path of the output file without touching the file system
+     *
+     * @param path the path to store the result
+     * @param naming the naming context
+     * @param fmt the template of the output file name
+     * @param vars variables to parametrize the template
+     * @return status of operation
+     */
+    status_t output_file_name(io::Path *path, naming_t *naming, const LSPString *fmt, expr::Resolver *vars);
+
+    /**
+     * Compute the path of the output file and create its parent directory if it was not
+     * created before, record the path to the list of written output files if it is set
+     *
+     * @param path the path to store the result
+     * @param naming the naming context
+     * @param fmt the template of the output file name
+     * @param vars variables to parametrize the template
+     * @return status of operation
+     */
+    status_t output_file_path(io::Path *path, naming_t *naming, const LSPString *fmt, expr::Resolver *vars);
+}
+
+#endif /* PRIVATE_NAMING_H_ */
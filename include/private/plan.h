@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_PLAN_H_
+#define PRIVATE_PLAN_H_
+
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <private/config/config.h>
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * Write the string to the file as a quoted JSON string
+     *
+     * @param out the output file
+     * @param s the UTF-8 string to write
+     */
+    void write_json_string(FILE *out, const char *s);
+
+    /**
+     * Estimate the number of floating-point operations required for processing the group
+     * by reading only the headers of input files, the issues are not reported
+     *
+     * @param master_cost pointer to store the cost of the analysis of the master file
+     * @param costs array to store the cost of each child file, should contain at least
+     *   as many elements as the number of child files in the group
+     * @param cfg the configuration
+     * @param fg the file group with resolved child files
+     * @return status of operation
+     */
+    status_t estimate_group_cost(double *master_cost, double *costs, config_t *cfg, fgroup_t *fg);
+
+    /**
+     * Plan the batch without processing: read only the headers of input files, resolve the
+     * names of output files, detect missing files, channel mismatches and duplicate outputs,
+     * estimate the number of floating-point operations and the peak memory of each task.
+     * The plan is written in JSON format to the file specified by the configuration.
+     *
+     * @param cfg the configuration
+     * @return status of operation, STATUS_BAD_STATE if the batch has issues
+     */
+    status_t plan_file_groups(config_t *cfg);
+}
+
+#endif /* PRIVATE_PLAN_H_ */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_PROFILE_H_
+#define PRIVATE_PROFILE_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/dsp-units/sampling/Sample.h>
+#include <lsp-plug.in/io/Path.h>
+
+#define PROFILE_VERSION         1
+#define PROFILE_WINDOW_BN       0       /* Blackman-Nuttall window */
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * The description of the spectral profile stored in the profile file
+     */
+    typedef struct profile_info_t
+    {
+        size_t          nRank;          // The FFT rank used for the analysis
+        size_t          nSampleRate;    // The sample rate of the analyzed data
+        size_t          nSourceRate;    // The original sample rate of the source file
+        size_t          nWindow;        // The window function used for the analysis
+        wsize_t         nFrames;        // The number of averaged FFT frames
+        ssize_t         nAverage;       // The averaging method of frame magnitudes, see average_t
+        float           fAvgParam;      // The parameter of the averaging method
+    } profile_info_t;
+
+    /**
+     * Write the spectral profile to the binary profile file. The file consists of the 64-byte
+     * header followed by the half-spectrum (1 << rank)/2 + 1 bins or by the points of the logarithmic
+     * grid of each channel, each channel starts at the 64-byte boundary so the file can be memory-mapped
+     * and used as-is.
+     *
+     * @param path path to the output file
+     * @param profile the spectral profile
+     * @param info the profile description
+     * @param encoding the encoding of the spectrum bins, see prof_encoding_t
+     * @return status of operation
+     */
+    status_t write_profile(const io::Path *path, const dspu::Sample *profile, const profile_info_t *info, ssize_t encoding);
+
+    /**
+     * Read the spectral profile from the binary profile file. The profile contains
+     * (1 << rank)/2 + 1 bins of the half-spectrum or less points of the logarithmic grid.
+     *
+     * @param profile the spectral profile to store the data
+     * @param info the profile description to store the data
+     * @param path path to the input file
+     * @return status of operation
+     */
+    status_t read_profile(dspu::Sample *profile, profile_info_t *info, const io::Path *path);
+}
+
+#endif /* PRIVATE_PROFILE_H_ */
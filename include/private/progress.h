@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_PROGRESS_H_
+#define PRIVATE_PROGRESS_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <private/config/config.h>
+
+#define PROGRESS_SLOT_SIZE          64      // The size of the counters of the worker, the size of the cache line
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    enum progress_stage_t
+    {
+        PSTAGE_IDLE,        // The worker does not process anything
+        PSTAGE_LOAD,        // Loading and resampling of the audio file
+        PSTAGE_ANALYSIS,    // Computing of the spectral profile
+        PSTAGE_IR,          // Computing of the impulse responses
+        PSTAGE_RENDER,      // Convolution of the audio data
+        PSTAGE_SAVE,        // Saving of the output file
+
+        PSTAGE_TOTAL
+    };
+
+    /**
+     * The counters of the worker. Each worker updates only it's own counters which
+     * occupy the whole cache line, so the hot loops do not need any synchronization
+     */
+    typedef struct progress_slot_t
+    {
+        volatile wsize_t        nSamples;   // Number of processed samples
+        volatile ssize_t        nStage;     // Current stage of the worker
+        uint8_t                 vPad[PROGRESS_SLOT_SIZE - sizeof(wsize_t) - sizeof(ssize_t)];
+    } progress_slot_t;
+
+    /**
+     * Start the progress reporting in the mode specified by the configuration, the reports
+     * are emitted by the background thread
+     *
+     * @param cfg the configuration
+     * @param workers the number of worker threads
+     * @return status of operation
+     */
+    status_t start_progress(const config_t *cfg, size_t workers);
+
+    /**
+     * Emit the final report and stop the progress reporting
+     */
+    void stop_progress();
+
+    /**
+     * Get the counters of the worker
+     *
+     * @param worker the index of the worker, the calling thread of run_parallel() is the worker 0
+     * @return the counters of the worker or NULL if the progress is not reported
+     */
+    progress_slot_t *progress_worker(size_t worker);
+
+    /**
+     * Add the number of work units to process
+     *
+     * @param count the number of work units
+     */
+    void progress_units(size_t count);
+
+    /**
+     * Begin processing of the work unit
+     *
+     * @param name the name of the group
+     * @param expected the expected number of samples to process
+     */
+    void progress_begin_unit(const LSPString *name, wsize_t expected);
+
+    /**
+     * End processing of the work unit, the expected number of samples is replaced
+     * by the actual number of processed samples
+     */
+    void progress_end_unit();
+
+    /**
+     * Account the audio data which has been completely processed
+     *
+     * @param frames the number of frames at the output sample rate
+     */
+    void progress_audio(wsize_t frames);
+
+    /**
+     * Account the processed samples
+     *
+     * @param slot the counters of the worker, may be NULL
+     * @param samples the number of processed samples
+     */
+    inline void progress_add(progress_slot_t *slot, size_t samples)
+    {
+        if (slot != NULL)
+            slot->nSamples      = slot->nSamples + samples;
+    }
+
+    /**
+     * Set the current stage of the worker
+     *
+     * @param slot the counters of the worker, may be NULL
+     * @param stage the stage, see progress_stage_t
+     */
+    inline void progress_stage(progress_slot_t *slot, ssize_t stage)
+    {
+        if (slot != NULL)
+            slot->nStage        = stage;
+    }
+}
+
+#endif /* PRIVATE_PROGRESS_H_ */
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_SHARD_H_
+#define PRIVATE_SHARD_H_
+
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+#include <lsp-plug.in/lltl/darray.h>
+#include <lsp-plug.in/lltl/parray.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <private/config/config.h>
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * The work unit: the whole file group or the contiguous range of it's child files
+     */
+    typedef struct work_unit_t
+    {
+        fgroup_t               *pGroup;     // The file group
+        size_t                  nFirst;     // Index of the first child file
+        size_t                  nCount;     // Number of child files
+        double                  fMaster;    // Estimated cost of the analysis of the master file
+        double                  fCost;      // Estimated cost of the child files
+        size_t                  nShard;     // Index of the shard the unit is assigned to, starting with 0
+    } work_unit_t;
+
+    /**
+     * The incremental manifest of the processed work units
+     */
+    typedef struct manifest_t
+    {
+        FILE                   *pOut;       // Output file, NULL if the manifest is not written
+        size_t                  nShard;     // Index of the shard, starting with 1, 0 if not sharded
+        size_t                  nShards;    // Overall number of shards
+        size_t                  nUnits;     // Number of processed work units
+        size_t                  nFiles;     // Number of processed child files
+        size_t                  nOutputs;   // Number of written output files
+        double                  fCost;      // Estimated cost of processed work units
+        wsize_t                 nStart;     // The time of the start of processing (milliseconds)
+    } manifest_t;
+
+    /**
+     * Estimate the cost of the file group and add one work unit per each child file
+     * of the group, or a single empty work unit if the group has no child files
+     *
+     * @param units the list of work units to append
+     * @param cfg the configuration
+     * @param fg the file group with resolved child files
+     * @return status of operation
+     */
+    status_t estimate_work_units(lltl::darray<work_unit_t> *units, config_t *cfg, fgroup_t *fg);
+
+    /**
+     * Partition the work units between shards. The adjacent units of the same group are
+     * merged, so the profile of the master file is computed once. The group is split into
+     * contiguous ranges of child files only if it's cost exceeds the fair share of the shard.
+     * The units are assigned to the least loaded shard starting with the most expensive one,
+     * so the result depends only on the input and is the same for all shards.
+     *
+     * @param dst the list to store the merged work units with the assigned shard
+     * @param src the list of work units produced by estimate_work_units()
+     * @param shards the overall number of shards
+     * @return status of operation
+     */
+    status_t partition_work_units(lltl::darray<work_unit_t> *dst, lltl::darray<work_unit_t> *src, size_t shards);
+
+    /**
+     * Open the manifest file specified by the configuration for appending
+     *
+     * @param m the manifest
+     * @param cfg the configuration
+     * @return status of operation
+     */
+    status_t open_manifest(manifest_t *m, const config_t *cfg);
+
+    /**
+     * Record the processed work unit to the manifest, the record is flushed immediately
+     *
+     * @param m the manifest
+     * @param unit the processed work unit
+     * @param outputs the list of output files written while processing the unit, it is cleared
+     * @param res the result of processing
+     * @param millis the time spent for processing (milliseconds)
+     */
+    void record_work_unit(manifest_t *m, const work_unit_t *unit,
+        lltl::parray<LSPString> *outputs, status_t res, wsize_t millis);
+
+    /**
+     * Write the summary of the shard to the manifest and to the standard output,
+     * close the manifest file
+     *
+     * @param m the manifest
+     * @param res the overall result of processing
+     */
+    void close_manifest(manifest_t *m, status_t res);
+}
+
+#endif /* PRIVATE_SHARD_H_ */
@@ -26,13 +26,21 @@
 #include <lsp-plug.in/runtime/LSPString.h>
 #include <lsp-plug.in/expr/Variables.h>
 
+#include <private/arena.h>
 #include <private/config/config.h>
+#include <private/naming.h>
+
+#define FFT_MIN         8
+#define FFT_MAX         16
+#define IR_BATCH        16
 
 namespace timbremill
 {
-    status_t build_variables(expr::Variables *vars, config_t *cfg, fgroup_t *fg, LSPString *master, LSPString *child);
+    status_t build_group_variables(expr::Variables *vars, config_t *cfg, fgroup_t *fg);
+
+    status_t build_variables(expr::Variables *vars, LSPString *child);
 
-    status_t process_file_group(config_t *cfg, fgroup_t *fg);
+    status_t process_file_group(config_t *cfg, fgroup_t *fg, arena_t *arenas, naming_t *naming);
 
     status_t process_file_groups(config_t *cfg);
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_TRACE_H_
+#define PRIVATE_TRACE_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/runtime/LSPString.h>
+
+// The tracing is compiled only into the builds with additional trace information (TRACE=1),
+// otherwise the trace macros expand to nothing
+#ifdef LSP_TRACE
+    #define TIMBREMILL_TRACING
+#endif /* LSP_TRACE */
+
+#define TRACE_RING_SIZE         0x10000     // Number of events kept for each thread
+#define TRACE_MAX_THREADS       256         // Maximum number of traced threads
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * Start recording of trace events
+     *
+     * @param path the name of the file to write the events at exit, empty if tracing is disabled
+     * @return status of operation
+     */
+    status_t start_trace(const LSPString *path);
+
+    /**
+     * Write the recorded events in Chrome trace event format and stop recording. Should be
+     * called when all traced threads are finished.
+     *
+     * @return status of operation
+     */
+    status_t flush_trace();
+
+#ifdef TIMBREMILL_TRACING
+    /**
+     * Record the trace event to the ring buffer of the calling thread
+     *
+     * @param name the static name of the event
+     * @param arg the argument of the event, negative if not set
+     * @param phase the phase of the event: 'B' for begin, 'E' for end
+     */
+    void trace_event(const char *name, ssize_t arg, char phase);
+
+    /**
+     * Records the begin event when created and the end event when leaves the scope
+     */
+    struct trace_scope_t
+    {
+        private:
+            trace_scope_t & operator = (const trace_scope_t &);
+
+        private:
+            const char     *sName;
+            ssize_t         nArg;
+
+        public:
+            inline explicit trace_scope_t(const char *name, ssize_t arg)
+            {
+                sName       = name;
+                nArg        = arg;
+                trace_event(name, arg, 'B');
+            }
+
+            inline ~trace_scope_t()
+            {
+                trace_event(sName, nArg, 'E');
+            }
+    };
+
+    #define TRACE_JOIN_NAME(a, b)       a ## b
+    #define TRACE_SCOPE_NAME(line)      TRACE_JOIN_NAME(trace_scope_, line)
+    #define TRACE_SCOPE(name)           timbremill::trace_scope_t TRACE_SCOPE_NAME(__LINE__)(name, -1)
+    #define TRACE_SCOPE_ARG(name, arg)  timbremill::trace_scope_t TRACE_SCOPE_NAME(__LINE__)(name, arg)
+#else
+    #define TRACE_SCOPE(name)
+    #define TRACE_SCOPE_ARG(name, arg)
+#endif /* TIMBREMILL_TRACING */
+}
+
+#endif /* PRIVATE_TRACE_H_ */
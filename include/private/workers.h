@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_WORKERS_H_
+#define PRIVATE_WORKERS_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * Parallel task
+     *
+     * @param arg the argument passed to run_parallel()
+     * @param index index of the task
+     * @param worker index of the thread executing the task, from 0 to the number of threads,
+     *   the calling thread has index 0
+     * @return status of operation
+     */
+    typedef status_t (* parallel_task_t)(void *arg, size_t index, size_t worker);
+
+    /**
+     * Get the actual number of worker threads
+     *
+     * @param threads the number of threads specified by the configuration,
+     *   zero or negative value means the number of CPU cores in the system
+     * @return the actual number of threads, at least 1
+     */
+    size_t worker_threads(ssize_t threads);
+
+    /**
+     * Execute the set of independent tasks in parallel. Tasks are dispatched to
+     * the threads in the order of their indices, the calling thread also executes
+     * tasks and the function returns when all tasks are complete. After the first
+     * failed task the remaining tasks are not started.
+     *
+     * @param task the task to execute
+     * @param arg the argument to pass to the task
+     * @param count number of tasks
+     * @param threads maximum number of threads, including the calling one
+     * @return status of operation, the status of the first failed task
+     */
+    status_t run_parallel(parallel_task_t task, void *arg, size_t count, size_t threads);
+}
+
+#endif /* PRIVATE_WORKERS_H_ */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRIVATE_WRITER_H_
+#define PRIVATE_WRITER_H_
+
+#include <lsp-plug.in/common/types.h>
+#include <lsp-plug.in/common/status.h>
+#include <lsp-plug.in/dsp-units/sampling/Sample.h>
+#include <lsp-plug.in/io/Path.h>
+#include <private/config/data.h>
+
+namespace timbremill
+{
+    using namespace lsp;
+
+    /**
+     * Write the audio sample to the file of the specified format. The gain, the dither and
+     * the conversion to the output encoding are applied in one pass while interleaving the
+     * channels into the output buffer, the source sample is not modified.
+     *
+     * The uncompressed containers (WAV, W64, RF64 and raw data) are written by the native
+     * writer with large aligned blocks, the FLAC container is written with libsndfile
+     * if it is available.
+     *
+     * @param path path to the output file
+     * @param sample sample to write
+     * @param format the format of the output file
+     * @param gain the gain to apply to the sample data
+     * @return status of operation
+     */
+    status_t write_audio_file(const io::Path *path, const dspu::Sample *sample, const fformat_t *format, float gain);
+}
+
+#endif /* PRIVATE_WRITER_H_ */
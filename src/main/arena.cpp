@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/alloc.h>
+#include <private/arena.h>
+#include <private/memory.h>
+
+namespace timbremill
+{
+    static inline size_t align_samples(size_t count, size_t align)
+    {
+        return (count + align - 1) & ~(align - 1);
+    }
+
+    static void destroy_block(arena_block_t *block)
+    {
+        if (block == NULL)
+            return;
+        free_aligned(block->pData);
+        delete block;
+    }
+
+    static void destroy_blocks(lltl::parray<arena_block_t> *list)
+    {
+        for (size_t i=0, n=list->size(); i<n; ++i)
+            destroy_block(list->uget(i));
+        list->flush();
+    }
+
+    arena_t::arena_t()
+    {
+        nBorrowed       = 0;
+        nPeak           = 0;
+        nReserved       = 0;
+        nAllocations    = 0;
+    }
+
+    arena_t::~arena_t()
+    {
+        clear();
+    }
+
+    void arena_t::clear()
+    {
+        destroy_blocks(&vFree);
+        destroy_blocks(&vBusy);
+        nBorrowed       = 0;
+        nReserved       = 0;
+    }
+
+    float *arena_borrow(arena_t *arena, size_t count)
+    {
+        // Find the best fitting free block and the largest block which is too small
+        ssize_t best    = -1, small = -1;
+        for (size_t i=0, n=arena->vFree.size(); i<n; ++i)
+        {
+            arena_block_t *b    = arena->vFree.uget(i);
+            if (b->nCapacity >= count)
+            {
+                if ((best < 0) || (b->nCapacity < arena->vFree.uget(best)->nCapacity))
+                    best                = i;
+            }
+            else if ((small < 0) || (b->nCapacity > arena->vFree.uget(small)->nCapacity))
+                small               = i;
+        }
+
+        arena_block_t *block = NULL;
+        if (best >= 0)
+        {
+            block           = arena->vFree.uget(best);
+            arena->vFree.remove(best);
+        }
+        else
+        {
+            // The data of the block which is too small for the request is not reused
+            // anymore, drop it to keep the amount of reserved memory bounded
+            if (small >= 0)
+            {
+                block           = arena->vFree.uget(small);
+                arena->vFree.remove(small);
+                arena->nReserved   -= block->nCapacity * sizeof(float);
+                destroy_block(block);
+            }
+
+            // Allocate new block, large blocks are aligned to huge pages if enabled
+            size_t capacity = align_samples(lsp_max(count, size_t(1)), ARENA_GRANULARITY);
+            size_t align    = memory_alignment(capacity * sizeof(float), ARENA_ALIGN);
+            capacity        = align_samples(capacity, align / sizeof(float));
+
+            block           = new arena_block_t;
+            if (block == NULL)
+                return NULL;
+            block->pData    = NULL;
+            block->nCapacity= capacity;
+            block->vData    = alloc_aligned<float>(block->pData, capacity, align);
+            if (block->vData == NULL)
+            {
+                delete block;
+                return NULL;
+            }
+            advise_memory(block->vData, capacity * sizeof(float));
+
+            arena->nReserved   += block->nCapacity * sizeof(float);
+            ++arena->nAllocations;
+        }
+
+        if (!arena->vBusy.add(block))
+        {
+            arena->nReserved   -= block->nCapacity * sizeof(float);
+            destroy_block(block);
+            return NULL;
+        }
+
+        // Update statistics
+        arena->nBorrowed   += block->nCapacity * sizeof(float);
+        arena->nPeak        = lsp_max(arena->nPeak, arena->nBorrowed);
+
+        return block->vData;
+    }
+
+    float *arena_borrow_planar(arena_t *arena, float **dst, size_t channels, size_t length)
+    {
+        size_t stride   = align_samples(length, ARENA_ALIGN / sizeof(float));
+        float *buf      = arena_borrow(arena, stride * channels);
+        if (buf == NULL)
+            return NULL;
+
+        for (size_t i=0; i<channels; ++i)
+            dst[i]          = &buf[i * stride];
+
+        return buf;
+    }
+
+    void arena_return(arena_t *arena, float *buf)
+    {
+        if (buf == NULL)
+            return;
+
+        for (size_t i=0, n=arena->vBusy.size(); i<n; ++i)
+        {
+            arena_block_t *b    = arena->vBusy.uget(i);
+            if (b->vData != buf)
+                continue;
+
+            arena->vBusy.remove(i);
+            arena->nBorrowed   -= b->nCapacity * sizeof(float);
+            if (!arena->vFree.add(b))
+            {
+                arena->nReserved   -= b->nCapacity * sizeof(float);
+                destroy_block(b);
+            }
+            return;
+        }
+    }
+
+    size_t arena_peak(const arena_t *arenas, size_t count)
+    {
+        size_t res      = 0;
+        for (size_t i=0; i<count; ++i)
+            res            += arenas[i].nPeak;
+        return res;
+    }
+
+    size_t arena_reserved(const arena_t *arenas, size_t count)
+    {
+        size_t res      = 0;
+        for (size_t i=0; i<count; ++i)
+            res            += arenas[i].nReserved;
+        return res;
+    }
+} /* namespace timbremill */
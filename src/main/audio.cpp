@@ -19,16 +19,38 @@
  * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <private/arena.h>
 #include <private/audio.h>
+#include <private/fftconv.h>
+#include <private/kernels.h>
+#include <private/memory.h>
+#include <private/naming.h>
+#include <private/profile.h>
+#include <private/progress.h>
+#include <private/trace.h>
+#include <private/workers.h>
+#include <private/writer.h>
 #include <lsp-plug.in/stdlib/stdio.h>
-#include <lsp-plug.in/common/alloc.h>
 #include <lsp-plug.in/dsp/dsp.h>
 #include <lsp-plug.in/dsp-units/misc/windows.h>
 #include <lsp-plug.in/dsp-units/misc/fade.h>
 #include <lsp-plug.in/dsp-units/util/Convolver.h>
-#include <lsp-plug.in/expr/Expression.h>
+#include <lsp-plug.in/dsp-units/units.h>
+#include <lsp-plug.in/lltl/parray.h>
+#include <lsp-plug.in/mm/InAudioFileStream.h>
 #include <lsp-plug.in/stdlib/math.h>
 
+#include <float.h>
+
+#define CONV_SEGMENT_MIN        (1 << 18)
+#define RENDER_CHUNK            4096
+#define AVG_FLOOR               1e-7f       // Magnitudes are limited to -140 dB in the logarithmic domain
+#define AVG_POWER_MIN           0.01f       // Exponents closer to zero give the geometric mean
+#define AVG_POWER_MAX           4.0f        // The maximum absolute exponent of the power mean
+#define AVG_HIST_BUCKETS        256         // Number of histogram buckets per bin
+#define AVG_HIST_RANGE          192.0f      // Dynamic range (in dB) of histograms below the full scale
+#define GRID_MIN                16          // The minimum number of points of the logarithmic grid
+
 namespace timbremill
 {
     using namespace lsp;
@@ -41,9 +63,20 @@ namespace timbremill
         float  *fft;        // FFT buffer
 
         float  *spc;        // Output spectral data
+        float  *hist;       // Histograms of logarithmic magnitudes, AVG_HIST_BUCKETS rows of points
+        size_t *edges;      // Edges of bands of the logarithmic grid, NULL for the linear grid
 
         size_t  bins;       // Number of bins
         size_t  radix;      // FFT radix
+        size_t  count;      // Number of points in the profile
+
+        ssize_t method;     // Averaging method, see average_t
+        float   power;      // Exponent of the power mean
+        float   quantile;   // Quantile of magnitudes (0..1)
+        float   base;       // The logarithm of the lower bound of histograms
+        float   scale;      // Number of histogram buckets per unit of the logarithm
+
+        progress_slot_t *progress;  // Progress counters, may be NULL
     } spc_calc_t;
 
     typedef struct duration_t
@@ -65,28 +98,92 @@ namespace timbremill
         d->h = duration / 60;
     }
 
-    status_t load_audio_file(dspu::Sample *sample, size_t *file_srate, size_t srate, const LSPString *base, const LSPString *name)
+    static void advise_sample(dspu::Sample *sample)
+    {
+        for (size_t i=0, n=sample->channels(); i<n; ++i)
+            advise_memory(sample->channel(i), sample->max_length() * sizeof(float));
+    }
+
+    static status_t resample_audio(dspu::Sample *sample, size_t *file_srate, size_t srate, const char *name)
+    {
+        TRACE_SCOPE("resample");
+        status_t res;
+
+        // Resample audio data
+        size_t sample_rate = sample->sample_rate();
+        if ((res = sample->resample(srate)) != STATUS_OK)
+        {
+            fprintf(stderr, "  could not resample %s to sample rate %d, error code: %d\n",
+                name, int(srate), int(res));
+            return res;
+        }
+
+        // Return result
+        advise_sample(sample);
+        if (file_srate != NULL)
+            *file_srate = sample_rate;
+
+        return STATUS_OK;
+    }
+
+    status_t input_file_path(io::Path *path, const LSPString *base, const LSPString *name)
     {
         status_t res;
-        io::Path path;
 
         // Generate file name
-        if ((res = path.set(name)) != STATUS_OK)
+        if ((res = path->set(name)) != STATUS_OK)
         {
             fprintf(stderr, "  could not read file '%s', error code: %d\n", name->get_native(), int(res));
             return res;
         }
-        if (!path.is_absolute())
+        if (!path->is_absolute())
         {
-            if ((res = path.set(base, name)) != STATUS_OK)
+            if ((res = path->set(base, name)) != STATUS_OK)
             {
                 fprintf(stderr, "  could not read file '%s', error code: %d\n", name->get_native(), int(res));
                 return res;
             }
         }
 
+        return STATUS_OK;
+    }
+
+    status_t read_audio_info(mm::audio_stream_t *info, const LSPString *base, const LSPString *name)
+    {
+        status_t res;
+        io::Path path;
+        mm::InAudioFileStream is;
+
+        // Generate file name
+        if ((res = input_file_path(&path, base, name)) != STATUS_OK)
+            return res;
+        if (!path.exists())
+            return STATUS_NOT_FOUND;
+
+        // Read only the header of the file
+        if ((res = is.open(&path)) != STATUS_OK)
+            return res;
+        res             = is.info(info);
+        status_t rc     = is.close();
+
+        return (res != STATUS_OK) ? res : rc;
+    }
+
+    status_t load_audio_file(dspu::Sample *sample, size_t *file_srate, size_t srate, const LSPString *base, const LSPString *name)
+    {
+        status_t res;
+        io::Path path;
+
+        // Generate file name
+        if ((res = input_file_path(&path, base, name)) != STATUS_OK)
+            return res;
+
         // Load sample from file
-        if ((res = sample->load(&path)) != STATUS_OK)
+        {
+            TRACE_SCOPE("decode");
+            res = sample->load(&path);
+        }
+        if (res != STATUS_OK)
         {
             fprintf(stderr, "  could not read file '%s', error code: %d\n", path.as_native(), int(res));
             return res;
@@ -100,106 +197,332 @@ namespace timbremill
             int(d.h), int(d.m), int(d.s), int(d.ms));
 
         // Resample audio data
-        size_t sample_rate = sample->sample_rate();
-        if ((res = sample->resample(srate)) != STATUS_OK)
+        LSPString text;
+        if (!text.fmt_utf8("file '%s'", path.as_utf8()))
+            return STATUS_NO_MEM;
+
+        return resample_audio(sample, file_srate, srate, text.get_native());
+    }
+
+    status_t load_audio_file(dspu::Sample *sample, size_t *file_srate, size_t srate, const dspu::Sample *src)
+    {
+        status_t res;
+
+        // Copy the data of the sample
+        if ((res = sample->copy(src)) != STATUS_OK)
         {
-            fprintf(stderr, "  could not resample file '%s' to sample rate %d, error code: %d\n",
-                path.as_native(), int(srate), int(res));
+            fprintf(stderr, "  could not copy sample data, error code: %d\n", int(res));
             return res;
         }
 
-        // Return result
-        if (file_srate != NULL)
-            *file_srate = sample_rate;
+        return resample_audio(sample, file_srate, srate, "sample data");
+    }
 
-        return STATUS_OK;
+    status_t load_audio_file(dspu::Sample *sample, size_t *file_srate, size_t srate,
+        const float * const *data, size_t channels, size_t length, size_t sample_rate)
+    {
+        dspu::Sample out;
+
+        // Initialize the sample with the planar data
+        if (!out.init(channels, length, length))
+        {
+            fprintf(stderr, "  could not allocate sample data\n");
+            return STATUS_NO_MEM;
+        }
+        for (size_t i=0; i<channels; ++i)
+            dsp::copy(out.channel(i), data[i], length);
+        out.set_sample_rate(sample_rate);
+        sample->swap(&out);
+
+        return resample_audio(sample, file_srate, srate, "sample data");
     }
 
     status_t save_audio_file(dspu::Sample *sample, const LSPString *base, const LSPString *fmt, expr::Resolver *vars)
     {
+        fformat_t format;
+        format.nContainer   = CONT_WAV;
+        format.nEncoding    = ENC_FLOAT32;
+        format.nDither      = DITHER_NONE;
+
+        naming_t naming;
+        if (!naming.sBase.set(base))
+            return STATUS_NO_MEM;
+
+        return save_audio_file(sample, &naming, fmt, vars, &format, 1.0f);
+    }
+
+    status_t save_audio_file(const dspu::Sample *sample, naming_t *naming, const LSPString *fmt, expr::Resolver *vars,
+        const fformat_t *format, float gain)
+    {
+        TRACE_SCOPE("save");
         status_t res;
-        expr::Expression x;
-        expr::value_t val;
-        LSPString fname;
-        io::Path path, dir;
+        io::Path path;
 
-        // Parse the expression
-        if ((res = x.parse(fmt, expr::Expression::FLAG_STRING)) != STATUS_OK)
+        // Generate file name
+        if ((res = output_file_path(&path, naming, fmt, vars)) != STATUS_OK)
+            return res;
+
+        // Save sample to file
+        if ((res = write_audio_file(&path, sample, format, gain)) != STATUS_OK)
         {
-            fprintf(stderr, "  invalid expression: '%s'\n", fmt->get_native());
-            return STATUS_BAD_FORMAT;
+            fprintf(stderr, "  could not write file '%s', error code: %d\n", path.as_native(), int(res));
+            return res;
         }
 
-        // Evaluate the expression and cast to string
-        expr::init_value(&val);
-        x.set_resolver(vars);
-        if ((res = x.evaluate(&val)) == STATUS_OK)
-            res = expr::cast_string(&val);
-        if (res != STATUS_OK)
+        duration_t d;
+        calc_duration(&d, sample);
+        fprintf(stdout, "  saved file: '%s', channels: %d, samples: %d, sample rate: %d, duration: %02d:%02d:%02d.%03d\n",
+                path.as_native(),
+                int(sample->channels()), int(sample->length()), int(sample->sample_rate()),
+                int(d.h), int(d.m), int(d.s), int(d.ms)
+        );
+
+        return STATUS_OK;
+    }
+
+    status_t save_audio_file(float * const *data, size_t channels, size_t length, const dspu::Sample *sample)
+    {
+        if (channels != sample->channels())
         {
-            expr::destroy_value(&val);
-            fprintf(stderr, "  could not evaluate expression: '%s'\n", fmt->get_native());
-            return STATUS_BAD_FORMAT;
+            fprintf(stderr, "  number of channels mismatch: %d (buffer) vs %d (sample)\n",
+                int(channels), int(sample->channels()));
+            return STATUS_BAD_ARGUMENTS;
         }
-        fname.swap(val.v_str);
-        expr::destroy_value(&val);
+
+        // Copy the data and pad the rest of buffers with zeros
+        size_t count    = lsp_min(length, sample->length());
+        for (size_t i=0; i<channels; ++i)
+        {
+            dsp::copy(data[i], sample->channel(i), count);
+            dsp::fill_zero(&data[i][count], length - count);
+        }
+
+        return STATUS_OK;
+    }
+
+    status_t load_profile_file(dspu::Sample *profile, profile_info_t *info, const LSPString *base, const LSPString *name)
+    {
+        status_t res;
+        io::Path path;
 
         // Generate file name
-        if ((res = path.set(&fname)) != STATUS_OK)
+        if ((res = input_file_path(&path, base, name)) != STATUS_OK)
+            return res;
+
+        // Load profile from file
+        if ((res = read_profile(profile, info, &path)) != STATUS_OK)
         {
-            fprintf(stderr, "  could not write file '%s', error code: %d\n", fname.get_native(), int(res));
+            fprintf(stderr, "  could not read profile file '%s', error code: %d\n", path.as_native(), int(res));
             return res;
         }
-        if (!path.is_absolute())
+
+        fprintf(stdout, "  loaded profile: '%s', channels: %d, FFT rank: %d, sample rate: %d, source sample rate: %d, frames: %ld\n",
+            path.as_native(),
+            int(profile->channels()), int(info->nRank), int(info->nSampleRate), int(info->nSourceRate),
+            long(info->nFrames));
+
+        return STATUS_OK;
+    }
+
+    status_t save_profile_file(const dspu::Sample *profile, const profile_info_t *info,
+        naming_t *naming, const LSPString *fmt, expr::Resolver *vars, ssize_t encoding)
+    {
+        TRACE_SCOPE("save");
+        status_t res;
+        io::Path path;
+
+        // Generate file name
+        if ((res = output_file_path(&path, naming, fmt, vars)) != STATUS_OK)
+            return res;
+
+        // Save profile to file
+        if ((res = write_profile(&path, profile, info, encoding)) != STATUS_OK)
         {
-            if ((res = path.set(base, &fname)) != STATUS_OK)
-            {
-                fprintf(stderr, "  could not write file '%s', error code: %d\n", fname.get_native(), int(res));
-                return res;
-            }
+            fprintf(stderr, "  could not write profile file '%s', error code: %d\n", path.as_native(), int(res));
+            return res;
         }
 
-        // Create parent directory recursively
-        res = path.get_parent(&dir);
-        if (res == STATUS_OK)
+        fprintf(stdout, "  saved profile: '%s', channels: %d, FFT rank: %d, sample rate: %d, frames: %ld\n",
+            path.as_native(),
+            int(profile->channels()), int(info->nRank), int(info->nSampleRate), long(info->nFrames));
+
+        return STATUS_OK;
+    }
+
+    static inline size_t profile_length(size_t bins)
+    {
+        // The magnitude spectrum of the real signal is symmetric, keep bins from zero to niquist frequency
+        return (bins >> 1) + 1;
+    }
+
+    static inline void mirror_spectrum(float *spc, size_t bins)
+    {
+        size_t half     = bins >> 1;
+        dsp::reverse2(&spc[half + 1], &spc[1], half - 1);
+    }
+
+    size_t profile_points(size_t grid, size_t precision)
+    {
+        size_t length   = profile_length(1 << precision);
+        if ((grid == 0) || (grid >= length))
+            return length;
+        return lsp_max(grid, size_t(GRID_MIN));
+    }
+
+    /**
+     * Create the edges of bands of the logarithmic frequency grid. The band 0 contains
+     * the DC bin only, the edges of other bands are distributed geometrically between
+     * the bin 1 and the niquist bin. At low frequencies where the geometric step is less than
+     * one bin each band contains exactly one bin, so the grid becomes linear there.
+     *
+     * @param points number of points of the grid, should be less than the number of bins
+     * @param length number of bins of the half-spectrum
+     * @return array of points+1 edges, should be freed with delete [], NULL if there is no memory
+     */
+    static size_t *create_grid(size_t points, size_t length)
+    {
+        size_t *edges   = new size_t[points + 1];
+        if (edges == NULL)
+            return NULL;
+
+        double k        = log(double(length)) / double(points - 1);
+        edges[0]        = 0;
+        for (size_t j=1; j<=points; ++j)
         {
-            if ((res = dir.mkdir(true)) != STATUS_OK)
-            {
-                fprintf(stderr, "  could not create directory '%s', error code: %d\n", dir.as_native(), int(res));
-                return res;
-            }
+            size_t e        = size_t(exp(k * double(j - 1)) + 0.5);
+            e               = lsp_max(e, edges[j-1] + 1);
+            edges[j]        = lsp_min(e, length - (points - j));
         }
-        else if (res != STATUS_NOT_FOUND)
+
+        return edges;
+    }
+
+    static void init_average(spc_calc_t *calc, const spc_average_t *avg, size_t bins)
+    {
+        calc->method    = (avg != NULL) ? avg->nMethod : AVG_MEAN;
+        calc->power     = 1.0f;
+        calc->quantile  = 0.5f;
+
+        // The magnitude of the full-scale signal does not exceed the number of bins
+        float range     = AVG_HIST_RANGE * M_LN10 * 0.05f;
+        calc->base      = logf(bins) - range;
+        calc->scale     = AVG_HIST_BUCKETS / range;
+
+        switch (calc->method)
         {
-            fprintf(stderr, "  could not obtain parent directory for file '%s', error code: %d\n", fname.get_native(), int(res));
-            return res;
+            case AVG_POWER:
+                calc->power     = lsp_limit(avg->fPower, -AVG_POWER_MAX, AVG_POWER_MAX);
+                if (fabsf(calc->power) < AVG_POWER_MIN)
+                    calc->method    = AVG_LOG;
+                break;
+            case AVG_PERCENTILE:
+                calc->quantile  = lsp_limit(avg->fPercentile, 0.0f, 100.0f) * 0.01f;
+                break;
+            case AVG_LOG:
+            case AVG_MEDIAN:
+                break;
+            default:
+                calc->method    = AVG_MEAN;
+                break;
         }
+    }
 
-        // Load sample from file
-        if ((res = sample->save(&path)) < 0)
+    static inline bool use_histogram(const spc_calc_t *calc)
+    {
+        return (calc->method == AVG_MEDIAN) || (calc->method == AVG_PERCENTILE);
+    }
+
+    float spectral_average_param(const spc_average_t *avg)
+    {
+        if (avg == NULL)
+            return 0.0f;
+
+        switch (avg->nMethod)
         {
-            fprintf(stderr, "  could not write file '%s', error code: %d\n", path.as_native(), int(-res));
-            return -res;
+            case AVG_POWER:         return avg->fPower;
+            case AVG_MEDIAN:        return 50.0f;
+            case AVG_PERCENTILE:    return avg->fPercentile;
+            default: break;
         }
 
-        duration_t d;
-        calc_duration(&d, sample);
-        fprintf(stdout, "  saved file: '%s', channels: %d, samples: %d, sample rate: %d, duration: %02d:%02d:%02d.%03d\n",
-                path.as_native(),
-                int(sample->channels()), int(sample->length()), int(sample->sample_rate()),
-                int(d.h), int(d.m), int(d.s), int(d.ms)
-        );
-
-        return STATUS_OK;
+        return 0.0f;
     }
 
     void compute_spectrum_step(spc_calc_t *calc)
     {
+        size_t length   = calc->count;
+
         dsp::mul3(calc->tmp, calc->buf, calc->wnd, calc->bins);
         dsp::pcomplex_r2c(calc->fft, calc->tmp, calc->bins);
         dsp::packed_direct_fft(calc->fft, calc->fft, calc->radix);
-        dsp::pcomplex_mod(calc->tmp, calc->fft, calc->bins);
-        dsp::add2(calc->spc, calc->tmp, calc->bins);
+        dsp::pcomplex_mod(calc->tmp, calc->fft, profile_length(calc->bins));
+
+        // Aggregate bins into bands of the logarithmic grid
+        if (calc->edges != NULL)
+            band_mean2(calc->tmp, calc->tmp, calc->edges, length);
+
+        // Accumulate the magnitudes of the frame
+        switch (calc->method)
+        {
+            case AVG_POWER:
+                dsp::limit1(calc->tmp, AVG_FLOOR, FLT_MAX, length);
+                dsp::loge1(calc->tmp, length);
+                dsp::mul_k2(calc->tmp, calc->power, length);
+                dsp::exp1(calc->tmp, length);
+                dsp::add2(calc->spc, calc->tmp, length);
+                break;
+            case AVG_LOG:
+                dsp::limit1(calc->tmp, AVG_FLOOR, FLT_MAX, length);
+                dsp::loge1(calc->tmp, length);
+                dsp::add2(calc->spc, calc->tmp, length);
+                break;
+            case AVG_MEDIAN:
+            case AVG_PERCENTILE:
+                dsp::limit1(calc->tmp, AVG_FLOOR, FLT_MAX, length);
+                dsp::loge1(calc->tmp, length);
+                histogram_add(calc->hist, calc->tmp, calc->base, calc->scale, AVG_HIST_BUCKETS, length);
+                break;
+            default:
+                dsp::add2(calc->spc, calc->tmp, length);
+                break;
+        }
+    }
+
+    static void finish_spectrum(spc_calc_t *calc, size_t steps)
+    {
+        size_t length   = calc->count;
+        float k         = 1.0f / steps;
+
+        switch (calc->method)
+        {
+            case AVG_POWER:
+                dsp::mul_k2(calc->spc, k, length);
+                dsp::limit1(calc->spc, FLT_MIN, FLT_MAX, length);
+                dsp::loge1(calc->spc, length);
+                dsp::mul_k2(calc->spc, 1.0f / calc->power, length);
+                dsp::exp1(calc->spc, length);
+                break;
+            case AVG_LOG:
+                dsp::mul_k2(calc->spc, k, length);
+                dsp::exp1(calc->spc, length);
+                break;
+            case AVG_MEDIAN:
+            case AVG_PERCENTILE:
+            {
+                // The rank of the 100th percentile is clamped to fall into the last non-empty bucket
+                float rank      = lsp_min(calc->quantile * steps, steps - 0.5f);
+
+                // Convert the position of the quantile in buckets back to the magnitude
+                histogram_quantile(calc->spc, calc->tmp, calc->hist, rank, AVG_HIST_BUCKETS, length);
+                dsp::mul_k2(calc->spc, 1.0f / calc->scale, length);
+                dsp::add_k2(calc->spc, calc->base, length);
+                dsp::exp1(calc->spc, length);
+                break;
+            }
+            default:
+                dsp::mul_k2(calc->spc, k, length);
+                break;
+        }
     }
 
     status_t compute_spectrum(spc_calc_t *calc, dspu::Sample *out, const float *src, size_t length)
@@ -207,8 +530,10 @@ namespace timbremill
         // Initialize data
         dsp::fill_zero(calc->buf, calc->bins);
         dsp::fill_zero(calc->tmp, calc->bins);
-        dsp::fill_zero(calc->spc, calc->bins);
+        dsp::fill_zero(calc->spc, calc->count);
         dsp::fill_zero(calc->fft, calc->bins);
+        if (use_histogram(calc))
+            dsp::fill_zero(calc->hist, calc->count * AVG_HIST_BUCKETS);
         dspu::windows::blackman_nuttall(calc->wnd, calc->bins);
 
         // Process the data with half-sized chunks
@@ -228,6 +553,7 @@ namespace timbremill
             // Update position
             offset     += to_process;
             steps      += 1;
+            progress_add(calc->progress, to_process);
         }
 
         // Do the last step
@@ -237,148 +563,393 @@ namespace timbremill
         steps      += 1;
 
         // Compute the average spectrum at the output
-        dsp::mul_k2(calc->spc, 1.0f / steps, calc->bins);
+        finish_spectrum(calc, steps);
 
         return STATUS_OK;
     }
 
-    status_t spectral_profile(dspu::Sample *profile, const dspu::Sample *src, size_t precision)
+    wsize_t spectral_profile_frames(size_t length, size_t precision)
+    {
+        // The data is processed by half-sized chunks plus the last step
+        size_t half     = (1 << precision) >> 1;
+        return (length + half - 1) / half + 1;
+    }
+
+    status_t spectral_profile(dspu::Sample *profile, const dspu::Sample *src, size_t precision, size_t grid,
+        const spc_average_t *avg, arena_t *arena)
+    {
+        lltl::parray<float> data;
+        for (size_t i=0, n=src->channels(); i<n; ++i)
+        {
+            if (!data.add(const_cast<float *>(src->channel(i))))
+                return STATUS_NO_MEM;
+        }
+
+        return spectral_profile(profile, data.array(), src->channels(), src->length(), src->sample_rate(), precision, grid, avg, arena);
+    }
+
+    status_t spectral_profile(dspu::Sample *profile,
+        const float * const *data, size_t channels, size_t length, size_t sample_rate,
+        size_t precision, size_t grid, const spc_average_t *avg, arena_t *arena)
     {
         dspu::Sample out;
         spc_calc_t calc;
-        status_t res;
+        arena_t local;
+        status_t res = STATUS_OK;
 
-        uint8_t *ptr    = NULL;
         size_t bins     = 1 << precision;
+        size_t spc_len  = profile_length(bins);
+        if (arena == NULL)
+            arena           = &local;
 
-        // Allocate the buffers for processing
-        size_t to_alloc = bins * 3 + bins * 2; // buf + tmp + spc + wnd + fft
-        calc.buf        = alloc_aligned<float>(ptr, to_alloc, 64);
-        if (calc.buf == NULL)
-            return STATUS_NO_MEM;
-
-        calc.tmp        = &calc.buf[bins];
-        calc.wnd        = &calc.tmp[bins];
-        calc.fft        = &calc.wnd[bins];
+        calc.buf        = NULL;
         calc.spc        = NULL;
+        calc.hist       = NULL;
+        calc.edges      = NULL;
+        calc.bins       = bins;
+        calc.radix      = precision;
+        calc.count      = profile_points(grid, precision);
+        calc.progress   = progress_worker(0);   // The profile is computed by the calling thread
+        init_average(&calc, avg, bins);
+
+        // Create the logarithmic grid
+        size_t *edges   = NULL;
+        if (calc.count < spc_len)
+        {
+            if ((edges = create_grid(calc.count, spc_len)) == NULL)
+                return STATUS_NO_MEM;
+            calc.edges      = edges;
+        }
 
-        // Allocate the sample data
-        if (!out.init(src->channels(), bins, bins))
+        // Borrow the buffers for processing. The histograms have the fixed size
+        // which does not depend on the length of the signal
+        size_t to_alloc = bins * 3 + bins * 2; // buf + tmp + spc + wnd + fft
+        if ((calc.buf = arena_borrow(arena, to_alloc)) == NULL)
+            res             = STATUS_NO_MEM;
+        else if (use_histogram(&calc))
         {
-            free_aligned(ptr);
-            return STATUS_NO_MEM;
+            if ((calc.hist = arena_borrow(arena, calc.count * AVG_HIST_BUCKETS)) == NULL)
+                res             = STATUS_NO_MEM;
         }
 
-        // Now we can estimate the spectrum data for each channel
-        for (size_t i=0, n=src->channels(); i<n; ++i)
+        // Allocate the sample data
+        if ((res == STATUS_OK) && (!out.init(channels, calc.count, calc.count)))
+            res             = STATUS_NO_MEM;
+
+        if (res == STATUS_OK)
         {
-            calc.spc        = out.channel(i);
-            calc.bins       = bins;
-            calc.radix      = precision;
+            calc.tmp        = &calc.buf[bins];
+            calc.wnd        = &calc.tmp[bins];
+            calc.fft        = &calc.wnd[bins];
 
-            res = compute_spectrum(&calc, &out, src->channel(i), src->length());
-            if (res != STATUS_OK)
+            // Now we can estimate the spectrum data for each channel
+            for (size_t i=0; (res == STATUS_OK) && (i<channels); ++i)
             {
-                free_aligned(ptr);
-                return res;
+                TRACE_SCOPE_ARG("spectral_profile", i);
+                calc.spc        = out.channel(i);
+                res             = compute_spectrum(&calc, &out, data[i], length);
             }
         }
 
-        // Release allocated data and return result
-        out.set_sample_rate(src->sample_rate());
-        profile->swap(&out);
-        free_aligned(ptr);
+        // Return the result
+        if (res == STATUS_OK)
+        {
+            out.set_sample_rate(sample_rate);
+            profile->swap(&out);
+        }
 
-        return STATUS_OK;
+        // Return borrowed data
+        arena_return(arena, calc.hist);
+        arena_return(arena, calc.buf);
+        if (edges != NULL)
+            delete [] edges;
+
+        return res;
+    }
+
+    static inline float spectral_floor(const float *spc, size_t count, float kmin)
+    {
+        return lsp_max(dsp::max(spc, count) * kmin, FLT_MIN);
+    }
+
+    /**
+     * Convert the zero-phase magnitude spectrum into the minimum-phase impulse response
+     * using the real cepstrum: the logarithm of the magnitude is transformed to the
+     * cepstral domain, folded to make it causal and transformed back with the complex
+     * exponent applied.
+     *
+     * @param dst destination buffer of bins samples to store the impulse response
+     * @param mag the magnitude spectrum of bins samples
+     * @param fft temporary buffer of bins*2 samples for packed complex data
+     * @param tmp temporary buffer of bins samples
+     * @param precision the FFT precision
+     */
+    static void minimum_phase(float *dst, const float *mag, float *fft, float *tmp, size_t precision)
+    {
+        size_t bins     = 1 << precision;
+        size_t half     = bins >> 1;
+
+        // Compute the real cepstrum of the magnitude spectrum
+        for (size_t k=0; k<bins; ++k)
+            tmp[k]          = logf(lsp_max(mag[k], FLT_MIN));
+        dsp::pcomplex_r2c(fft, tmp, bins);
+        dsp::packed_reverse_fft(fft, fft, precision);
+        dsp::pcomplex_c2r(tmp, fft, bins);
+
+        // Fold the cepstrum: keep the zero and niquist quefrencies, double the causal part
+        // and drop the anti-causal part
+        dsp::mul_k2(&tmp[1], 2.0f, half - 1);
+        dsp::fill_zero(&tmp[half + 1], half - 1);
+
+        // Transform back to the frequency domain and apply the complex exponent
+        dsp::pcomplex_r2c(fft, tmp, bins);
+        dsp::packed_direct_fft(fft, fft, precision);
+        for (size_t k=0; k<bins; ++k)
+        {
+            float *v        = &fft[k*2];
+            float m         = expf(v[0]);
+            float a         = v[1];
+            v[0]            = m * cosf(a);
+            v[1]            = m * sinf(a);
+        }
+
+        // Compute the impulse response
+        dsp::packed_reverse_fft(fft, fft, precision);
+        dsp::pcomplex_c2r(dst, fft, bins);
     }
 
     status_t timbre_impulse_response(
         dspu::Sample *dst,
         const dspu::Sample *master, const dspu::Sample *child,
         size_t precision, float db_range, size_t sample_rate,
-        float transition)
+        float transition, float smoothing)
     {
         dspu::Sample out;
+        dspu::Sample *vdst[1]           = { &out };
+        const dspu::Sample *vchild[1]   = { child };
         status_t res;
 
-        // Check sizes
-        if (master->samples() != child->samples())
+        res = timbre_impulse_responses(vdst, master, vchild, &sample_rate, 1, false, PHASE_LINEAR, precision, db_range, transition, smoothing, NULL);
+        if (res == STATUS_OK)
+            dst->swap(&out);
+
+        return res;
+    }
+
+    status_t timbre_impulse_responses(
+        dspu::Sample * const *dst,
+        const dspu::Sample *master, const dspu::Sample * const *children,
+        const size_t *sample_rates, size_t count, bool reverse, ssize_t phase,
+        size_t precision, float db_range, float transition, float smoothing, arena_t *arena)
+    {
+        TRACE_SCOPE("ir_build");
+
+        // Check sizes, the profiles on the logarithmic grid have less points than bins
+        size_t bins         = 1 << precision;
+        size_t half         = bins >> 1;
+        size_t length       = profile_length(bins);
+        size_t points       = master->samples();
+        if (profile_points(points, precision) != points)
         {
-            fprintf(stderr, "  The lenghts of audio profiles differ\n");
+            fprintf(stderr, "  The length of audio profile does not match the FFT precision\n");
             return STATUS_BAD_ARGUMENTS;
         }
-        if (master->channels() != child->channels())
+        for (size_t k=0; k<count; ++k)
         {
-            fprintf(stderr, "  The number of channels of audio profiles differ\n");
-            return STATUS_BAD_ARGUMENTS;
+            const dspu::Sample *child = children[k];
+            if (master->samples() != child->samples())
+            {
+                fprintf(stderr, "  The lenghts of audio profiles differ\n");
+                return STATUS_BAD_ARGUMENTS;
+            }
+            if (master->channels() != child->channels())
+            {
+                fprintf(stderr, "  The number of channels of audio profiles differ\n");
+                return STATUS_BAD_ARGUMENTS;
+            }
         }
 
-        // Copy the data from child sample to the output sample
-        if ((res = out.copy(child)) != STATUS_OK)
+        // Initialize the output samples
+        size_t channels     = master->channels();
+        for (size_t k=0; k<count; ++k)
         {
-            fprintf(stderr, "  Error initializing the sample data\n");
-            return STATUS_BAD_ARGUMENTS;
+            if (!dst[k]->init(channels, bins, bins))
+            {
+                fprintf(stderr, "  Error initializing the sample data\n");
+                return STATUS_NO_MEM;
+            }
+            dst[k]->set_sample_rate(children[k]->sample_rate());
         }
 
-        // Process each channel of the samples
-        uint8_t *ptr    = NULL;
-        size_t bins     = 1 << precision;
-        size_t half     = bins >> 1;
+        // Borrow the buffers for processing
+        arena_t local;
+        if (arena == NULL)
+            arena           = &local;
 
-        // Allocate the buffers for processing
-        size_t to_alloc = bins * 2 + bins * 2; // fft + tmp + wnd
-        float *fft      = alloc_aligned<float>(ptr, to_alloc, 64);
+        bool smooth     = smoothing > 0.0f;
+        size_t to_alloc = bins * 2 + bins * 3; // fft + tmp + wnd + inv
+        if (smooth)
+            to_alloc       += bins * 2;        // sm + sc
+        float *fft      = arena_borrow(arena, to_alloc);
+        if (fft == NULL)
+            return STATUS_NO_MEM;
         float *tmp      = &fft[bins * 2];
         float *wnd      = &tmp[bins];
-        if (fft == NULL)
+        float *inv      = &wnd[bins];
+        float *sm       = &inv[bins];
+        float *sc       = &sm[bins];
+
+        // Allocate the list of transition frequencies and the grid
+        size_t *pass    = new size_t[count];
+        if (pass == NULL)
+        {
+            arena_return(arena, fft);
             return STATUS_NO_MEM;
+        }
+        size_t *edges   = NULL;
+        if (points < length)
+        {
+            if ((edges = create_grid(points, length)) == NULL)
+            {
+                delete [] pass;
+                arena_return(arena, fft);
+                return STATUS_NO_MEM;
+            }
+        }
+
+        // Compute the limits of the correction gain, the range of zero or below disables the limit
+        float kmax          = (db_range > 0.0f) ? dspu::db_to_gain(db_range) : FLT_MAX;
+        float kmin          = (db_range > 0.0f) ? 1.0f / kmax : 0.0f;
 
+        // The window and the transition frequencies are shared by all children
         dspu::windows::blackman_nuttall(wnd, bins);
-        sample_rate         = lsp_min(sample_rate, master->sample_rate());
-        size_t fft_length   = out.samples();
         float kt            = expf(log(0.5f) * (1.0f + transition));
-        size_t pass         = fft_length * (kt * float(sample_rate)/float(master->sample_rate()));
+        for (size_t k=0; k<count; ++k)
+        {
+            size_t sample_rate  = lsp_min(sample_rates[k], master->sample_rate());
+            pass[k]             = lsp_min(size_t(bins * (kt * float(sample_rate)/float(master->sample_rate()))), length);
+        }
 
-        // Make impulse response for each channel
-        for (size_t i=0, n=out.channels(); i<n; ++i)
+        for (size_t i=0; i<channels; ++i)
         {
             const float *mchan  = master->channel(i);
-            float *chan         = out.channel(i);
+            if (smooth)
+            {
+                if (edges != NULL)
+                    octave_smooth_grid2(sm, mchan, edges, smoothing, points);
+                else
+                    octave_smooth2(sm, mchan, smoothing, points);
+                mchan               = sm;
+            }
 
-            dsp::div2(chan, mchan, fft_length);                     // Compute reverse specrum characterisic
-            dsp::fill_one(&chan[pass], fft_length-pass*2);          // Do not touch frequencies above the pass
+            // Compute the reciprocal of the master spectrum once per channel. The spectrum
+            // is limited from below by the spectral floor to avoid huge gains
+            if (!reverse)
+                rcp_floor2(inv, mchan, spectral_floor(mchan, points, kmin), points);
+
+            // Compute reverse spectrum characteristics for all children in one sweep,
+            // the correction is limited to the gain range. Only the half of the spectrum
+            // is processed, it is mirrored for the inverse transform. The correction of
+            // profiles on the logarithmic grid is computed for points of the grid and
+            // then expanded to bins
+            for (size_t k=0; k<count; ++k)
+            {
+                float *chan         = dst[k]->channel(i);
+                float *cor          = (edges != NULL) ? tmp : chan;
+                const float *cchan  = children[k]->channel(i);
+                if (smooth)
+                {
+                    if (edges != NULL)
+                        octave_smooth_grid2(sc, cchan, edges, smoothing, points);
+                    else
+                        octave_smooth2(sc, cchan, smoothing, points);
+                    cchan               = sc;
+                }
+                if (reverse)
+                    div_limit3(cor, mchan, cchan, spectral_floor(cchan, points, kmin), kmin, kmax, points);
+                else
+                    mul_limit3(cor, cchan, inv, kmin, kmax, points);
+                if (edges != NULL)
+                    grid_expand2(chan, cor, edges, points);
+                dsp::fill_one(&chan[pass[k]], length - pass[k]);        // Do not touch frequencies above the pass
+                mirror_spectrum(chan, bins);
+            }
 
-            dsp::pcomplex_r2c(fft, chan, bins);                     // Prepare the FFT buffer with zero phase
-            dsp::packed_reverse_fft(fft, fft, precision);           // Perform reverse FFT
-            dsp::pcomplex_c2r(tmp, fft, bins);                      // Convert back to real data, drop complex data which is 0
-            dsp::copy(chan, &tmp[half], half);                      // Make the IR linear-phase
-            dsp::copy(&chan[half], tmp, half);
-            dsp::mul2(chan, wnd, bins);                             // Apply window
+            // Perform the inverse transforms back-to-back
+            for (size_t k=0; k<count; ++k)
+            {
+                float *chan         = dst[k]->channel(i);
+
+                if (phase == PHASE_MINIMUM)
+                {
+                    minimum_phase(chan, chan, fft, tmp, precision);     // Build the minimum-phase IR
+                    dsp::mul2(chan, &wnd[half], half);                  // Apply the falling half of the window
+                    continue;
+                }
+
+                dsp::pcomplex_r2c(fft, chan, bins);                     // Prepare the FFT buffer with zero phase
+                dsp::packed_reverse_fft(fft, fft, precision);           // Perform reverse FFT
+                dsp::pcomplex_c2r(tmp, fft, bins);                      // Convert back to real data, drop complex data which is 0
+                dsp::copy(chan, &tmp[half], half);                      // Make the IR linear-phase
+                dsp::copy(&chan[half], tmp, half);
+                dsp::mul2(chan, wnd, bins);                             // Apply window
+            }
+        }
+
+        // The energy of the minimum-phase IR is concentrated at the beginning, keep the first half only
+        if (phase == PHASE_MINIMUM)
+        {
+            for (size_t k=0; k<count; ++k)
+                dst[k]->set_length(half);
         }
 
         // Release allocated data and return result
-        dst->swap(&out);
-        free_aligned(ptr);
+        if (edges != NULL)
+            delete [] edges;
+        delete [] pass;
+        arena_return(arena, fft);
 
         return STATUS_OK;
     }
 
-    status_t profile_to_impulse_response(dspu::Sample *dst, const dspu::Sample *profile, size_t precision)
+    status_t profile_to_impulse_response(dspu::Sample *dst, const dspu::Sample *profile, size_t precision, arena_t *arena)
     {
+        TRACE_SCOPE("ir_build");
         dspu::Sample out;
+        arena_t local;
 
         // Process each channel of the samples
-        uint8_t *ptr    = NULL;
         size_t bins     = 1 << precision;
         size_t half     = bins >> 1;
+        size_t length   = profile_length(bins);
+        size_t points   = profile->length();
+        if (profile_points(points, precision) != points)
+        {
+            fprintf(stderr, "  The length of audio profile does not match the FFT precision\n");
+            return STATUS_BAD_ARGUMENTS;
+        }
 
-        // Allocate the buffers for processing
+        // The profile on the logarithmic grid is expanded to bins
+        size_t *edges   = NULL;
+        if (points < length)
+        {
+            if ((edges = create_grid(points, length)) == NULL)
+                return STATUS_NO_MEM;
+        }
+
+        // Borrow the buffers for processing
+        if (arena == NULL)
+            arena           = &local;
         size_t to_alloc = bins * 2 + bins * 2; // fft + tmp + wnd
-        float *fft      = alloc_aligned<float>(ptr, to_alloc, 64);
-        float *tmp      = &fft[bins * 2];
-        float *wnd      = &tmp[bins];
+        float *fft      = arena_borrow(arena, to_alloc);
         if (fft == NULL)
+        {
+            if (edges != NULL)
+                delete [] edges;
             return STATUS_NO_MEM;
+        }
+        float *tmp      = &fft[bins * 2];
+        float *wnd      = &tmp[bins];
 
         dspu::windows::blackman_nuttall(wnd, bins);
         out.resize(profile->channels(), bins, bins);
@@ -387,9 +958,13 @@ namespace timbremill
         for (size_t i=0, n=out.channels(); i<n; ++i)
         {
             float *dst_chan = out.channel(i);
-            const float *src_chan = profile->channel(i);
 
-            dsp::pcomplex_r2c(fft, src_chan, bins);                 // Prepare the FFT buffer with zero phase
+            if (edges != NULL)                                      // Restore the full spectrum
+                grid_expand2(dst_chan, profile->channel(i), edges, points);
+            else
+                dsp::copy(dst_chan, profile->channel(i), length);
+            mirror_spectrum(dst_chan, bins);
+            dsp::pcomplex_r2c(fft, dst_chan, bins);                 // Prepare the FFT buffer with zero phase
             dsp::packed_reverse_fft(fft, fft, precision);           // Perform reverse FFT
             dsp::pcomplex_c2r(tmp, fft, bins);                      // Convert back to real data, drop complex data which is 0
             dsp::copy(dst_chan, &tmp[half], half);                  // Make the IR linear-phase
@@ -397,28 +972,99 @@ namespace timbremill
             dsp::mul2(dst_chan, wnd, bins);                         // Apply window
         }
 
-        // Release allocated data and return result
+        // Return borrowed data and return result
         dst->swap(&out);
-        free_aligned(ptr);
+        arena_return(arena, fft);
+        if (edges != NULL)
+            delete [] edges;
 
         return STATUS_OK;
     }
 
+    static inline double sample_energy(const dspu::Sample *src, size_t index)
+    {
+        double e = 0.0;
+        for (size_t i=0, n=src->channels(); i<n; ++i)
+        {
+            double v    = src->channel(i)[index];
+            e          += v * v;
+        }
+        return e;
+    }
+
+    void energy_window(size_t *head, size_t *count, const dspu::Sample *src, float energy)
+    {
+        size_t length   = src->length();
+        if (length == 0)
+        {
+            *head           = 0;
+            *count          = 0;
+            return;
+        }
+
+        // Compute the overall energy and find the peak of the impulse response
+        double total    = 0.0, peak = -1.0;
+        size_t ipeak    = 0;
+        for (size_t i=0; i<length; ++i)
+        {
+            double e        = sample_energy(src, i);
+            total          += e;
+            if (e > peak)
+            {
+                peak            = e;
+                ipeak           = i;
+            }
+        }
+
+        // Compute the amount of energy to retain
+        double retain   = total * (1.0 - pow(10.0, lsp_min(energy, 0.0f) * 0.1));
+
+        // Extend the window symmetrically until it retains enough energy
+        size_t first    = ipeak, last = ipeak + 1;
+        double sum      = peak;
+        while ((sum < retain) && ((first > 0) || (last < length)))
+        {
+            if (first > 0)
+                sum            += sample_energy(src, --first);
+            if (last < length)
+                sum            += sample_energy(src, last++);
+        }
+
+        *head           = first;
+        *count          = last - first;
+    }
+
     status_t trim_impulse_response(
         dspu::Sample *dst,
         ssize_t *latency,
         const dspu::Sample *src,
         const irfile_t *params)
     {
+        TRACE_SCOPE("trim");
         dspu::Sample out;
 
         // Compute sample parameters
         ssize_t length  = src->length();
-        ssize_t head    = (lsp_limit(params->fHeadCut, 0.0f, 100.0f) * 0.01f) * length;
-        ssize_t tail    = (lsp_limit(params->fTailCut, 0.0f, 100.0f) * 0.01f) * length;
-        ssize_t fadein  = (lsp_max(params->fFadeIn, 0.0f) * 0.01f) * length;
-        ssize_t fadeout = (lsp_max(params->fFadeOut, 0.0f) * 0.01f) * length;
-        ssize_t count   = lsp_max(length - head - tail, 0);
+        ssize_t head, count, fadein, fadeout;
+
+        if (params->bAutoTrim)
+        {
+            // Find the shortest window around the peak and place fades relative to it
+            size_t whead, wcount;
+            energy_window(&whead, &wcount, src, params->fTrimEnergy);
+            head            = whead;
+            count           = wcount;
+            fadein          = (lsp_max(params->fFadeIn, 0.0f) * 0.01f) * count;
+            fadeout         = (lsp_max(params->fFadeOut, 0.0f) * 0.01f) * count;
+        }
+        else
+        {
+            ssize_t tail    = (lsp_limit(params->fTailCut, 0.0f, 100.0f) * 0.01f) * length;
+            head            = (lsp_limit(params->fHeadCut, 0.0f, 100.0f) * 0.01f) * length;
+            count           = lsp_max(length - head - tail, 0);
+            fadein          = (lsp_max(params->fFadeIn, 0.0f) * 0.01f) * length;
+            fadeout         = (lsp_max(params->fFadeOut, 0.0f) * 0.01f) * length;
+        }
 
         // Initialize sample
         if (!out.init(src->channels(), count, count))
@@ -441,103 +1087,356 @@ namespace timbremill
         // Save sample
         out.set_sample_rate(src->sample_rate());
         dst->swap(&out);
-        *latency        = (length >> 1) - head; // Output latency of the sample
+        // Output latency of the sample, the minimum-phase IR has no pre-ringing and starts immediately
+        *latency        = ((params->nPhase == PHASE_MINIMUM) ? 0 : (length >> 1)) - head;
 
         return STATUS_OK;
     }
 
-    status_t convolve(dspu::Sample *dst, const dspu::Sample *src, const dspu::Sample *ir, ssize_t latency, float dry, float wet)
+    size_t convolution_length(size_t length, size_t ir_length, ssize_t latency)
     {
-        dspu::Sample out;
-        dspu::Convolver cv;
-
-        // Allocate necessary buffers
-        ssize_t dry_length  = src->length();
-        ssize_t wet_length  = dry_length + ir->length(); // The length of wet (processed) signal
-        ssize_t length      = (latency > 0) ?
-                              lsp_max(wet_length, ssize_t(dry_length + latency)) :
-                              lsp_max(ssize_t(wet_length - latency), dry_length);
-        if (!out.init(src->channels(), length, length))
-            return STATUS_NO_MEM;
+        size_t wet_length   = length + ir_length; // The length of wet (processed) signal
+        return (latency > 0) ?
+            lsp_max(wet_length, length + latency) :
+            lsp_max(wet_length - latency, length);
+    }
 
-        // Allocate buffer for convolution tail
-        uint8_t *ptr;
-        float *buf          = alloc_aligned<float>(ptr, wet_length);
-        if (buf == NULL)
-            return STATUS_NO_MEM;
+    typedef struct render_t
+    {
+        float * const          *vDst;       // Destination channels
+        const float * const    *vSrc;       // Source channels
+        float                  *vPeaks;     // Peak values of all segments
+        const dspu::Sample     *pIR;        // Impulse response for the real-time engine
+        const ir_spectrum_t    *pSpectrum;  // Spectrum of the impulse response for the offline engine
+        arena_t                *vArenas;    // Arenas of worker threads
+        size_t                  nIRLength;  // Length of the impulse response
+        size_t                  nDstLength; // Length of the destination channels
+        size_t                  nLength;    // Length of the source channels
+        size_t                  nSegSize;   // Size of the output segment
+        size_t                  nSegments;  // Number of output segments per channel
+        ssize_t                 nWetShift;  // Position of the first sample of the wet signal in the output
+        ssize_t                 nDryShift;  // Position of the first sample of the dry signal in the output
+        float                   fDry;       // Dry gain
+        float                   fWet;       // Wet gain
+    } render_t;
+
+    static inline size_t clamp_position(ssize_t pos, size_t first, size_t last)
+    {
+        return (pos < ssize_t(first)) ? first : (pos > ssize_t(last)) ? last : pos;
+    }
 
-        // Perform signal processing
-        for (size_t i=0, n=src->channels(); i<n; ++i)
+    static status_t render_segment(void *arg, size_t index, size_t worker)
+    {
+        TRACE_SCOPE_ARG("convolve", index);
+        render_t *r         = static_cast<render_t *>(arg);
+        arena_t *arena      = &r->vArenas[worker];
+        size_t channel      = index / r->nSegments;
+        size_t first        = (index % r->nSegments) * r->nSegSize;
+        size_t last         = lsp_min(first + r->nSegSize, r->nDstLength);
+        size_t ir_length    = r->nIRLength;
+        const float *src    = r->vSrc[channel];
+        float *dst          = r->vDst[channel];
+        progress_slot_t *ps = progress_worker(worker);
+
+        progress_stage(ps, PSTAGE_RENDER);
+
+        // Compute the range of the convolution result which is emitted by the segment. The input
+        // of the convolution starts one IR length earlier to produce the complete result
+        ssize_t c_first     = lsp_max(ssize_t(first) - r->nWetShift, ssize_t(0));
+        ssize_t c_last      = lsp_min(ssize_t(last) - r->nWetShift, ssize_t(r->nLength + ir_length));
+        ssize_t i_first     = lsp_max(c_first - ssize_t(ir_length), ssize_t(0));
+        ssize_t i_last      = lsp_min(c_last, ssize_t(r->nLength));
+        size_t count        = ((c_last > c_first) && (i_last > i_first)) ? i_last - i_first : 0;
+
+        // Perform convolution
+        float *buf          = NULL;
+        if (count > 0)
         {
-            // Initialize convolver
-            if (!cv.init(ir->channel(i), ir->length(), 16, 0))
-            {
-                free_aligned(buf);
+            buf                 = arena_borrow(arena, count + ir_length);
+            if (buf == NULL)
                 return STATUS_NO_MEM;
+
+            if (r->pSpectrum != NULL)
+            {
+                status_t res        = fft_convolve(buf, &src[i_first], count, r->pSpectrum, channel, arena);
+                if (res != STATUS_OK)
+                {
+                    arena_return(arena, buf);
+                    return res;
+                }
+            }
+            else
+            {
+                dspu::Convolver cv;
+                if (!cv.init(r->pIR->channel(channel), ir_length, 16, 0))
+                {
+                    arena_return(arena, buf);
+                    return STATUS_NO_MEM;
+                }
+
+                dsp::fill_zero(buf, count + ir_length);
+                cv.process(buf, &src[i_first], count);              // The main convolution
+                cv.process(&buf[count], &buf[count], ir_length);    // The tail of convolution
             }
+        }
 
-            // Perform convolution
-            dsp::fill_zero(buf, wet_length);
-            cv.process(buf, src->channel(i), dry_length);                   // The main convolution
-            cv.process(&buf[dry_length], &buf[dry_length], ir->length());   // The tail of convolution
+        // Compute the ranges of wet and dry signals in the output
+        size_t w_first      = (count > 0) ? clamp_position(c_first + r->nWetShift, first, last) : first;
+        size_t w_last       = (count > 0) ? clamp_position(c_last + r->nWetShift, first, last) : first;
+        size_t d_first      = clamp_position(r->nDryShift, first, last);
+        size_t d_last       = clamp_position(r->nDryShift + ssize_t(r->nLength), first, last);
+        ssize_t w_origin    = i_first + r->nWetShift;
 
-            // Apply dry (unprocessed signal)
-            float *dp       = out.channel(i);
-            if (latency > 0)
-                dsp::mul_k3(&dp[latency], src->channel(i), dry, dry_length);
-            else
-                dsp::mul_k3(dp, src->channel(i), dry, dry_length);
+        // Move the output segment to the NUMA node of the worker before emitting the data
+        localize_memory(&dst[first], (last - first) * sizeof(float));
 
-            // Apply wet (processed) signal
-            if (latency > 0)
-                dsp::fmadd_k3(dp, buf, wet, wet_length);
-            else
-                dsp::fmadd_k3(&dp[-latency], buf, wet, wet_length);
+        // Emit the final samples chunk by chunk while the data is in cache and track the peak
+        float peak          = 0.0f;
+        for (size_t p=first; p<last; p += RENDER_CHUNK)
+        {
+            size_t q            = lsp_min(p + RENDER_CHUNK, last);
+            size_t wf           = lsp_limit(w_first, p, q);
+            size_t wl           = lsp_limit(w_last, p, q);
+            size_t df           = lsp_limit(d_first, p, q);
+            size_t dl           = lsp_limit(d_last, p, q);
+
+            dsp::fill_zero(&dst[p], wf - p);
+            if (wl > wf)
+                dsp::mul_k3(&dst[wf], &buf[wf - w_origin], r->fWet, wl - wf);
+            dsp::fill_zero(&dst[wl], q - wl);
+            if (dl > df)
+                dsp::fmadd_k3(&dst[df], &src[df - r->nDryShift], r->fDry, dl - df);
+
+            peak                = lsp_max(peak, dsp::abs_max(&dst[p], q - p));
+            progress_add(ps, q - p);
         }
+        r->vPeaks[index]    = peak;
 
-        // Save sample
-        dst->swap(&out);
-        free_aligned(buf);
+        arena_return(arena, buf);
 
         return STATUS_OK;
     }
 
-    status_t normalize(dspu::Sample *dst, float gain, size_t mode)
+    static size_t render_segment_size(size_t channels, size_t length, size_t ir_length, size_t threads)
     {
-        if (mode == NORM_NONE)
-            return STATUS_OK;
+        // Split long channels into time segments if there are not enough channels to load all threads
+        size_t segments     = 1;
+        if ((channels < threads) && (length > 0))
+        {
+            size_t max_segs     = length / lsp_max(ir_length * 4, size_t(CONV_SEGMENT_MIN));
+            segments            = lsp_max(lsp_min((threads + channels - 1) / channels, max_segs), size_t(1));
+        }
 
-        float peak  = 0.0f;
-        for (size_t i=0, n=dst->channels(); i<n; ++i)
+        return lsp_max((length + segments - 1) / segments, size_t(1));
+    }
+
+    static status_t render(
+        float *peak, float * const *dst, size_t dst_length,
+        const float * const *src, size_t channels, size_t length,
+        const dspu::Sample *ir, const ir_spectrum_t *spc, size_t seg_size,
+        ssize_t wet_shift, ssize_t dry_shift, float dry, float wet, size_t threads, arena_t *arenas)
+    {
+        render_t r;
+        arena_t *local      = NULL;
+        if (arenas == NULL)
+        {
+            // Temporary arenas for the single render
+            local               = new arena_t[lsp_max(threads, size_t(1))];
+            if (local == NULL)
+                return STATUS_NO_MEM;
+            arenas              = local;
+        }
+
+        r.vDst              = dst;
+        r.vSrc              = src;
+        r.pIR               = ir;
+        r.pSpectrum         = spc;
+        r.vArenas           = arenas;
+        r.nIRLength         = (spc != NULL) ? spc->nLength : ir->length();
+        r.nDstLength        = dst_length;
+        r.nLength           = length;
+        r.nSegSize          = seg_size;
+        r.nSegments         = (dst_length + seg_size - 1) / seg_size;
+        r.nWetShift         = wet_shift;
+        r.nDryShift         = dry_shift;
+        r.fDry              = dry;
+        r.fWet              = wet;
+
+        // Render all segments in parallel, each segment emits the final data of the output
+        size_t tasks        = channels * r.nSegments;
+        r.vPeaks            = new float[lsp_max(tasks, size_t(1))];
+        if (r.vPeaks == NULL)
+        {
+            if (local != NULL)
+                delete [] local;
+            return STATUS_NO_MEM;
+        }
+
+        status_t res        = run_parallel(render_segment, &r, tasks, threads);
+        for (size_t i=1; i<threads; ++i)
+            progress_stage(progress_worker(i), PSTAGE_IDLE);
+        if ((res == STATUS_OK) && (peak != NULL))
+        {
+            *peak               = 0.0f;
+            for (size_t i=0; i<tasks; ++i)
+                *peak               = lsp_max(*peak, r.vPeaks[i]);
+        }
+
+        delete [] r.vPeaks;
+        if (local != NULL)
+            delete [] local;
+
+        return res;
+    }
+
+    static status_t render(
+        float *peak, float * const *dst, size_t dst_length,
+        const float * const *src, size_t channels, size_t length,
+        const dspu::Sample *ir, const ir_spectrum_t *spc,
+        ssize_t wet_shift, ssize_t dry_shift, float dry, float wet, ssize_t engine, size_t threads, arena_t *arenas)
+    {
+        size_t ir_channels  = (spc != NULL) ? spc->nChannels : ir->channels();
+        size_t ir_length    = (spc != NULL) ? spc->nLength : ir->length();
+        if (channels != ir_channels)
         {
-            float cpeak = dsp::abs_max(dst->channel(i), dst->length());
-            peak        = lsp_max(peak, cpeak);
+            fprintf(stderr, "  number of channels mismatch: %d (audio) vs %d (impulse response)\n",
+                int(channels), int(ir_channels));
+            return STATUS_BAD_ARGUMENTS;
         }
 
-        // No peak detected?
-        if (peak < 1e-6)
-            return STATUS_OK;
+        size_t seg_size     = render_segment_size(channels, dst_length, ir_length, threads);
+        if ((spc != NULL) || (engine != CONV_OFFLINE))
+            return render(peak, dst, dst_length, src, channels, length, ir, spc, seg_size, wet_shift, dry_shift, dry, wet, threads, arenas);
+
+        // The spectrum of the impulse response is computed once for all channels, segments and blocks
+        ir_spectrum_t *xspc = create_ir_spectrum(ir, fft_convolution_rank(seg_size + ir_length, ir_length));
+        if (xspc == NULL)
+            return STATUS_NO_MEM;
+
+        status_t res        = render(peak, dst, dst_length, src, channels, length, NULL, xspc, seg_size, wet_shift, dry_shift, dry, wet, threads, arenas);
+        release_ir_spectrum(xspc);
+
+        return res;
+    }
+
+    status_t convolve(
+        float * const *dst, size_t dst_length,
+        const float * const *src, size_t channels, size_t length,
+        const dspu::Sample *ir, ssize_t latency, float dry, float wet, ssize_t engine, size_t threads)
+    {
+        ssize_t dry_shift   = (latency > 0) ? latency : 0;
+        ssize_t wet_shift   = (latency > 0) ? 0 : -latency;
+
+        return render(NULL, dst, dst_length, src, channels, length, ir, NULL, wet_shift, dry_shift, dry, wet, engine, threads, NULL);
+    }
+
+    status_t convolve(
+        float * const *dst, size_t dst_length,
+        const float * const *src, size_t channels, size_t length,
+        const ir_spectrum_t *ir, ssize_t latency, float dry, float wet, size_t threads)
+    {
+        ssize_t dry_shift   = (latency > 0) ? latency : 0;
+        ssize_t wet_shift   = (latency > 0) ? 0 : -latency;
+
+        return render(NULL, dst, dst_length, src, channels, length, NULL, ir, wet_shift, dry_shift, dry, wet, CONV_OFFLINE, threads, NULL);
+    }
+
+    static status_t render_sample(
+        dspu::Sample *dst, float *peak, const dspu::Sample *src,
+        const dspu::Sample *ir, const ir_spectrum_t *spc,
+        ssize_t latency, float dry, float wet, bool compensate, bool match_length,
+        ssize_t engine, size_t threads, arena_t *arenas)
+    {
+        dspu::Sample out, *xdst;
+        lltl::parray<float> vdst, vsrc;
+        status_t res;
+
+        // Compute the range of the convolution result to emit
+        size_t ir_length    = (spc != NULL) ? spc->nLength : ir->length();
+        size_t skip         = ((compensate) && (latency > 0)) ? latency : 0;
+        size_t length       = (match_length) ? src->length() : convolution_length(src->length(), ir_length, latency) - skip;
+        ssize_t dry_shift   = ((latency > 0) ? latency : 0) - skip;
+        ssize_t wet_shift   = ((latency > 0) ? 0 : -latency) - skip;
+
+        // Render directly to the destination sample if it has enough capacity, this allows to
+        // reuse the same sample for the series of renders. Otherwise allocate the output sample
+        if ((dst != src) && (dst->channels() == src->channels()) && (dst->max_length() >= length))
+        {
+            xdst                = dst;
+            xdst->set_length(length);
+        }
+        else
+        {
+            xdst                = &out;
+            if (!out.init(src->channels(), length, length))
+                return STATUS_NO_MEM;
+            advise_sample(&out);
+        }
+
+        // Build the list of channels
+        for (size_t i=0, n=src->channels(); i<n; ++i)
+        {
+            if (!vdst.add(xdst->channel(i)))
+                return STATUS_NO_MEM;
+            if (!vsrc.add(const_cast<float *>(src->channel(i))))
+                return STATUS_NO_MEM;
+        }
+
+        // Perform the rendering
+        res = render(peak, vdst.array(), length, vsrc.array(), src->channels(), src->length(),
+            ir, spc, wet_shift, dry_shift, dry, wet, engine, threads, arenas);
+        if (res != STATUS_OK)
+            return res;
+
+        // Save sample
+        xdst->set_sample_rate(src->sample_rate());
+        if (xdst != dst)
+            dst->swap(&out);
+
+        return STATUS_OK;
+    }
+
+    status_t convolve(dspu::Sample *dst, const dspu::Sample *src, const dspu::Sample *ir, ssize_t latency, float dry, float wet, ssize_t engine, size_t threads)
+    {
+        return render_sample(dst, NULL, src, ir, NULL, latency, dry, wet, false, false, engine, threads, NULL);
+    }
+
+    status_t convolve(dspu::Sample *dst, const dspu::Sample *src, const ir_spectrum_t *ir, ssize_t latency, float dry, float wet, size_t threads)
+    {
+        return render_sample(dst, NULL, src, NULL, ir, latency, dry, wet, false, false, CONV_OFFLINE, threads, NULL);
+    }
+
+    status_t render_audio(
+        dspu::Sample *dst, float *peak,
+        const dspu::Sample *src, const dspu::Sample *ir,
+        ssize_t latency, float dry, float wet,
+        bool compensate, bool match_length,
+        ssize_t engine, size_t threads, arena_t *arenas)
+    {
+        return render_sample(dst, peak, src, ir, NULL, latency, dry, wet, compensate, match_length, engine, threads, arenas);
+    }
+
+    float normalizing_gain(float peak, float gain, size_t mode)
+    {
+        // No normalization or no peak detected?
+        if ((mode == NORM_NONE) || (peak < 1e-6))
+            return 1.0f;
 
         switch (mode)
         {
             case NORM_BELOW:
                 if (peak >= gain)
-                    return STATUS_OK;
+                    return 1.0f;
                 break;
             case NORM_ABOVE:
                 if (peak <= gain)
-                    return STATUS_OK;
+                    return 1.0f;
                 break;
             default:
                 break;
         }
 
-        // Adjust gain
-        float k = gain / peak;
-        for (size_t i=0, n=dst->channels(); i<n; ++i)
-            dsp::mul_k2(dst->channel(i), k, dst->length());
-
-        return STATUS_OK;
+        return gain / peak;
     }
 
     void compensate_latency(dspu::Sample *dst, size_t samples)
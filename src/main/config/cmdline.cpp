@@ -33,31 +33,61 @@ namespace timbremill
 {
     static const char *options[] =
     {
-        "-c",   "--config",                 "Configuration file name (required if no -mf option is set)",
+        "-av",  "--averaging",              "Averaging of the frame magnitudes in the profile: mean, power, log, median, percentile",
+        "-avp", "--averaging-power",        "The exponent of the power mean for the 'power' averaging",
+        "-c",   "--config",                 "Configuration file name (required if no -mf or -j option is set)",
         "-cf",  "--child",                  "The name of the child file (multiple options allowed)",
+        "-cp",  "--child-profile",          "The binary profile of the child file set by -cf (--child) option in the same order (multiple options allowed)",
+        "-ct",  "--container",              "Container of the output audio file: wav, w64, rf64, flac, raw",
+        "-cv",  "--convolver",              "Convolution engine: offline, realtime",
         "-d",   "--dst-path",               "Destination path to store audio files",
         "-dg",  "--dry",                    "The amount (in dB) of unprocessed signal in output file",
+        "-dt",  "--dither",                 "Dither of the output audio file: none, tpdf, shaped",
+        "-e",   "--encoding",               "Encoding of the output audio file: pcm16, pcm24, pcm32, float",
         "-f",   "--file",                   "Format of the output file name",
         "-fr",  "--fft-rank",               "The FFT rank (resolution) used for profiling",
         "-frc", "--fr-child",               "The name of the frequency response file for the child file",
         "-frm", "--fr-master",              "The name of the frequency response file for the master file",
         "-g",   "--group",                  "The group name for -cf (--child) option, \"default\" if not set",
+        "-gp",  "--grid-points",            "Number of points of the logarithmic frequency grid of profiles, 0 = linear grid of FFT bins",
+        "-gr",  "--gain-range",             "The maximum gain (in dB) of the timbral correction",
         "-h",   "--help",                   "Output this help message",
+        "-hp",  "--huge-pages",             "Use huge pages for large audio and profile buffers",
         "-ir",  "--ir-file",                "Format of the processed impulse response file name",
         "-iw",  "--ir-raw",                 "Format of the raw impulse response file name",
+        "-ic",  "--ir-container",           "Container of the IR files: wav, w64, rf64, flac, raw",
+        "-ie",  "--ir-encoding",            "Encoding of the IR files: pcm16, pcm24, pcm32, float",
+        "-iat", "--ir-auto-trim",           "Automatically trim the IR file leaving out the specified energy (in dB)",
+        "-ip",  "--ir-phase",               "Phase of the IR file: linear, minimum",
         "-ifi", "--ir-fade-in",             "The amount (in %) of fade-in for the IR file",
         "-ifo", "--ir-fade-out",            "The amount (in %) of fade-out for the IR file",
         "-ihc", "--ir-head-cut",            "The amount (in %) of head cut for the IR file",
         "-itc", "--ir-tail-cut",            "The amount (in %) of tail cut for the IR file",
+        "-j",   "--jobs",                   "File with groups in JSON-lines format, each group is processed once it is read",
         "-lc",  "--latency-compensation",   "Compensate the latency caused by IR of the linear-phased filter",
         "-m",   "--mastering",              "Work as auto-mastering tool instead of timbral correction",
         "-mf",  "--master",                 "The name of the master file",
         "-ml",  "--match-length",           "Match the length of the output file to the input file",
+        "-mn",  "--manifest",               "Append the records of processed work units in JSON-lines format to the file",
+        "-mp",  "--master-profile",         "The binary profile of the master file used instead of analyzing the master file",
         "-n",   "--normalize",              "Set normalization mode",
         "-ng",  "--norm-gain",              "Set normalization peak gain (in dB)",
-        "-p",   "--produce",                "Comma-separated list of produced output files (ir,frm,frc,raw,audio,all)",
+        "-nu",  "--numa",                   "NUMA memory placement: none, interleave, local",
+        "-p",   "--produce",                "Comma-separated list of produced output files (ir,frm,frc,prm,prc,raw,audio,all)",
+        "-pe",  "--pr-encoding",            "Encoding of the binary profile files: float, half",
+        "-pg",  "--progress",               "Report the progress: none, tty (status line), json (JSON lines to the status descriptor)",
+        "-pgi", "--progress-interval",      "Interval (in seconds) between progress reports",
+        "-pct", "--percentile",             "The percentile (0..100) of the frame magnitudes for the 'percentile' averaging",
+        "-pl",  "--plan",                   "Do not process files, write the JSON plan of the batch to the file, '-' for stdout",
+        "-prc", "--pr-child",               "The name of the binary profile file for the child file",
+        "-prm", "--pr-master",              "The name of the binary profile file for the master file",
         "-s",   "--src-path",               "Source path to take files from",
+        "-sfd", "--status-fd",              "File descriptor for the JSON progress lines, 2 (standard error) by default",
+        "-sh",  "--shard",                  "Process only the shard i/N of the batch, N processes with i = 1..N process the whole batch",
+        "-sm",  "--smoothing",              "Fractional-octave smoothing of profiles before the division, e.g. '1/3 oct', none by default",
         "-sr",  "--srate",                  "Sample rate of output files",
+        "-t",   "--threads",                "Number of threads used for rendering, 0 = number of CPU cores",
+        "-tr",  "--trace",                  "Write trace events in Chrome trace format to the file, requires the build with TRACE=1",
         "-tz",  "--transition-zone",        "The value of the frequency transition zone (in octaves)",
         "-wg",  "--wet",                    "The amount (in dB) of processed signal in output file",
 
@@ -146,6 +176,39 @@ namespace timbremill
         return STATUS_OK;
     }
 
+    static status_t parse_cmdline_shard(ssize_t *shard, ssize_t *shards, const char *val)
+    {
+        int index, count;
+        char tail;
+
+        if ((sscanf(val, "%d/%d%c", &index, &count, &tail) != 2) || (count < 1) || (index < 1) || (index > count))
+        {
+            fprintf(stderr, "Bad 'shard' value, expected i/N with 1 <= i <= N\n");
+            return STATUS_INVALID_VALUE;
+        }
+
+        *shard      = index;
+        *shards     = count;
+
+        return STATUS_OK;
+    }
+
+    static status_t parse_cmdline_smoothing(float *dst, const char *val)
+    {
+        LSPString in;
+        if (!in.set_native(val))
+        {
+            fprintf(stderr, "Out of memory\n");
+            return STATUS_NO_MEM;
+        }
+
+        status_t res = parse_smoothing(dst, &in);
+        if (res != STATUS_OK)
+            fprintf(stderr, "Bad 'smoothing' value, expected the fraction of octave like '1/3 oct'\n");
+
+        return res;
+    }
+
     static status_t parse_cmdline_float(float *dst, const char *val, const char *parameter)
     {
         LSPString in;
@@ -283,6 +346,7 @@ namespace timbremill
         const char *cmd = argv[0], *val;
         lltl::pphash<char, char> options;
         lltl::parray<char> children;
+        lltl::parray<char> profiles;
         status_t res;
 
         // Read options to hash
@@ -329,6 +393,23 @@ namespace timbremill
                 }
                 found       = true;
             }
+            else if ((!strcmp(xopt, "-cp")) || (!strcmp(xopt, "--child-profile")))
+            {
+                val = argv[i++];
+                if (i >= argc)
+                {
+                    fprintf(stderr, "Not defined value for option: %s\n", xopt);
+                    return STATUS_BAD_ARGUMENTS;
+                }
+
+                // Add child profile to list of profiles
+                if (!profiles.add(const_cast<char *>(val)))
+                {
+                    fprintf(stderr, "Not enough memory\n");
+                    return STATUS_NO_MEM;
+                }
+                found       = true;
+            }
             else
             {
                 for (const char **p = timbremill::options; *p != NULL; p += 3)
@@ -370,6 +451,7 @@ namespace timbremill
         // Now we are ready to read config file
         const char *master      = options.get("--master");
         const char *cfg_name    = options.get("--config");
+        const char *jobs        = options.get("--jobs");
         if (cfg_name != NULL)
         {
             // Try to parse configuration file
@@ -379,7 +461,7 @@ namespace timbremill
                 return res;
             }
         }
-        else if (!master)
+        else if ((!master) && (!jobs))
         {
             fprintf(stderr, "Not defined configuration file name\n");
             return STATUS_BAD_ARGUMENTS;
@@ -430,6 +512,26 @@ namespace timbremill
                 }
             }
 
+            // Configure profiles
+            if ((val = options.get("--master-profile")) != NULL)
+                fgrp->sMasterProfile.set_native(val);
+            for (size_t i=0, n=profiles.size(); i<n; ++i)
+            {
+                LSPString *pname = new LSPString();
+                if (pname == NULL)
+                {
+                    fprintf(stderr, "Not enough memory\n");
+                    return STATUS_NO_MEM;
+                }
+                pname->set_native(profiles.uget(i));
+                if (!fgrp->vProfiles.add(pname))
+                {
+                    delete pname;
+                    fprintf(stderr, "Not enough memory\n");
+                    return STATUS_NO_MEM;
+                }
+            }
+
             // Override produce as OUT_AUDIO
             cfg->nProduce   = OUT_AUDIO;
         }
@@ -459,6 +561,17 @@ namespace timbremill
             if ((res = parse_cmdline_float(&cfg->sIR.fFadeOut, val, "IR fade out")) != STATUS_OK)
                 return res;
         }
+        if ((val = options.get("--ir-auto-trim")) != NULL)
+        {
+            if ((res = parse_cmdline_float(&cfg->sIR.fTrimEnergy, val, "IR auto trim")) != STATUS_OK)
+                return res;
+            cfg->sIR.bAutoTrim  = true;
+        }
+        if ((val = options.get("--ir-phase")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->sIR.nPhase, "IR phase", val, phase_flags)) != STATUS_OK)
+                return res;
+        }
         if ((val = options.get("--ir-head-cut")) != NULL)
         {
             if ((res = parse_cmdline_float(&cfg->sIR.fHeadCut, val, "IR head cut")) != STATUS_OK)
@@ -473,16 +586,59 @@ namespace timbremill
             cfg->sDstPath.set_native(val);
         if ((val = options.get("--src-path")) != NULL)
             cfg->sSrcPath.set_native(val);
+        if (jobs != NULL)
+            cfg->sJobs.set_native(jobs);
+        if ((val = options.get("--plan")) != NULL)
+            cfg->sPlan.set_native(val);
+        if ((val = options.get("--shard")) != NULL)
+        {
+            if ((res = parse_cmdline_shard(&cfg->nShard, &cfg->nShards, val)) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--manifest")) != NULL)
+            cfg->sManifest.set_native(val);
+        if ((val = options.get("--trace")) != NULL)
+            cfg->sTrace.set_native(val);
         if ((val = options.get("--srate")) != NULL)
         {
             if ((res = parse_cmdline_int(&cfg->nSampleRate, val, "sample rate")) != STATUS_OK)
                 return res;
         }
+        if ((val = options.get("--threads")) != NULL)
+        {
+            if ((res = parse_cmdline_int(&cfg->nThreads, val, "threads")) != STATUS_OK)
+                return res;
+        }
         if ((val = options.get("--fft-rank")) != NULL)
         {
             if ((res = parse_cmdline_int(&cfg->nFftRank, val, "FFT rank")) != STATUS_OK)
                 return res;
         }
+        if ((val = options.get("--grid-points")) != NULL)
+        {
+            if ((res = parse_cmdline_int(&cfg->nGrid, val, "grid points")) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--averaging")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->nAverage, "averaging", val, average_flags)) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--averaging-power")) != NULL)
+        {
+            if ((res = parse_cmdline_float(&cfg->fAvgPower, val, "averaging power")) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--percentile")) != NULL)
+        {
+            if ((res = parse_cmdline_float(&cfg->fPercentile, val, "percentile")) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--smoothing")) != NULL)
+        {
+            if ((res = parse_cmdline_smoothing(&cfg->fSmoothing, val)) != STATUS_OK)
+                return res;
+        }
         if ((val = options.get("--gain-range")) != NULL)
         {
             if ((res = parse_cmdline_float(&cfg->fGainRange, val, "gain range")) != STATUS_OK)
@@ -528,6 +684,71 @@ namespace timbremill
             if ((res = parse_cmdline_bool(&cfg->bLatencyCompensation, val, "latency compensation")) != STATUS_OK)
                 return res;
         }
+        if ((val = options.get("--convolver")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->nConvolver, "convolver", val, convolver_flags)) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--container")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->vFormat[FOUT_AUDIO].nContainer, "container", val, container_flags)) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--encoding")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->vFormat[FOUT_AUDIO].nEncoding, "encoding", val, encoding_flags)) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--dither")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->vFormat[FOUT_AUDIO].nDither, "dither", val, dither_flags)) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--ir-container")) != NULL)
+        {
+            ssize_t container;
+            if ((res = parse_cmdline_enum(&container, "ir-container", val, container_flags)) != STATUS_OK)
+                return res;
+            cfg->vFormat[FOUT_IR].nContainer    = container;
+            cfg->vFormat[FOUT_RAW].nContainer   = container;
+            cfg->vFormat[FOUT_FRM].nContainer   = container;
+            cfg->vFormat[FOUT_FRC].nContainer   = container;
+        }
+        if ((val = options.get("--ir-encoding")) != NULL)
+        {
+            ssize_t encoding;
+            if ((res = parse_cmdline_enum(&encoding, "ir-encoding", val, encoding_flags)) != STATUS_OK)
+                return res;
+            cfg->vFormat[FOUT_IR].nEncoding     = encoding;
+            cfg->vFormat[FOUT_RAW].nEncoding    = encoding;
+            cfg->vFormat[FOUT_FRM].nEncoding    = encoding;
+            cfg->vFormat[FOUT_FRC].nEncoding    = encoding;
+        }
+        if ((val = options.get("--huge-pages")) != NULL)
+        {
+            if ((res = parse_cmdline_bool(&cfg->bHugePages, val, "huge pages")) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--numa")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->nNuma, "numa", val, numa_flags)) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--progress")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->nProgress, "progress", val, progress_flags)) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--progress-interval")) != NULL)
+        {
+            if ((res = parse_cmdline_float(&cfg->fProgressInterval, val, "progress interval")) != STATUS_OK)
+                return res;
+        }
+        if ((val = options.get("--status-fd")) != NULL)
+        {
+            if ((res = parse_cmdline_int(&cfg->nStatusFd, val, "status fd")) != STATUS_OK)
+                return res;
+        }
         if ((val = options.get("--match-length")) != NULL)
         {
             if ((res = parse_cmdline_bool(&cfg->bMatchLength, val, "match length")) != STATUS_OK)
@@ -545,6 +766,23 @@ namespace timbremill
             if (master)
                 cfg->nProduce |= OUT_FRC;
         }
+        if ((val = options.get("--pr-master")) != NULL)
+        {
+            cfg->sPRMaster.set_native(val);
+            if (master)
+                cfg->nProduce |= OUT_PRM;
+        }
+        if ((val = options.get("--pr-child")) != NULL)
+        {
+            cfg->sPRChild.set_native(val);
+            if (master)
+                cfg->nProduce |= OUT_PRC;
+        }
+        if ((val = options.get("--pr-encoding")) != NULL)
+        {
+            if ((res = parse_cmdline_enum(&cfg->nPREncoding, "pr-encoding", val, prof_encoding_flags)) != STATUS_OK)
+                return res;
+        }
 
         return STATUS_OK;
     }
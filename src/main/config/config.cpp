@@ -24,6 +24,7 @@
 
 #include <lsp-plug.in/io/InSequence.h>
 #include <lsp-plug.in/io/InMarkSequence.h>
+#include <lsp-plug.in/io/InStringSequence.h>
 
 namespace timbremill
 {
@@ -124,6 +125,31 @@ namespace timbremill
 
         return res;
     }
+
+    status_t read_job(fgroup_t *grp, io::IInSequence *is, size_t *line)
+    {
+        LSPString text;
+        status_t res;
+
+        // Skip empty lines
+        do
+        {
+            if ((res = is->read_line(&text, true)) != STATUS_OK)
+                return res;
+            ++(*line);
+            text.trim();
+        } while (text.is_empty());
+
+        // Parse the line as a separate JSON document
+        io::InStringSequence sq;
+        if ((res = sq.wrap(&text, false)) != STATUS_OK)
+            return res;
+
+        res = parse_json_job(grp, &sq);
+        status_t rc = sq.close();
+
+        return (res != STATUS_OK) ? res : rc;
+    }
 } /* namespace timbremill */
 
 
@@ -20,6 +20,8 @@
  */
 
 #include <private/config/data.h>
+#include <lsp-plug.in/expr/Tokenizer.h>
+#include <lsp-plug.in/io/InStringSequence.h>
 
 namespace timbremill
 {
@@ -33,6 +35,8 @@ namespace timbremill
         { "all",    OUT_ALL     },
         { "frm",    OUT_FRM     },
         { "frc",    OUT_FRC     },
+        { "prm",    OUT_PRM     },
+        { "prc",    OUT_PRC     },
         { NULL,     0           }
     };
 
@@ -45,6 +49,80 @@ namespace timbremill
         { NULL,     0           }
     };
 
+    const cfg_flag_t phase_flags[] =
+    {
+        { "linear",     PHASE_LINEAR    },
+        { "minimum",    PHASE_MINIMUM   },
+        { NULL,         0               }
+    };
+
+    const cfg_flag_t convolver_flags[] =
+    {
+        { "offline",    CONV_OFFLINE    },
+        { "realtime",   CONV_REALTIME   },
+        { NULL,         0               }
+    };
+
+    const cfg_flag_t encoding_flags[] =
+    {
+        { "pcm16",      ENC_PCM16       },
+        { "pcm24",      ENC_PCM24       },
+        { "pcm32",      ENC_PCM32       },
+        { "float",      ENC_FLOAT32     },
+        { NULL,         0               }
+    };
+
+    const cfg_flag_t dither_flags[] =
+    {
+        { "none",       DITHER_NONE     },
+        { "tpdf",       DITHER_TPDF     },
+        { "shaped",     DITHER_SHAPED   },
+        { NULL,         0               }
+    };
+
+    const cfg_flag_t container_flags[] =
+    {
+        { "wav",        CONT_WAV        },
+        { "w64",        CONT_W64        },
+        { "rf64",       CONT_RF64       },
+        { "flac",       CONT_FLAC       },
+        { "raw",        CONT_RAW        },
+        { NULL,         0               }
+    };
+
+    const cfg_flag_t prof_encoding_flags[] =
+    {
+        { "float",      PROF_FLOAT32    },
+        { "half",       PROF_FLOAT16    },
+        { NULL,         0               }
+    };
+
+    const cfg_flag_t numa_flags[] =
+    {
+        { "none",       NUMA_NONE       },
+        { "interleave", NUMA_INTERLEAVE },
+        { "local",      NUMA_LOCAL      },
+        { NULL,         0               }
+    };
+
+    const cfg_flag_t progress_flags[] =
+    {
+        { "none",       PROGRESS_NONE   },
+        { "tty",        PROGRESS_TTY    },
+        { "json",       PROGRESS_JSON   },
+        { NULL,         0               }
+    };
+
+    const cfg_flag_t average_flags[] =
+    {
+        { "mean",       AVG_MEAN        },
+        { "power",      AVG_POWER       },
+        { "log",        AVG_LOG         },
+        { "median",     AVG_MEDIAN      },
+        { "percentile", AVG_PERCENTILE  },
+        { NULL,         0               }
+    };
+
     fgroup_t::fgroup_t()
     {
     }
@@ -64,6 +142,15 @@ namespace timbremill
         }
 
         vFiles.flush();
+
+        for (size_t i=0, n=vProfiles.size(); i<n; ++i)
+        {
+            LSPString *profile = vProfiles.uget(i);
+            if (profile != NULL)
+                delete profile;
+        }
+
+        vProfiles.flush();
     }
 
     irfile_t::irfile_t()
@@ -72,6 +159,9 @@ namespace timbremill
         fTailCut                = 0.0f;
         fFadeIn                 = 0.0f;
         fFadeOut                = 0.0f;
+        bAutoTrim               = false;
+        fTrimEnergy             = -90.0f;
+        nPhase                  = PHASE_LINEAR;
 
         sFile.set_ascii("${master_name}/${file_name} - IR.wav");
         sRaw.set_ascii("${master_name}/${file_name} - Raw IR.wav");
@@ -79,12 +169,23 @@ namespace timbremill
         sFRChild.set_ascii("${master_name}/${file_name} - FR Child.wav");
     }
 
+    discover_t::discover_t()
+    {
+        bEnabled                = false;
+        sFiles.set_ascii("**/*.wav");
+    }
+
     config_t::config_t()
     {
         nSampleRate             = 48000;
         nFftRank                = 12;           // 4096 samples
+        nGrid                   = 0;            // Linear grid of FFT bins
+        nAverage                = AVG_MEAN;     // Arithmetic mean of frames by default
+        fAvgPower               = 2.0f;         // Quadratic mean for the power averaging
+        fPercentile             = 50.0f;        // Median for the percentile averaging
         fGainRange              = 48.0f;
         fTransition             = 0.5f;         // Transition zone
+        fSmoothing              = 0.0f;         // No smoothing of profiles
         fDry                    = -1000.0f;     // Dry amount
         fWet                    = 0.0f;         // Wet amount
         nProduce                = OUT_ALL;
@@ -93,8 +194,29 @@ namespace timbremill
         fNormGain               = 0.0f;         // 0 dB gain by default
         bLatencyCompensation    = false;        // Do not compensate latency by default
         bMatchLength            = false;        // Do not match length by default
+        nConvolver              = CONV_OFFLINE; // Use offline convolution engine by default
+        nThreads                = 0;            // Use all CPU cores by default
+        nPREncoding             = PROF_FLOAT32; // Full-precision profiles by default
+        bHugePages              = false;        // Do not use huge pages by default
+        nNuma                   = NUMA_NONE;    // Default memory placement by default
+        nProgress               = PROGRESS_NONE;// Do not report the progress by default
+        nStatusFd               = 2;            // Report the progress to the standard error
+        fProgressInterval       = 1.0f;         // Report the progress once per second
+        nShard                  = 0;            // Do not split the batch into shards by default
+        nShards                 = 0;
+
+        // Floating-point WAV files without dither by default
+        for (size_t i=0; i<FOUT_TOTAL; ++i)
+        {
+            fformat_t *f            = &vFormat[i];
+            f->nContainer           = CONT_WAV;
+            f->nEncoding            = ENC_FLOAT32;
+            f->nDither              = DITHER_NONE;
+        }
 
         sFile.set_ascii("${master_name}/${file_name} - processed.wav");
+        sPRMaster.set_ascii("${master_name}/${file_name} - Profile Master.tmpf");
+        sPRChild.set_ascii("${master_name}/${file_name} - Profile Child.tmpf");
     }
 
     config_t::~config_t()
@@ -126,5 +248,58 @@ namespace timbremill
         }
         return NULL;
     }
+
+    static status_t parse_smoothing_value(float *dst, const LSPString *s, bool unit)
+    {
+        io::InStringSequence is(s);
+        expr::Tokenizer t(&is);
+
+        switch (t.get_token(expr::TF_GET))
+        {
+            case expr::TT_IVALUE: *dst = t.int_value(); break;
+            case expr::TT_FVALUE: *dst = t.float_value(); break;
+            default:
+                return STATUS_INVALID_VALUE;
+        }
+
+        // The optional unit follows the last number
+        expr::token_t tok = t.get_token(expr::TF_GET | expr::TF_XKEYWORDS);
+        if ((unit) && (tok == expr::TT_BAREWORD) && (t.text_value()->equals_ascii_nocase("oct")))
+            tok     = t.get_token(expr::TF_GET);
+
+        return (tok == expr::TT_EOF) ? STATUS_OK : STATUS_INVALID_VALUE;
+    }
+
+    status_t parse_smoothing(float *dst, const LSPString *s)
+    {
+        if ((s->is_empty()) || (s->equals_ascii_nocase("none")) || (s->equals_ascii_nocase("off")))
+        {
+            *dst        = 0.0f;
+            return STATUS_OK;
+        }
+
+        // Parse the fraction or the number of octaves
+        float num = 0.0f, den = 1.0f;
+        ssize_t split       = s->index_of('/');
+        status_t res;
+        if (split >= 0)
+        {
+            LSPString head, tail;
+            if ((!head.set(s, 0, split)) || (!tail.set(s, split + 1)))
+                return STATUS_NO_MEM;
+            if ((res = parse_smoothing_value(&num, &head, false)) != STATUS_OK)
+                return res;
+            if ((res = parse_smoothing_value(&den, &tail, true)) != STATUS_OK)
+                return res;
+        }
+        else if ((res = parse_smoothing_value(&num, s, true)) != STATUS_OK)
+            return res;
+
+        if ((!(num >= 0.0f)) || (!(den > 0.0f)) || (!(num / den <= SMOOTHING_MAX)))
+            return STATUS_INVALID_VALUE;
+
+        *dst        = num / den;
+        return STATUS_OK;
+    }
 } /* namespace timbremill */
 
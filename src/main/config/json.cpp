@@ -80,6 +80,39 @@ namespace timbremill
         return STATUS_OK;
     }
 
+    static status_t parse_json_config_smoothing(float *dst, json::Parser *p)
+    {
+        json::event_t ev;
+
+        // Should be JSON string or number
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if ((ev.type == json::JE_INTEGER) || (ev.type == json::JE_DOUBLE))
+        {
+            // The number of octaves is limited the same way as the string value
+            double value    = (ev.type == json::JE_INTEGER) ? double(ev.iValue) : ev.fValue;
+            if ((!(value >= 0.0)) || (!(value <= SMOOTHING_MAX)))
+            {
+                fprintf(stderr, "Error: bad 'smoothing' value %f, expected the number of octaves between 0 and %.1f\n",
+                    value, SMOOTHING_MAX);
+                return STATUS_INVALID_VALUE;
+            }
+            *dst    = value;
+        }
+        else if (ev.type == json::JE_STRING)
+        {
+            if ((res = parse_smoothing(dst, &ev.sValue)) != STATUS_OK)
+                fprintf(stderr, "Error: bad 'smoothing' value '%s', expected the fraction of octave like '1/3 oct'\n", ev.sValue.get_native());
+            return res;
+        }
+        else
+            return STATUS_BAD_TYPE;
+
+        // Return OK status
+        return STATUS_OK;
+    }
+
     static status_t parse_json_config_bool(bool *dst, json::Parser *p)
     {
         json::event_t ev;
@@ -168,18 +201,12 @@ namespace timbremill
         return res;
     }
 
-    static status_t parse_json_config_group_files(fgroup_t *grp, json::Parser *p)
+    static status_t parse_json_config_file_list(lltl::parray<LSPString> *files, json::Parser *p)
     {
         json::event_t ev;
+        status_t res;
 
-        // Should be JSON object
-        status_t res = p->read_next(&ev);
-        if (res != STATUS_OK)
-            return res;
-        else if (ev.type != json::JE_ARRAY_START)
-            return STATUS_BAD_TYPE;
-
-        // Read group object
+        // Read the list of files
         while (true)
         {
             // Read property name
@@ -195,7 +222,7 @@ namespace timbremill
             LSPString *fname = ev.sValue.clone();
             if (fname == NULL)
                 return STATUS_NO_MEM;
-            if (!grp->vFiles.add(fname))
+            if (!files->add(fname))
             {
                 delete fname;
                 return STATUS_NO_MEM;
@@ -209,11 +236,70 @@ namespace timbremill
         return res;
     }
 
-    static status_t parse_json_config_group(fgroup_t *grp, json::Parser *p)
+    static status_t parse_json_config_group_files(lltl::parray<LSPString> *files, json::Parser *p)
+    {
+        json::event_t ev;
+
+        // Should be JSON array
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if (ev.type != json::JE_ARRAY_START)
+            return STATUS_BAD_TYPE;
+
+        return parse_json_config_file_list(files, p);
+    }
+
+    static status_t parse_json_config_group_children(fgroup_t *grp, json::Parser *p)
+    {
+        json::event_t ev;
+
+        // Should be JSON array with file names or JSON object with glob pattern
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if (ev.type == json::JE_ARRAY_START)
+            return parse_json_config_file_list(&grp->vFiles, p);
+        else if (ev.type != json::JE_OBJECT_START)
+            return STATUS_BAD_TYPE;
+
+        // Read object
+        while (true)
+        {
+            // Read property name
+            res = p->read_next(&ev);
+            if (res != STATUS_OK)
+                return res;
+            else if (ev.type == json::JE_OBJECT_END)
+                break;
+            else if (ev.type != json::JE_PROPERTY)
+                return STATUS_BAD_FORMAT;
+
+            if (ev.sValue.equals_ascii("glob"))
+                res = parse_json_config_string(&grp->sGlob, p);
+            else
+                res = p->skip_current();
+
+            // Analyze result
+            if (res != STATUS_OK)
+                break;
+        }
+
+        if ((res == STATUS_OK) && (grp->sGlob.is_empty()))
+        {
+            lsp_error("Missing 'glob' pattern for 'files' of group %s", grp->sName.get_native());
+            res = STATUS_BAD_FORMAT;
+        }
+
+        return res;
+    }
+
+    static status_t parse_json_config_group(fgroup_t *grp, json::Parser *p, bool job)
     {
         json::event_t ev;
         bool master_set = false;
         bool files_set = false;
+        bool profiles_set = false;
 
         // Should be JSON object
         status_t res = p->read_next(&ev);
@@ -234,8 +320,10 @@ namespace timbremill
             else if (ev.type != json::JE_PROPERTY)
                 return STATUS_BAD_FORMAT;
 
-            // Create group and set it's name
-            if (ev.sValue.equals_ascii("master"))
+            // The name of the job is the property of the group object
+            if ((job) && (ev.sValue.equals_ascii("name")))
+                res         = parse_json_config_string(&grp->sName, p);
+            else if (ev.sValue.equals_ascii("master"))
             {
                 if (master_set)
                 {
@@ -267,7 +355,21 @@ namespace timbremill
                 }
 
                 files_set   = true;
-                res         = parse_json_config_group_files(grp, p);
+                res         = parse_json_config_group_children(grp, p);
+            }
+            else if (ev.sValue.equals_ascii("master_profile"))
+                res         = parse_json_config_string(&grp->sMasterProfile, p);
+            else if (ev.sValue.equals_ascii("profiles"))
+            {
+                if (profiles_set)
+                {
+                    lsp_error("Duplicate 'profiles' property");
+                    res = STATUS_BAD_FORMAT;
+                    break;
+                }
+
+                profiles_set = true;
+                res         = parse_json_config_group_files(&grp->vProfiles, p);
             }
             else
                 res         = p->skip_current();
@@ -277,6 +379,13 @@ namespace timbremill
                 break;
         }
 
+        // Profiles are bound to the child files by index, the glob pattern gives no stable index
+        if ((res == STATUS_OK) && (!grp->sGlob.is_empty()) && (!grp->vProfiles.is_empty()))
+        {
+            lsp_error("The 'profiles' can not be used with 'glob' pattern in group %s", grp->sName.get_native());
+            res = STATUS_BAD_FORMAT;
+        }
+
         return res;
     }
 
@@ -326,7 +435,58 @@ namespace timbremill
             }
 
             // Read group object
-            res = parse_json_config_group(grp, p);
+            res = parse_json_config_group(grp, p, false);
+
+            // Analyze result
+            if (res != STATUS_OK)
+                break;
+        }
+
+        return res;
+    }
+
+    static status_t parse_json_config_auto_trim(irfile_t *ir, json::Parser *p)
+    {
+        json::event_t ev;
+
+        // Should be JSON object, boolean or null
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if (ev.type == json::JE_NULL)
+        {
+            ir->bAutoTrim   = false;
+            return STATUS_OK;
+        }
+        else if (ev.type == json::JE_BOOL)
+        {
+            ir->bAutoTrim   = ev.bValue;
+            return STATUS_OK;
+        }
+        else if (ev.type != json::JE_OBJECT_START)
+            return STATUS_BAD_TYPE;
+
+        // The object enables the automatic trimming unless it is explicitly disabled
+        ir->bAutoTrim   = true;
+
+        // Read object
+        while (true)
+        {
+            // Read property name
+            res = p->read_next(&ev);
+            if (res != STATUS_OK)
+                return res;
+            else if (ev.type == json::JE_OBJECT_END)
+                break;
+            else if (ev.type != json::JE_PROPERTY)
+                return STATUS_BAD_FORMAT;
+
+            if (ev.sValue.equals_ascii("enabled"))
+                res = parse_json_config_bool(&ir->bAutoTrim, p);
+            else if (ev.sValue.equals_ascii("energy"))
+                res = parse_json_config_float(&ir->fTrimEnergy, p);
+            else
+                res = p->skip_current();
 
             // Analyze result
             if (res != STATUS_OK)
@@ -367,6 +527,10 @@ namespace timbremill
                 res = parse_json_config_float(&ir->fFadeIn, p);
             else if (ev.sValue.equals_ascii("fade_out"))
                 res = parse_json_config_float(&ir->fFadeOut, p);
+            else if (ev.sValue.equals_ascii("auto_trim"))
+                res = parse_json_config_auto_trim(ir, p);
+            else if (ev.sValue.equals_ascii("phase"))
+                res = parse_json_config_enum(&ir->nPhase, phase_flags, p);
             else if (ev.sValue.equals_ascii("file"))
                 res = parse_json_config_string(&ir->sFile, p);
             else if (ev.sValue.equals_ascii("raw"))
@@ -386,6 +550,235 @@ namespace timbremill
         return res;
     }
 
+    static status_t parse_json_config_profile(config_t *cfg, json::Parser *p)
+    {
+        json::event_t ev;
+
+        // Should be JSON object
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if (ev.type != json::JE_OBJECT_START)
+            return STATUS_BAD_TYPE;
+
+        // Read object
+        while (true)
+        {
+            // Read property name
+            res = p->read_next(&ev);
+            if (res != STATUS_OK)
+                return res;
+            else if (ev.type == json::JE_OBJECT_END)
+                break;
+            else if (ev.type != json::JE_PROPERTY)
+                return STATUS_BAD_FORMAT;
+
+            if (ev.sValue.equals_ascii("master"))
+                res = parse_json_config_string(&cfg->sPRMaster, p);
+            else if (ev.sValue.equals_ascii("child"))
+                res = parse_json_config_string(&cfg->sPRChild, p);
+            else if (ev.sValue.equals_ascii("encoding"))
+                res = parse_json_config_enum(&cfg->nPREncoding, prof_encoding_flags, p);
+            else
+                res = p->skip_current();
+
+            // Analyze result
+            if (res != STATUS_OK)
+                break;
+        }
+
+        return res;
+    }
+
+    static status_t parse_json_config_memory(config_t *cfg, json::Parser *p)
+    {
+        json::event_t ev;
+
+        // Should be JSON object
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if (ev.type != json::JE_OBJECT_START)
+            return STATUS_BAD_TYPE;
+
+        // Read object
+        while (true)
+        {
+            // Read property name
+            res = p->read_next(&ev);
+            if (res != STATUS_OK)
+                return res;
+            else if (ev.type == json::JE_OBJECT_END)
+                break;
+            else if (ev.type != json::JE_PROPERTY)
+                return STATUS_BAD_FORMAT;
+
+            if (ev.sValue.equals_ascii("huge_pages"))
+                res = parse_json_config_bool(&cfg->bHugePages, p);
+            else if (ev.sValue.equals_ascii("numa"))
+                res = parse_json_config_enum(&cfg->nNuma, numa_flags, p);
+            else
+                res = p->skip_current();
+
+            // Analyze result
+            if (res != STATUS_OK)
+                break;
+        }
+
+        return res;
+    }
+
+    static status_t parse_json_config_discover(discover_t *d, json::Parser *p)
+    {
+        json::event_t ev;
+
+        // Should be JSON object
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if (ev.type != json::JE_OBJECT_START)
+            return STATUS_BAD_TYPE;
+
+        // Read object
+        while (true)
+        {
+            // Read property name
+            res = p->read_next(&ev);
+            if (res != STATUS_OK)
+                return res;
+            else if (ev.type == json::JE_OBJECT_END)
+                break;
+            else if (ev.type != json::JE_PROPERTY)
+                return STATUS_BAD_FORMAT;
+
+            if (ev.sValue.equals_ascii("path"))
+                res = parse_json_config_string(&d->sPath, p);
+            else if (ev.sValue.equals_ascii("master"))
+                res = parse_json_config_string(&d->sMaster, p);
+            else if (ev.sValue.equals_ascii("files"))
+                res = parse_json_config_string(&d->sFiles, p);
+            else
+                res = p->skip_current();
+
+            // Analyze result
+            if (res != STATUS_OK)
+                break;
+        }
+
+        if (res != STATUS_OK)
+            return res;
+        if (d->sMaster.is_empty())
+        {
+            lsp_error("Missing 'master' pattern for the 'discover' rule");
+            return STATUS_BAD_FORMAT;
+        }
+
+        d->bEnabled     = true;
+        return res;
+    }
+
+    static status_t parse_json_config_format(config_t *cfg, ssize_t outputs, json::Parser *p)
+    {
+        json::event_t ev;
+        fformat_t fmt;
+
+        // Should be JSON object
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if (ev.type != json::JE_OBJECT_START)
+            return STATUS_BAD_TYPE;
+
+        // Unset fields keep the previous values
+        fmt.nContainer  = -1;
+        fmt.nEncoding   = -1;
+        fmt.nDither     = -1;
+
+        // Read object
+        while (true)
+        {
+            // Read property name
+            res = p->read_next(&ev);
+            if (res != STATUS_OK)
+                return res;
+            else if (ev.type == json::JE_OBJECT_END)
+                break;
+            else if (ev.type != json::JE_PROPERTY)
+                return STATUS_BAD_FORMAT;
+
+            if (ev.sValue.equals_ascii("container"))
+                res = parse_json_config_enum(&fmt.nContainer, container_flags, p);
+            else if (ev.sValue.equals_ascii("encoding"))
+                res = parse_json_config_enum(&fmt.nEncoding, encoding_flags, p);
+            else if (ev.sValue.equals_ascii("dither"))
+                res = parse_json_config_enum(&fmt.nDither, dither_flags, p);
+            else
+                res = p->skip_current();
+
+            // Analyze result
+            if (res != STATUS_OK)
+                return res;
+        }
+
+        // Apply the format to all selected outputs
+        for (size_t i=0; i<FOUT_TOTAL; ++i)
+        {
+            if (!(outputs & (1 << i)))
+                continue;
+
+            fformat_t *f    = &cfg->vFormat[i];
+            if (fmt.nContainer >= 0)
+                f->nContainer   = fmt.nContainer;
+            if (fmt.nEncoding >= 0)
+                f->nEncoding    = fmt.nEncoding;
+            if (fmt.nDither >= 0)
+                f->nDither      = fmt.nDither;
+        }
+
+        return res;
+    }
+
+    static status_t parse_json_config_formats(config_t *cfg, json::Parser *p)
+    {
+        json::event_t ev;
+
+        // Should be JSON object
+        status_t res = p->read_next(&ev);
+        if (res != STATUS_OK)
+            return res;
+        else if (ev.type != json::JE_OBJECT_START)
+            return STATUS_BAD_TYPE;
+
+        // Read object
+        while (true)
+        {
+            // Read property name
+            res = p->read_next(&ev);
+            if (res != STATUS_OK)
+                return res;
+            else if (ev.type == json::JE_OBJECT_END)
+                break;
+            else if (ev.type != json::JE_PROPERTY)
+                return STATUS_BAD_FORMAT;
+
+            // The name of the property is the kind of the output file
+            const cfg_flag_t *xf = find_config_flag(&ev.sValue, produce_flags);
+            if (xf != NULL)
+                res = parse_json_config_format(cfg, xf->value, p);
+            else
+            {
+                fprintf(stderr, "Warning: unknown output file kind '%s'\n", ev.sValue.get_native());
+                res = p->skip_current();
+            }
+
+            // Analyze result
+            if (res != STATUS_OK)
+                break;
+        }
+
+        return res;
+    }
+
     static status_t parse_json_config_root(config_t *cfg, json::Parser *p)
     {
         json::event_t ev;
@@ -416,6 +809,8 @@ namespace timbremill
                 res = parse_json_config_ir(&cfg->sIR, p);
             else if (ev.sValue.equals_ascii("src_path"))
                 res = parse_json_config_string(&cfg->sSrcPath, p);
+            else if (ev.sValue.equals_ascii("jobs"))
+                res = parse_json_config_string(&cfg->sJobs, p);
             else if (ev.sValue.equals_ascii("dst_path"))
                 res = parse_json_config_string(&cfg->sDstPath, p);
             else if (ev.sValue.equals_ascii("file"))
@@ -426,8 +821,18 @@ namespace timbremill
                 res = parse_json_config_float(&cfg->fGainRange, p);
             else if (ev.sValue.equals_ascii("transition_zone"))
                 res = parse_json_config_float(&cfg->fTransition, p);
+            else if (ev.sValue.equals_ascii("smoothing"))
+                res = parse_json_config_smoothing(&cfg->fSmoothing, p);
             else if (ev.sValue.equals_ascii("fft_rank"))
                 res = parse_json_config_int(&cfg->nFftRank, p);
+            else if (ev.sValue.equals_ascii("grid_points"))
+                res = parse_json_config_int(&cfg->nGrid, p);
+            else if (ev.sValue.equals_ascii("averaging"))
+                res = parse_json_config_enum(&cfg->nAverage, average_flags, p);
+            else if (ev.sValue.equals_ascii("averaging_power"))
+                res = parse_json_config_float(&cfg->fAvgPower, p);
+            else if (ev.sValue.equals_ascii("percentile"))
+                res = parse_json_config_float(&cfg->fPercentile, p);
             else if (ev.sValue.equals_ascii("produce"))
                 res = parse_json_config_flags(&cfg->nProduce, produce_flags, p);
             else if (ev.sValue.equals_ascii("dry"))
@@ -444,6 +849,22 @@ namespace timbremill
                 res = parse_json_config_bool(&cfg->bMatchLength, p);
             else if (ev.sValue.equals_ascii("normalize"))
                 res = parse_json_config_enum(&cfg->nNormalize, normalize_flags, p);
+            else if (ev.sValue.equals_ascii("convolver"))
+                res = parse_json_config_enum(&cfg->nConvolver, convolver_flags, p);
+            else if (ev.sValue.equals_ascii("threads"))
+                res = parse_json_config_int(&cfg->nThreads, p);
+            else if (ev.sValue.equals_ascii("format"))
+                res = parse_json_config_formats(cfg, p);
+            else if (ev.sValue.equals_ascii("encoding"))    // Shorthand for the encoding of the audio format, same as -e
+                res = parse_json_config_enum(&cfg->vFormat[FOUT_AUDIO].nEncoding, encoding_flags, p);
+            else if (ev.sValue.equals_ascii("dither"))      // Shorthand for the dither of the audio format, same as -dt
+                res = parse_json_config_enum(&cfg->vFormat[FOUT_AUDIO].nDither, dither_flags, p);
+            else if (ev.sValue.equals_ascii("profile"))
+                res = parse_json_config_profile(cfg, p);
+            else if (ev.sValue.equals_ascii("memory"))
+                res = parse_json_config_memory(cfg, p);
+            else if (ev.sValue.equals_ascii("discover"))
+                res = parse_json_config_discover(&cfg->sDiscover, p);
             else
                 res = p->skip_current();
 
@@ -483,6 +904,39 @@ namespace timbremill
 
         return res;
     }
-} /* namespace timbremill */
 
+    status_t parse_json_job(fgroup_t *grp, io::IInSequence *is)
+    {
+        json::event_t ev;
+        json::Parser p;
+
+        // Wrap the sequence with wrapper
+        status_t res = p.wrap(is, json::JSON_VERSION5, 0);
+        if (res < 0)
+            return res;
+
+        // Read the group object
+        res = parse_json_config_group(grp, &p, true);
+        if (res == STATUS_OK)
+        {
+            // Ensure for EOF event
+            res = p.read_next(&ev);
+            if (res == STATUS_EOF)
+                res     = STATUS_OK;
+        }
+        if ((res == STATUS_OK) && (grp->sName.is_empty()))
+        {
+            lsp_error("Missing 'name' property of the job");
+            res     = STATUS_BAD_FORMAT;
+        }
+
+        // Close the parser
+        if (res == STATUS_OK)
+            res = p.close();
+        else
+            p.close();
+
+        return res;
+    }
+} /* namespace timbremill */
 
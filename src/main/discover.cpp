@@ -0,0 +1,477 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/io/Dir.h>
+#include <lsp-plug.in/io/Path.h>
+#include <private/discover.h>
+#include <private/workers.h>
+
+namespace timbremill
+{
+    typedef struct glob_scan_t
+    {
+        io::Path                    sDir;       // Directory to scan
+        const LSPString            *pPattern;   // Pattern relative to the directory
+        size_t                      nDepth;     // Maximum number of path elements, 0 = unlimited
+        lltl::parray<LSPString>     vDirs;      // Subdirectories of the first level, one per task
+        lltl::parray<LSPString>    *vFound;     // Files found by each task
+    } glob_scan_t;
+
+    void drop_strings(lltl::parray<LSPString> *list)
+    {
+        for (size_t i=0, n=list->size(); i<n; ++i)
+        {
+            LSPString *s = list->uget(i);
+            if (s != NULL)
+                delete s;
+        }
+        list->flush();
+    }
+
+    static ssize_t compare_file_names(const LSPString *a, const LSPString *b)
+    {
+        return a->compare_to(b);
+    }
+
+    static bool append_path(LSPString *dst, const LSPString *item)
+    {
+        if ((!dst->is_empty()) && (dst->last() != '/'))
+        {
+            if (!dst->append('/'))
+                return false;
+        }
+        return dst->append(item);
+    }
+
+    static bool has_wildcards(const LSPString *s)
+    {
+        return (s->index_of('*') >= 0) || (s->index_of('?') >= 0);
+    }
+
+    static bool has_any_path(const LSPString *s)
+    {
+        for (ssize_t i=0; (i = s->index_of(i, '*')) >= 0; ++i)
+        {
+            if ((size_t(i + 1) < s->length()) && (s->char_at(i + 1) == '*'))
+                return true;
+        }
+        return false;
+    }
+
+    static bool glob_match(const LSPString *p, size_t pi, const LSPString *s, size_t si)
+    {
+        const size_t plen   = p->length();
+        const size_t slen   = s->length();
+
+        while (pi < plen)
+        {
+            lsp_wchar_t c       = p->char_at(pi);
+            if (c == '*')
+            {
+                // '**' matches any number of path elements
+                if ((pi + 1 < plen) && (p->char_at(pi + 1) == '*'))
+                {
+                    pi             += 2;
+                    if (pi >= plen)
+                        return true;
+                    if (p->char_at(pi) == '/')
+                        ++pi;
+
+                    for (size_t k=si; k<=slen; ++k)
+                    {
+                        if ((k != si) && (s->char_at(k - 1) != '/'))
+                            continue;
+                        if (glob_match(p, pi, s, k))
+                            return true;
+                    }
+                    return false;
+                }
+
+                // '*' matches any sequence of characters within the path element
+                ++pi;
+                for (size_t k=si; k<=slen; ++k)
+                {
+                    if (glob_match(p, pi, s, k))
+                        return true;
+                    if ((k < slen) && (s->char_at(k) == '/'))
+                        break;
+                }
+                return false;
+            }
+
+            if (si >= slen)
+                return false;
+            lsp_wchar_t x       = s->char_at(si);
+            if (c == '?')
+            {
+                if (x == '/')
+                    return false;
+            }
+            else if (c != x)
+                return false;
+
+            ++pi;
+            ++si;
+        }
+
+        return si >= slen;
+    }
+
+    bool glob_match(const LSPString *pattern, const LSPString *path)
+    {
+        return glob_match(pattern, 0, path, 0);
+    }
+
+    static status_t scan_directory(
+        glob_scan_t *gs, const LSPString *rel, size_t depth,
+        lltl::parray<LSPString> *found, lltl::parray<LSPString> *subdirs)
+    {
+        io::Path path, child;
+        io::Dir dir;
+        LSPString name;
+
+        status_t res    = (rel->is_empty()) ? path.set(&gs->sDir) : path.set(&gs->sDir, rel);
+        if (res != STATUS_OK)
+            return res;
+        if ((res = dir.open(&path)) != STATUS_OK)
+            return res;
+
+        while ((res = dir.read(&name, false)) == STATUS_OK)
+        {
+            if ((name.equals_ascii(".")) || (name.equals_ascii("..")))
+                continue;
+
+            // Form the name of the item relative to the scanned directory
+            LSPString *item = new LSPString();
+            if ((item == NULL) || (!item->set(rel)) || (!append_path(item, &name)))
+            {
+                if (item != NULL)
+                    delete item;
+                res     = STATUS_NO_MEM;
+                break;
+            }
+            if ((res = child.set(&path, &name)) != STATUS_OK)
+            {
+                delete item;
+                break;
+            }
+
+            if (child.is_dir())
+            {
+                // Do not descend deeper than the pattern allows
+                if ((gs->nDepth > 0) && (depth + 1 >= gs->nDepth))
+                {
+                    delete item;
+                    continue;
+                }
+
+                // Subdirectories of the first level are scanned by separate tasks
+                if (subdirs != NULL)
+                {
+                    if (!subdirs->add(item))
+                    {
+                        delete item;
+                        res     = STATUS_NO_MEM;
+                        break;
+                    }
+                    continue;
+                }
+
+                res     = scan_directory(gs, item, depth + 1, found, NULL);
+                delete item;
+                if (res != STATUS_OK)
+                    break;
+            }
+            else if (glob_match(gs->pPattern, item))
+            {
+                if (!found->add(item))
+                {
+                    delete item;
+                    res     = STATUS_NO_MEM;
+                    break;
+                }
+            }
+            else
+                delete item;
+        }
+
+        dir.close();
+
+        return (res == STATUS_EOF) ? STATUS_OK : res;
+    }
+
+    static status_t glob_scan_task(void *arg, size_t index, size_t worker)
+    {
+        glob_scan_t *gs = static_cast<glob_scan_t *>(arg);
+        return scan_directory(gs, gs->vDirs.uget(index), 1, &gs->vFound[index], NULL);
+    }
+
+    static status_t glob_scan(lltl::parray<LSPString> *found, glob_scan_t *gs, size_t threads)
+    {
+        LSPString empty;
+
+        // Scan the first level, the subdirectories are scanned in parallel
+        status_t res    = scan_directory(gs, &empty, 0, found, &gs->vDirs);
+        if (res == STATUS_NOT_FOUND)
+            return STATUS_OK;
+        if ((res != STATUS_OK) || (gs->vDirs.is_empty()))
+            return res;
+
+        size_t count    = gs->vDirs.size();
+        gs->vFound      = new lltl::parray<LSPString>[count];
+        if (gs->vFound == NULL)
+            return STATUS_NO_MEM;
+
+        res             = run_parallel(glob_scan_task, gs, count, threads);
+
+        // Collect the results of all tasks
+        for (size_t i=0; i<count; ++i)
+        {
+            lltl::parray<LSPString> *list = &gs->vFound[i];
+            if ((res == STATUS_OK) && (!found->add(list)))
+                res             = STATUS_NO_MEM;
+            if (res == STATUS_OK)
+                list->flush();
+            else
+                drop_strings(list);
+        }
+
+        return res;
+    }
+
+    status_t glob_files(
+        lltl::parray<LSPString> *files,
+        const LSPString *root, const LSPString *base, const LSPString *pattern,
+        size_t threads)
+    {
+        LSPString prefix, item, sub;
+        io::Path path;
+        status_t res;
+
+        // Take the literal leading elements of the pattern as the directory to scan,
+        // the last element is always matched against the directory contents
+        if ((base != NULL) && (!prefix.set(base)))
+            return STATUS_NO_MEM;
+
+        size_t pos      = 0;
+        if (pattern->first() == '/')
+        {
+            if (!prefix.set_ascii("/"))
+                return STATUS_NO_MEM;
+            pos             = 1;
+        }
+
+        for (ssize_t end; (end = pattern->index_of(pos, '/')) >= 0; pos = end + 1)
+        {
+            if (!item.set(pattern, pos, end))
+                return STATUS_NO_MEM;
+            if (has_wildcards(&item))
+                break;
+            if ((!item.is_empty()) && (!append_path(&prefix, &item)))
+                return STATUS_NO_MEM;
+        }
+        if (!sub.set(pattern, pos))
+            return STATUS_NO_MEM;
+
+        // Compute the directory to scan
+        if ((res = path.set(&prefix)) != STATUS_OK)
+            return res;
+        if ((!path.is_absolute()) && (!root->is_empty()))
+        {
+            res = (prefix.is_empty()) ? path.set(root) : path.set(root, &prefix);
+            if (res != STATUS_OK)
+                return res;
+        }
+        else if (path.is_empty())
+        {
+            if ((res = path.set(".")) != STATUS_OK)
+                return res;
+        }
+
+        // The depth of the scan is limited by the pattern unless it contains '**'
+        glob_scan_t gs;
+        if ((res = gs.sDir.set(&path)) != STATUS_OK)
+            return res;
+        gs.pPattern     = &sub;
+        gs.nDepth       = 0;
+        gs.vFound       = NULL;
+        if (!has_any_path(&sub))
+        {
+            gs.nDepth       = 1;
+            for (ssize_t i=0; (i = sub.index_of(i, '/')) >= 0; ++i)
+                ++gs.nDepth;
+        }
+
+        lltl::parray<LSPString> found;
+        res             = glob_scan(&found, &gs, threads);
+        drop_strings(&gs.vDirs);
+        if (gs.vFound != NULL)
+            delete [] gs.vFound;
+
+        // Make the names relative to the root directory and sort them
+        for (size_t i=0, n=found.size(); (res == STATUS_OK) && (i<n); ++i)
+        {
+            LSPString *s    = found.uget(i);
+            if ((!item.set(&prefix)) || (!append_path(&item, s)))
+                res             = STATUS_NO_MEM;
+            else
+                s->swap(&item);
+        }
+        if (res == STATUS_OK)
+        {
+            found.qsort(compare_file_names);
+            if (files->add(&found))
+                found.flush();
+            else
+                res             = STATUS_NO_MEM;
+        }
+        drop_strings(&found);
+
+        return res;
+    }
+
+    status_t discover_groups(config_t *cfg)
+    {
+        const discover_t *d = &cfg->sDiscover;
+        if (!d->bEnabled)
+            return STATUS_OK;
+
+        io::Path path, child;
+        io::Dir dir;
+        LSPString name;
+        status_t res;
+
+        // Compute the directory with the groups
+        if ((res = path.set(&d->sPath)) != STATUS_OK)
+            return res;
+        if ((!path.is_absolute()) && (!cfg->sSrcPath.is_empty()))
+        {
+            res = (d->sPath.is_empty()) ? path.set(&cfg->sSrcPath) : path.set(&cfg->sSrcPath, &d->sPath);
+            if (res != STATUS_OK)
+                return res;
+        }
+
+        if ((res = dir.open(&path)) != STATUS_OK)
+        {
+            fprintf(stderr, "  could not open directory '%s' for discovery of groups\n", path.as_native());
+            return res;
+        }
+
+        // Each subdirectory forms the group, the files are resolved when the group is processed
+        size_t count    = 0;
+        while ((res = dir.read(&name, false)) == STATUS_OK)
+        {
+            if ((name.equals_ascii(".")) || (name.equals_ascii("..")))
+                continue;
+            if ((res = child.set(&path, &name)) != STATUS_OK)
+                break;
+            if (!child.is_dir())
+                continue;
+
+            // Groups specified explicitly take precedence
+            if (cfg->vGroups.contains(&name))
+                continue;
+
+            fgroup_t *fg    = new fgroup_t();
+            if (fg == NULL)
+            {
+                res     = STATUS_NO_MEM;
+                break;
+            }
+            if ((!fg->sName.set(&name)) ||
+                (!fg->sGlobBase.set(&d->sPath)) ||
+                (!append_path(&fg->sGlobBase, &name)) ||
+                (!fg->sMasterGlob.set(&d->sMaster)) ||
+                (!fg->sGlob.set(&d->sFiles)) ||
+                (!cfg->vGroups.create(&fg->sName, fg)))
+            {
+                delete fg;
+                res     = STATUS_NO_MEM;
+                break;
+            }
+
+            ++count;
+        }
+
+        dir.close();
+        if (res != STATUS_EOF)
+            return res;
+
+        // The standard output may be taken by the JSON plan
+        FILE *log   = (cfg->sPlan.equals_ascii("-")) ? stderr : stdout;
+        fprintf(log, "discovered %d groups in '%s'\n", int(count), path.as_native());
+
+        return STATUS_OK;
+    }
+
+    status_t resolve_group_files(const config_t *cfg, fgroup_t *fg, size_t threads)
+    {
+        lltl::parray<LSPString> found;
+        const LSPString *base   = (fg->sGlobBase.is_empty()) ? NULL : &fg->sGlobBase;
+        status_t res;
+
+        // The master file is the first matching file in the sorted order
+        if ((fg->sMaster.is_empty()) && (!fg->sMasterGlob.is_empty()))
+        {
+            res     = glob_files(&found, &cfg->sSrcPath, base, &fg->sMasterGlob, threads);
+            if ((res == STATUS_OK) && (!found.is_empty()))
+                fg->sMaster.swap(found.uget(0));
+            drop_strings(&found);
+            if (res != STATUS_OK)
+                return res;
+        }
+
+        if (fg->sGlob.is_empty())
+            return STATUS_OK;
+
+        // Resolve the child files, the master file is never processed as the child
+        if ((res = glob_files(&found, &cfg->sSrcPath, base, &fg->sGlob, threads)) != STATUS_OK)
+        {
+            drop_strings(&found);
+            return res;
+        }
+
+        for (size_t i=0, n=found.size(); i<n; ++i)
+        {
+            LSPString *s    = found.uget(i);
+            if (s->equals(&fg->sMaster))
+                continue;
+            if (!fg->vFiles.add(s))
+            {
+                res             = STATUS_NO_MEM;
+                break;
+            }
+            found.set(i, NULL);
+        }
+        drop_strings(&found);
+
+        return res;
+    }
+
+    void release_group_files(fgroup_t *fg)
+    {
+        if (fg->sGlob.is_empty())
+            return;
+
+        drop_strings(&fg->vFiles);
+    }
+} /* namespace timbremill */
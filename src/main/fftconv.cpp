@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/common/atomic.h>
+#include <lsp-plug.in/dsp/dsp.h>
+#include <private/fftconv.h>
+#include <private/kernels.h>
+
+namespace timbremill
+{
+    double fft_convolution_cost(size_t length, size_t ir_length, size_t rank)
+    {
+        size_t out_len  = length + ir_length;
+        size_t fft_size = 1 << rank;
+        size_t part     = fft_size >> 1;
+        size_t parts    = lsp_max((ir_length + part - 1) / part, size_t(1));
+        size_t blocks   = (out_len + part - 1) / part;
+
+        // Each block requires direct and reverse FFT and the complex multiplication for each
+        // partition, each partition of the impulse response is transformed once
+        return double(blocks) * fft_size * (5.0 * rank + 8.0 * parts) +
+               double(parts) * fft_size * 2.5 * rank;
+    }
+
+    size_t fft_convolution_rank(size_t length, size_t ir_length)
+    {
+        size_t rank     = FFT_CONV_MIN_RANK;
+        double cost     = -1.0;
+
+        for (size_t r=FFT_CONV_MIN_RANK; r<=FFT_CONV_MAX_RANK; ++r)
+        {
+            double c        = fft_convolution_cost(length, ir_length, r);
+            if ((cost < 0.0) || (c < cost))
+            {
+                rank            = r;
+                cost            = c;
+            }
+        }
+
+        return rank;
+    }
+
+    ir_spectrum_t *create_ir_spectrum(const dspu::Sample *ir, size_t rank)
+    {
+        size_t fft_size = 1 << rank;
+        size_t part     = fft_size >> 1;
+        size_t length   = ir->length();
+        size_t channels = ir->channels();
+        size_t parts    = lsp_max((length + part - 1) / part, size_t(1));
+
+        // Allocate the memory for the descriptor and all spectra
+        ir_spectrum_t *res  = new ir_spectrum_t;
+        if (res == NULL)
+            return NULL;
+
+        uint8_t *ptr    = NULL;
+        float *spc      = alloc_aligned<float>(ptr, channels * parts * fft_size * 2, 64);
+        if (spc == NULL)
+        {
+            delete res;
+            return NULL;
+        }
+
+        // Transform each partition of the impulse response
+        float *dst      = spc;
+        for (size_t i=0; i<channels; ++i)
+        {
+            const float *chan   = ir->channel(i);
+            for (size_t j=0; j<parts; ++j, dst += fft_size * 2)
+            {
+                size_t off      = j * part;
+                size_t count    = (off < length) ? lsp_min(part, length - off) : 0;
+
+                dsp::pcomplex_r2c(dst, &chan[off], count);
+                dsp::fill_zero(&dst[count * 2], (fft_size - count) * 2);
+                dsp::packed_direct_fft(dst, dst, rank);
+            }
+        }
+
+        // Store the result
+        res->nRank          = rank;
+        res->nPartSize      = part;
+        res->nParts         = parts;
+        res->nChannels      = channels;
+        res->nLength        = length;
+        res->vSpectrum      = spc;
+        res->pData          = ptr;
+        res->nReferences    = 1;
+
+        return res;
+    }
+
+    ir_spectrum_t *acquire_ir_spectrum(ir_spectrum_t *spc)
+    {
+        atomic_add(&spc->nReferences, 1);
+        return spc;
+    }
+
+    void release_ir_spectrum(ir_spectrum_t *spc)
+    {
+        if (spc == NULL)
+            return;
+        if (atomic_add(&spc->nReferences, -1) > 1)
+            return;
+
+        free_aligned(spc->pData);
+        delete spc;
+    }
+
+    status_t fft_convolve(float *dst, const float *src, size_t length, const ir_spectrum_t *spc, size_t channel, arena_t *arena)
+    {
+        arena_t local;
+        if (arena == NULL)
+            arena           = &local;
+
+        size_t rank     = spc->nRank;
+        size_t part     = spc->nPartSize;
+        size_t parts    = spc->nParts;
+        size_t fft_size = part << 1;
+        size_t fft_csz  = fft_size * 2;
+        size_t out_len  = length + spc->nLength;
+        size_t blocks   = (out_len + part - 1) / part;
+        const float *h  = &spc->vSpectrum[channel * parts * fft_csz];
+
+        // Allocate the frequency-domain delay line, the accumulator and the overlap buffer
+        float *fdl      = arena_borrow(arena, (parts + 1) * fft_csz + fft_size + part);
+        if (fdl == NULL)
+            return STATUS_NO_MEM;
+        float *acc      = &fdl[parts * fft_csz];
+        float *tmp      = &acc[fft_csz];
+        float *ovl      = &tmp[fft_size];
+        dsp::fill_zero(ovl, part);
+
+        for (size_t b=0; b<blocks; ++b)
+        {
+            // Transform the next block of the input signal, the delay line is a ring buffer
+            size_t off      = b * part;
+            size_t count    = (off < length) ? lsp_min(part, length - off) : 0;
+            float *x        = &fdl[(b % parts) * fft_csz];
+            if (count > 0)
+            {
+                dsp::pcomplex_r2c(x, &src[off], count);
+                dsp::fill_zero(&x[count * 2], (fft_size - count) * 2);
+                dsp::packed_direct_fft(x, x, rank);
+            }
+            else
+                dsp::fill_zero(x, fft_csz);
+
+            // Multiply the delayed input spectra by the spectra of the partitions
+            dsp::fill_zero(acc, fft_csz);
+            for (size_t j=0, n=lsp_min(parts, b + 1); j<n; ++j)
+                pcomplex_fmadd3(acc, &fdl[((b - j) % parts) * fft_csz], &h[j * fft_csz], fft_size);
+
+            // Transform back and apply overlap-add
+            dsp::packed_reverse_fft(acc, acc, rank);
+            dsp::pcomplex_c2r(tmp, acc, fft_size);
+            count           = lsp_min(part, out_len - off);
+            dsp::add3(&dst[off], tmp, ovl, count);
+            dsp::copy(ovl, &tmp[part], part);
+        }
+
+        arena_return(arena, fdl);
+
+        return STATUS_OK;
+    }
+} /* namespace timbremill */
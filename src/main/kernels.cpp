@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <private/kernels.h>
+#include <lsp-plug.in/stdlib/math.h>
+
+#define HISTOGRAM_CHUNK         256
+
+namespace timbremill
+{
+    void rcp_floor2(float *dst, const float *src, float floor, size_t count)
+    {
+        for (size_t i=0; i<count; ++i)
+        {
+            float s     = src[i];
+            dst[i]      = 1.0f / ((s > floor) ? s : floor);
+        }
+    }
+
+    void mul_limit3(float *dst, const float *a, const float *b, float min, float max, size_t count)
+    {
+        for (size_t i=0; i<count; ++i)
+        {
+            float v     = a[i] * b[i];
+            v           = (v > min) ? v : min;
+            dst[i]      = (v < max) ? v : max;
+        }
+    }
+
+    void div_limit3(float *dst, const float *a, const float *b, float floor, float min, float max, size_t count)
+    {
+        for (size_t i=0; i<count; ++i)
+        {
+            float d     = b[i];
+            float v     = a[i] / ((d > floor) ? d : floor);
+            v           = (v > min) ? v : min;
+            dst[i]      = (v < max) ? v : max;
+        }
+    }
+
+    void pcomplex_fmadd3(float *dst, const float *a, const float *b, size_t count)
+    {
+        for (size_t i=0; i<count; ++i, dst += 2, a += 2, b += 2)
+        {
+            float re    = a[0] * b[0] - a[1] * b[1];
+            float im    = a[0] * b[1] + a[1] * b[0];
+            dst[0]     += re;
+            dst[1]     += im;
+        }
+    }
+
+    void octave_smooth2(float *dst, const float *src, float width, size_t count)
+    {
+        if (count == 0)
+            return;
+
+        float kl        = exp2f(-0.5f * width);
+        float kh        = exp2f(0.5f * width);
+        double sum      = 0.0;          // The sum of elements in the window [lo, hi)
+        size_t lo       = 1, hi = 1;
+
+        dst[0]          = src[0];
+        for (size_t k=1; k<count; ++k)
+        {
+            size_t l        = lsp_max(size_t(k * kl + 0.5f), size_t(1));
+            size_t h        = lsp_min(size_t(k * kh + 0.5f) + 1, count);
+
+            for ( ; hi < h; ++hi)
+                sum            += src[hi];
+            for ( ; lo < l; ++lo)
+                sum            -= src[lo];
+
+            dst[k]          = float(sum / double(hi - lo));
+        }
+    }
+
+    static inline float band_center(const size_t *edges, size_t j)
+    {
+        return 0.5f * float(edges[j] + edges[j+1] - 1);
+    }
+
+    void octave_smooth_grid2(float *dst, const float *src, const size_t *edges, float width, size_t points)
+    {
+        if (points == 0)
+            return;
+
+        float kl        = exp2f(-0.5f * width);
+        float kh        = exp2f(0.5f * width);
+        double sum      = 0.0;          // The weighted sum of points in the window [lo, hi)
+        double weight   = 0.0;          // The number of bins in the window [lo, hi)
+        size_t lo       = 1, hi = 1;
+
+        dst[0]          = src[0];
+        for (size_t j=1; j<points; ++j)
+        {
+            float c         = band_center(edges, j);
+            float fl        = c * kl;
+            float fh        = c * kh;
+
+            for ( ; (hi < points) && (band_center(edges, hi) <= fh); ++hi)
+            {
+                double w        = double(edges[hi+1] - edges[hi]);
+                sum            += src[hi] * w;
+                weight         += w;
+            }
+            for ( ; (lo < j) && (band_center(edges, lo) < fl); ++lo)
+            {
+                double w        = double(edges[lo+1] - edges[lo]);
+                sum            -= src[lo] * w;
+                weight         -= w;
+            }
+
+            dst[j]          = float(sum / weight);
+        }
+    }
+
+    void band_mean2(float *dst, const float *src, const size_t *edges, size_t points)
+    {
+        for (size_t j=0; j<points; ++j)
+        {
+            size_t first    = edges[j];
+            size_t last     = edges[j+1];
+            float sum       = 0.0f;
+            for (size_t k=first; k<last; ++k)
+                sum            += src[k];
+            dst[j]          = sum / float(last - first);
+        }
+    }
+
+    void grid_expand2(float *dst, const float *src, const size_t *edges, size_t points)
+    {
+        if (points == 0)
+            return;
+
+        size_t count    = edges[points];
+        size_t j        = 0;
+        float c0        = band_center(edges, 0);
+        float c1        = (points > 1) ? band_center(edges, 1) : c0;
+
+        for (size_t k=0; k<count; ++k)
+        {
+            // Find the pair of centers around the bin
+            float x         = float(k);
+            while ((j + 1 < points) && (c1 <= x))
+            {
+                c0              = c1;
+                ++j;
+                c1              = (j + 1 < points) ? band_center(edges, j + 1) : c0;
+            }
+
+            if ((x <= c0) || (j + 1 >= points))
+                dst[k]          = src[j];
+            else
+                dst[k]          = src[j] + (src[j+1] - src[j]) * (x - c0) / (c1 - c0);
+        }
+    }
+
+    void histogram_add(float *hist, const float *src, float base, float scale, size_t buckets, size_t count)
+    {
+        uint32_t idx[HISTOGRAM_CHUNK];
+        float top       = float(buckets - 1);
+
+        for (size_t off=0; off<count; off += HISTOGRAM_CHUNK)
+        {
+            size_t n        = lsp_min(count - off, size_t(HISTOGRAM_CHUNK));
+            const float *s  = &src[off];
+            float *h        = &hist[off];
+
+            // Compute offsets of counters, this loop is vectorized
+            for (size_t i=0; i<n; ++i)
+            {
+                float v     = (s[i] - base) * scale;
+                v           = (v > 0.0f) ? v : 0.0f;
+                v           = (v < top) ? v : top;
+                idx[i]      = uint32_t(v) * count + i;
+            }
+
+            // Increment counters
+            for (size_t i=0; i<n; ++i)
+                h[idx[i]]  += 1.0f;
+        }
+    }
+
+    void histogram_quantile(float *dst, float *cum, const float *hist, float rank, size_t buckets, size_t count)
+    {
+        // The values which are not found are above the last bucket
+        for (size_t i=0; i<count; ++i)
+        {
+            cum[i]      = 0.0f;
+            dst[i]      = float(buckets);
+        }
+
+        // Walk buckets of all elements at once
+        for (size_t b=0; b<buckets; ++b, hist += count)
+        {
+            float fb    = float(b);
+            for (size_t i=0; i<count; ++i)
+            {
+                float h     = hist[i];
+                float c0    = cum[i];
+                float c1    = c0 + h;
+                float v     = fb + (rank - c0) / ((h > 0.0f) ? h : 1.0f);
+                dst[i]      = ((c0 <= rank) && (c1 > rank)) ? v : dst[i];
+                cum[i]      = c1;
+            }
+        }
+    }
+} /* namespace timbremill */
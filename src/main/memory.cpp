@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <private/config/data.h>
+#include <private/memory.h>
+
+#include <stdlib.h>
+
+#ifdef PLATFORM_LINUX
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+
+    // Constants of the kernel memory policy interface
+    #ifndef MPOL_PREFERRED
+        #define MPOL_PREFERRED          1
+    #endif /* MPOL_PREFERRED */
+    #ifndef MPOL_INTERLEAVE
+        #define MPOL_INTERLEAVE         3
+    #endif /* MPOL_INTERLEAVE */
+    #ifndef MPOL_MF_MOVE
+        #define MPOL_MF_MOVE            (1 << 1)
+    #endif /* MPOL_MF_MOVE */
+#endif /* PLATFORM_LINUX */
+
+#define NUMA_MAX_NODES          64
+#define NUMA_MASK_BITS          (sizeof(unsigned long) * 8 + 1)    // The kernel expects one more bit than used
+
+namespace timbremill
+{
+    typedef struct mempolicy_t
+    {
+        bool            bHugePages;                 // Use huge pages
+        ssize_t         nNuma;                      // NUMA memory placement policy
+        size_t          nNodes;                     // Number of NUMA nodes
+        size_t          vNodes[NUMA_MAX_NODES];     // Identifiers of NUMA nodes
+    #ifdef PLATFORM_LINUX
+        cpu_set_t       vCpus[NUMA_MAX_NODES];      // CPUs of NUMA nodes
+        cpu_set_t       sAffinity;                  // Original CPU affinity of the process
+    #endif /* PLATFORM_LINUX */
+    } mempolicy_t;
+
+    static mempolicy_t  policy;
+
+#ifdef PLATFORM_LINUX
+    static bool read_line(char *buf, size_t size, const char *path)
+    {
+        FILE *fd    = fopen(path, "r");
+        if (fd == NULL)
+            return false;
+        bool res    = fgets(buf, size, fd) != NULL;
+        fclose(fd);
+
+        return res;
+    }
+
+    /**
+     * Parse the list of identifiers in the format of sysfs, for example "0-3,8,10-11"
+     */
+    static size_t parse_id_list(size_t *dst, size_t max, const char *list)
+    {
+        size_t count    = 0;
+        while (true)
+        {
+            char *end       = NULL;
+            size_t first    = strtoul(list, &end, 10);
+            if (end == list)
+                break;
+            size_t last     = first;
+            list            = end;
+            if (*list == '-')
+            {
+                last            = strtoul(++list, &end, 10);
+                if (end == list)
+                    break;
+                list            = end;
+            }
+
+            for (size_t id=first; (id <= last) && (count < max); ++id)
+                dst[count++]    = id;
+            if (*list != ',')
+                break;
+            ++list;
+        }
+
+        return count;
+    }
+
+    static bool read_node_cpus(cpu_set_t *set, size_t node)
+    {
+        char path[128], buf[4096];
+        size_t ids[CPU_SETSIZE];
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", int(node));
+        if (!read_line(buf, sizeof(buf), path))
+            return false;
+
+        // Use only CPUs allowed for the process
+        CPU_ZERO(set);
+        for (size_t i=0, n=parse_id_list(ids, CPU_SETSIZE, buf); i<n; ++i)
+            CPU_SET(ids[i], set);
+        CPU_AND(set, set, &policy.sAffinity);
+
+        return CPU_COUNT(set) > 0;
+    }
+
+    static void init_numa_policy(ssize_t numa)
+    {
+        char buf[4096];
+
+        // Read the list of NUMA nodes, there is nothing to do for the single node
+        if (!read_line(buf, sizeof(buf), "/sys/devices/system/node/online"))
+            return;
+        size_t nodes    = parse_id_list(policy.vNodes, NUMA_MAX_NODES, buf);
+        if (nodes <= 1)
+            return;
+
+        if (numa == NUMA_INTERLEAVE)
+        {
+            // Interleave pages of all further allocations between all nodes
+            unsigned long mask  = 0;
+            for (size_t i=0; i<nodes; ++i)
+            {
+                if (policy.vNodes[i] < sizeof(mask) * 8)
+                    mask               |= 1UL << policy.vNodes[i];
+            }
+
+            if (syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, NUMA_MASK_BITS) != 0)
+            {
+                fprintf(stderr, "  warning: could not set interleaved NUMA memory policy\n");
+                return;
+            }
+        }
+        else if (numa == NUMA_LOCAL)
+        {
+            // Collect the CPUs of each node
+            if (sched_getaffinity(0, sizeof(cpu_set_t), &policy.sAffinity) != 0)
+                return;
+
+            size_t count    = 0;
+            for (size_t i=0; i<nodes; ++i)
+            {
+                if (!read_node_cpus(&policy.vCpus[count], policy.vNodes[i]))
+                    continue;
+                policy.vNodes[count++]  = policy.vNodes[i];
+            }
+            if (count <= 1)
+                return;
+            nodes           = count;
+        }
+        else
+            return;
+
+        policy.nNodes   = nodes;
+        policy.nNuma    = numa;
+    }
+#endif /* PLATFORM_LINUX */
+
+    status_t set_memory_policy(bool huge_pages, ssize_t numa)
+    {
+        policy.bHugePages   = huge_pages;
+        policy.nNuma        = NUMA_NONE;
+        policy.nNodes       = 0;
+
+    #ifdef PLATFORM_LINUX
+        if (numa != NUMA_NONE)
+            init_numa_policy(numa);
+    #endif /* PLATFORM_LINUX */
+
+        return STATUS_OK;
+    }
+
+    size_t memory_alignment(size_t bytes, size_t align)
+    {
+        if ((!policy.bHugePages) || (bytes < HUGE_PAGE_THRESHOLD))
+            return align;
+        return lsp_max(align, size_t(HUGE_PAGE_SIZE));
+    }
+
+    void advise_memory(void *ptr, size_t bytes)
+    {
+    #if defined(PLATFORM_LINUX) && defined(MADV_HUGEPAGE)
+        if (!policy.bHugePages)
+            return;
+
+        uintptr_t first     = (uintptr_t(ptr) + HUGE_PAGE_SIZE - 1) & ~uintptr_t(HUGE_PAGE_SIZE - 1);
+        uintptr_t last      = (uintptr_t(ptr) + bytes) & ~uintptr_t(HUGE_PAGE_SIZE - 1);
+        if (last > first)
+            madvise(reinterpret_cast<void *>(first), last - first, MADV_HUGEPAGE);
+    #endif /* PLATFORM_LINUX */
+    }
+
+    void localize_memory(void *ptr, size_t bytes)
+    {
+    #ifdef PLATFORM_LINUX
+        if (policy.nNuma != NUMA_LOCAL)
+            return;
+
+        unsigned int cpu = 0, node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0)
+            return;
+
+        uintptr_t page      = sysconf(_SC_PAGESIZE);
+        uintptr_t first     = (uintptr_t(ptr) + page - 1) & ~(page - 1);
+        uintptr_t last      = (uintptr_t(ptr) + bytes) & ~(page - 1);
+        unsigned long mask  = 1UL << node;
+        if ((last > first) && (node < sizeof(mask) * 8))
+            syscall(SYS_mbind, first, last - first, MPOL_PREFERRED, &mask, NUMA_MASK_BITS, MPOL_MF_MOVE);
+    #endif /* PLATFORM_LINUX */
+    }
+
+    void pin_worker(size_t worker)
+    {
+    #ifdef PLATFORM_LINUX
+        if ((policy.nNuma != NUMA_LOCAL) || (policy.nNodes <= 0))
+            return;
+        sched_setaffinity(0, sizeof(cpu_set_t), &policy.vCpus[worker % policy.nNodes]);
+    #endif /* PLATFORM_LINUX */
+    }
+
+    void unpin_worker()
+    {
+    #ifdef PLATFORM_LINUX
+        if (policy.nNuma != NUMA_LOCAL)
+            return;
+        sched_setaffinity(0, sizeof(cpu_set_t), &policy.sAffinity);
+    #endif /* PLATFORM_LINUX */
+    }
+} /* namespace timbremill */
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <private/naming.h>
+
+namespace timbremill
+{
+    naming_t::naming_t()
+    {
+        pOutputs    = NULL;
+    }
+
+    naming_t::~naming_t()
+    {
+        clear();
+    }
+
+    void naming_t::clear()
+    {
+        lltl::parray<expr::Expression> templates;
+        vTemplates.values(&templates);
+        vTemplates.flush();
+        for (size_t i=0, n=templates.size(); i<n; ++i)
+        {
+            expr::Expression *x = templates.uget(i);
+            if (x != NULL)
+                delete x;
+        }
+        templates.flush();
+
+        lltl::parray<LSPString> dirs;
+        vDirs.values(&dirs);
+        vDirs.flush();
+        for (size_t i=0, n=dirs.size(); i<n; ++i)
+        {
+            LSPString *dir = dirs.uget(i);
+            if (dir != NULL)
+                delete dir;
+        }
+        dirs.flush();
+    }
+
+    status_t compile_file_name(naming_t *naming, const LSPString *fmt, expr::Expression **x)
+    {
+        // Lookup for already compiled template
+        expr::Expression *res = naming->vTemplates.get(fmt);
+        if (res == NULL)
+        {
+            // Parse the expression
+            if ((res = new expr::Expression()) == NULL)
+                return STATUS_NO_MEM;
+            if (res->parse(fmt, expr::Expression::FLAG_STRING) != STATUS_OK)
+            {
+                delete res;
+                fprintf(stderr, "  invalid expression: '%s'\n", fmt->get_native());
+                return STATUS_BAD_FORMAT;
+            }
+            if (!naming->vTemplates.create(fmt, res))
+            {
+                delete res;
+                return STATUS_NO_MEM;
+            }
+        }
+
+        if (x != NULL)
+            *x = res;
+
+        return STATUS_OK;
+    }
+
+    static status_t create_parent_directory(naming_t *naming, const io::Path *path, const LSPString *fname)
+    {
+        status_t res;
+        io::Path dir;
+
+        res = path->get_parent(&dir);
+        if (res == STATUS_NOT_FOUND)
+            return STATUS_OK;
+        else if (res != STATUS_OK)
+        {
+            fprintf(stderr, "  could not obtain parent directory for file '%s', error code: %d\n", fname->get_native(), int(res));
+            return res;
+        }
+
+        // Create parent directory recursively only once
+        if (naming->vDirs.contains(dir.as_string()))
+            return STATUS_OK;
+        if ((res = dir.mkdir(true)) != STATUS_OK)
+        {
+            fprintf(stderr, "  could not create directory '%s', error code: %d\n", dir.as_native(), int(res));
+            return res;
+        }
+
+        LSPString *name = dir.as_string()->clone();
+        if (name == NULL)
+            return STATUS_NO_MEM;
+        if (!naming->vDirs.create(name))
+        {
+            delete name;
+            return STATUS_NO_MEM;
+        }
+
+        return STATUS_OK;
+    }
+
+    status_t output_file_name(io::Path *path, naming_t *naming, const LSPString *fmt, expr::Resolver *vars)
+    {
+        status_t res;
+        expr::Expression *x;
+        expr::value_t val;
+        LSPString fname;
+
+        // Obtain the compiled template
+        if ((res = compile_file_name(naming, fmt, &x)) != STATUS_OK)
+            return res;
+
+        // Evaluate the expression and cast to string
+        expr::init_value(&val);
+        x->set_resolver(vars);
+        if ((res = x->evaluate(&val)) == STATUS_OK)
+            res = expr::cast_string(&val);
+        x->set_resolver(NULL);
+        if (res != STATUS_OK)
+        {
+            expr::destroy_value(&val);
+            fprintf(stderr, "  could not evaluate expression: '%s'\n", fmt->get_native());
+            return STATUS_BAD_FORMAT;
+        }
+        fname.swap(val.v_str);
+        expr::destroy_value(&val);
+
+        // Generate file name
+        if ((res = path->set(&fname)) != STATUS_OK)
+        {
+            fprintf(stderr, "  could not write file '%s', error code: %d\n", fname.get_native(), int(res));
+            return res;
+        }
+        if (!path->is_absolute())
+        {
+            if ((res = path->set(&naming->sBase, &fname)) != STATUS_OK)
+            {
+                fprintf(stderr, "  could not write file '%s', error code: %d\n", fname.get_native(), int(res));
+                return res;
+            }
+        }
+
+        return STATUS_OK;
+    }
+
+    status_t output_file_path(io::Path *path, naming_t *naming, const LSPString *fmt, expr::Resolver *vars)
+    {
+        status_t res = output_file_name(path, naming, fmt, vars);
+        if (res != STATUS_OK)
+            return res;
+
+        if ((res = create_parent_directory(naming, path, path->as_string())) != STATUS_OK)
+            return res;
+
+        if (naming->pOutputs != NULL)
+        {
+            LSPString *name = path->as_string()->clone();
+            if ((name == NULL) || (!naming->pOutputs->add(name)))
+            {
+                if (name != NULL)
+                    delete name;
+                return STATUS_NO_MEM;
+            }
+        }
+
+        return STATUS_OK;
+    }
+} /* namespace timbremill */
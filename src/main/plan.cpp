@@ -0,0 +1,577 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/expr/Variables.h>
+#include <lsp-plug.in/io/InSequence.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/lltl/parray.h>
+#include <lsp-plug.in/lltl/phashset.h>
+#include <private/audio.h>
+#include <private/discover.h>
+#include <private/fftconv.h>
+#include <private/plan.h>
+#include <private/tool.h>
+#include <private/workers.h>
+
+#include <stdarg.h>
+
+#define PLAN_VERSION        1
+
+namespace timbremill
+{
+    typedef struct plan_input_t
+    {
+        bool                        bFound;     // The header of the file has been read
+        size_t                      nChannels;  // Number of channels
+        size_t                      nSampleRate;// Original sample rate
+        wsize_t                     nFrames;    // Number of frames at the original sample rate
+        wsize_t                     nLength;    // Number of frames at the output sample rate
+    } plan_input_t;
+
+    typedef struct plan_cost_t
+    {
+        double                      fAnalysis;  // Operations for computing the spectral profiles
+        double                      fIR;        // Operations for computing the impulse responses
+        double                      fRender;    // Operations for rendering the processed audio
+        wsize_t                     nMemory;    // Peak memory (bytes)
+    } plan_cost_t;
+
+    typedef struct plan_t
+    {
+        config_t                   *pConfig;    // Configuration
+        FILE                       *pOut;       // Output of the JSON plan
+        FILE                       *pLog;       // Output of the messages
+        naming_t                    sNaming;    // Compiled templates of output file names
+        lltl::phashset<LSPString>   vNames;     // Names of all output files of the batch
+        lltl::parray<LSPString>     vOutputs;   // Output files of the current item
+        lltl::parray<LSPString>     vIssues;    // Issues of the current item
+        size_t                      nRank;      // FFT rank
+        size_t                      nThreads;   // Number of worker threads
+        size_t                      nGroups;    // Number of planned groups
+        size_t                      nTasks;     // Number of planned tasks
+        size_t                      nIssues;    // Number of found issues
+        double                      fFlops;     // Overall number of operations
+        wsize_t                     nPeak;      // The maximum peak memory of all tasks
+    } plan_t;
+
+    void write_json_string(FILE *out, const char *s)
+    {
+        fputc('\"', out);
+        for (; *s != '\0'; ++s)
+        {
+            uint8_t c = uint8_t(*s);
+            if ((c == '\"') || (c == '\\'))
+            {
+                fputc('\\', out);
+                fputc(c, out);
+            }
+            else if (c < 0x20)
+                fprintf(out, "\\u%04x", int(c));
+            else
+                fputc(c, out);
+        }
+        fputc('\"', out);
+    }
+
+    static void write_json_strings(FILE *out, const char *name, lltl::parray<LSPString> *list)
+    {
+        fprintf(out, "\"%s\": [", name);
+        for (size_t i=0, n=list->size(); i<n; ++i)
+        {
+            if (i > 0)
+                fputs(", ", out);
+            write_json_string(out, list->uget(i)->get_utf8());
+        }
+        fputs("]", out);
+
+        drop_strings(list);
+    }
+
+    static status_t add_issue(plan_t *plan, const char *fmt, ...)
+    {
+        // The issues are not collected while estimating the cost only
+        if (plan->pLog == NULL)
+            return STATUS_OK;
+
+        char buf[1024];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+
+        fprintf(plan->pLog, "  %s\n", buf);
+        ++plan->nIssues;
+
+        LSPString *issue = new LSPString();
+        if ((issue == NULL) || (!issue->set_utf8(buf)) || (!plan->vIssues.add(issue)))
+        {
+            if (issue != NULL)
+                delete issue;
+            return STATUS_NO_MEM;
+        }
+
+        return STATUS_OK;
+    }
+
+    static status_t plan_input(plan_t *plan, plan_input_t *in, const LSPString *name, bool required)
+    {
+        mm::audio_stream_t info;
+
+        in->bFound          = false;
+        in->nChannels       = 0;
+        in->nSampleRate     = 0;
+        in->nFrames         = 0;
+        in->nLength         = 0;
+
+        // The audio file is not loaded if it's profile is supplied and the data is not rendered
+        if (!required)
+            return STATUS_OK;
+
+        status_t res        = read_audio_info(&info, &plan->pConfig->sSrcPath, name);
+        if (res == STATUS_NOT_FOUND)
+            return add_issue(plan, "missing file '%s'", name->get_utf8());
+        else if (res != STATUS_OK)
+            return add_issue(plan, "could not read header of file '%s', error code: %d", name->get_utf8(), int(res));
+
+        // The file is resampled to the sample rate of the configuration after loading
+        in->bFound          = true;
+        in->nChannels       = info.channels;
+        in->nSampleRate     = info.srate;
+        in->nFrames         = info.frames;
+        in->nLength         = (info.srate > 0) ?
+            wsize_t((double(info.frames) * plan->pConfig->nSampleRate + info.srate - 1) / info.srate) : info.frames;
+
+        return STATUS_OK;
+    }
+
+    static status_t plan_profile(plan_t *plan, const LSPString *name)
+    {
+        io::Path path;
+        status_t res        = input_file_path(&path, &plan->pConfig->sSrcPath, name);
+        if (res != STATUS_OK)
+            return res;
+        if (!path.exists())
+            return add_issue(plan, "missing profile file '%s'", name->get_utf8());
+
+        return STATUS_OK;
+    }
+
+    static status_t plan_output(plan_t *plan, const LSPString *fmt, expr::Resolver *vars)
+    {
+        io::Path path;
+        status_t res        = output_file_name(&path, &plan->sNaming, fmt, vars);
+        if (res != STATUS_OK)
+            return res;
+
+        LSPString *name     = path.as_string()->clone();
+        if ((name == NULL) || (!plan->vOutputs.add(name)))
+        {
+            if (name != NULL)
+                delete name;
+            return STATUS_NO_MEM;
+        }
+
+        // Detect outputs which would overwrite each other
+        if (plan->vNames.contains(name))
+            return add_issue(plan, "duplicate output file '%s'", name->get_utf8());
+        if ((name = name->clone()) == NULL)
+            return STATUS_NO_MEM;
+        if (!plan->vNames.create(name))
+        {
+            delete name;
+            return STATUS_NO_MEM;
+        }
+
+        return STATUS_OK;
+    }
+
+    static double fft_flops(size_t rank)
+    {
+        return 5.0 * double(1 << rank) * rank;
+    }
+
+    static double profile_flops(const plan_input_t *in, size_t rank)
+    {
+        // Each frame is windowed, transformed and the magnitude spectrum is accumulated
+        return double(in->nChannels) * spectral_profile_frames(in->nLength, rank) *
+            (fft_flops(rank) + 8.0 * (1 << rank));
+    }
+
+    static size_t plan_ir_length(ssize_t *latency, const irfile_t *ir, size_t rank)
+    {
+        ssize_t length      = (ir->nPhase == PHASE_MINIMUM) ? (1 << (rank - 1)) : (1 << rank);
+        ssize_t head        = 0;
+        ssize_t count       = length;
+
+        // The length after automatic trimming is not known without the data, take the upper bound
+        if (!ir->bAutoTrim)
+        {
+            ssize_t tail        = (lsp_limit(ir->fTailCut, 0.0f, 100.0f) * 0.01f) * length;
+            head                = (lsp_limit(ir->fHeadCut, 0.0f, 100.0f) * 0.01f) * length;
+            count               = lsp_max(length - head - tail, 0);
+        }
+
+        *latency            = ((ir->nPhase == PHASE_MINIMUM) ? 0 : ((1 << rank) >> 1)) - head;
+        return count;
+    }
+
+    static void plan_task_cost(plan_cost_t *cost, plan_t *plan, const plan_input_t *master,
+        const plan_input_t *child, bool child_profile)
+    {
+        const config_t *cfg = plan->pConfig;
+        size_t rank         = plan->nRank;
+        size_t fft_size     = 1 << rank;
+        size_t channels     = (child->bFound) ? child->nChannels : lsp_max(master->nChannels, size_t(1));
+        bool keep_child     = (cfg->bMastering) && (cfg->nProduce & OUT_AUDIO);
+
+        // Analysis of the child file and computing of the impulse response
+        cost->fAnalysis     = (child_profile) ? 0.0 : profile_flops(child, rank);
+        cost->fIR           = double(channels) * (fft_flops(rank) * ((cfg->sIR.nPhase == PHASE_MINIMUM) ? 3.0 : 1.0) + 16.0 * fft_size);
+        cost->fRender       = 0.0;
+
+        // The spectral profiles and the raw impulse responses of the whole batch are kept in memory
+        wsize_t batch       = wsize_t(IR_BATCH) * channels * sizeof(float) * (fft_size + (fft_size >> 1) + 1);
+        wsize_t resident    = batch;
+        if (master->bFound)
+            resident           += wsize_t(master->nChannels) * master->nLength * sizeof(float);
+
+        // Loading of the file keeps the original and the resampled data, the child file
+        // is loaded again for rendering when mastering
+        wsize_t transient   = ((child_profile) && (!keep_child)) ? 0 :
+            wsize_t(channels) * (child->nFrames + child->nLength) * sizeof(float);
+
+        // Rendering of the processed audio file
+        if (cfg->nProduce & OUT_AUDIO)
+        {
+            const plan_input_t *src = (cfg->bMastering) ? child : master;
+            ssize_t latency;
+            size_t ir_length    = plan_ir_length(&latency, &cfg->sIR, rank);
+            size_t length       = src->nLength;
+            size_t conv_rank    = fft_convolution_rank(length, ir_length);
+
+            cost->fRender       = double(channels) * (fft_convolution_cost(length, ir_length, conv_rank) + 4.0 * length);
+
+            // The output data and the FFT buffers of each worker
+            wsize_t render      = wsize_t(channels) * convolution_length(length, ir_length, latency) * sizeof(float) +
+                                  wsize_t(plan->nThreads) * (2 << conv_rank) * sizeof(float);
+            transient           = lsp_max(transient, render);
+        }
+
+        cost->nMemory       = resident + transient;
+    }
+
+    static status_t plan_group(plan_t *plan, fgroup_t *fg)
+    {
+        config_t *cfg       = plan->pConfig;
+        expr::Variables gvars, vars;
+        plan_input_t master, child;
+        plan_cost_t cost;
+        status_t res;
+        FILE *out           = plan->pOut;
+
+        fprintf(plan->pLog, "planning group '%s'...\n", fg->sName.get_native());
+
+        if (plan->nGroups > 0)
+            fputs(",", out);
+        ++plan->nGroups;
+        fputs("\n\t\t{\n\t\t\t\"name\": ", out);
+        write_json_string(out, fg->sName.get_utf8());
+
+        // The group without master file is skipped by the processing
+        if (fg->sMaster.is_empty())
+        {
+            if ((res = add_issue(plan, "group '%s' does not have master file", fg->sName.get_utf8())) != STATUS_OK)
+                return res;
+            fputs(",\n\t\t\t", out);
+            write_json_strings(out, "issues", &plan->vIssues);
+            fputs("\n\t\t}", out);
+            return STATUS_OK;
+        }
+
+        // Master file
+        bool keep_child     = (cfg->bMastering) && (cfg->nProduce & OUT_AUDIO);
+        bool need_master    = (fg->sMasterProfile.is_empty()) || ((cfg->nProduce & OUT_AUDIO) && (!cfg->bMastering));
+        if ((res = plan_input(plan, &master, &fg->sMaster, need_master)) != STATUS_OK)
+            return res;
+        if ((!fg->sMasterProfile.is_empty()) && ((res = plan_profile(plan, &fg->sMasterProfile)) != STATUS_OK))
+            return res;
+
+        if ((res = build_group_variables(&gvars, cfg, fg)) != STATUS_OK)
+            return res;
+        vars.set_resolver(&gvars);
+        if ((res = build_variables(&vars, &fg->sMaster)) != STATUS_OK)
+            return res;
+        if ((cfg->nProduce & OUT_PRM) && ((res = plan_output(plan, &cfg->sPRMaster, &vars)) != STATUS_OK))
+            return res;
+        if ((cfg->nProduce & OUT_FRM) && ((res = plan_output(plan, &cfg->sIR.sFRMaster, &vars)) != STATUS_OK))
+            return res;
+
+        double master_flops = (fg->sMasterProfile.is_empty()) ? profile_flops(&master, plan->nRank) : 0.0;
+        plan->fFlops       += master_flops;
+
+        fputs(",\n\t\t\t\"master\": { \"file\": ", out);
+        write_json_string(out, fg->sMaster.get_utf8());
+        fprintf(out, ", \"channels\": %d, \"srate\": %d, \"frames\": %lld, \"flops\": %.0f, ",
+            int(master.nChannels), int(master.nSampleRate), (long long)master.nFrames, master_flops);
+        write_json_strings(out, "outputs", &plan->vOutputs);
+        fputs(", ", out);
+        write_json_strings(out, "issues", &plan->vIssues);
+        fputs(" },\n\t\t\t\"tasks\": [", out);
+
+        // Child files
+        for (size_t i=0, n=fg->vFiles.size(); i<n; ++i)
+        {
+            LSPString *fname    = fg->vFiles.uget(i);
+            LSPString *pname    = fg->vProfiles.get(i);
+            bool has_profile    = (pname != NULL) && (!pname->is_empty());
+
+            if ((res = plan_input(plan, &child, fname, (!has_profile) || (keep_child))) != STATUS_OK)
+                return res;
+            if ((has_profile) && ((res = plan_profile(plan, pname)) != STATUS_OK))
+                return res;
+            if ((master.bFound) && (child.bFound) && (master.nChannels != child.nChannels))
+            {
+                res = add_issue(plan, "number of channels mismatch: %d (master) vs %d (child '%s')",
+                    int(master.nChannels), int(child.nChannels), fname->get_utf8());
+                if (res != STATUS_OK)
+                    return res;
+            }
+
+            // Names of output files
+            if ((res = build_variables(&vars, fname)) != STATUS_OK)
+                return res;
+            if ((cfg->nProduce & OUT_PRC) && ((res = plan_output(plan, &cfg->sPRChild, &vars)) != STATUS_OK))
+                return res;
+            if ((cfg->nProduce & OUT_FRC) && ((res = plan_output(plan, &cfg->sIR.sFRChild, &vars)) != STATUS_OK))
+                return res;
+            if ((cfg->nProduce & OUT_RAW) && ((res = plan_output(plan, &cfg->sIR.sRaw, &vars)) != STATUS_OK))
+                return res;
+            if ((cfg->nProduce & OUT_IR) && ((res = plan_output(plan, &cfg->sIR.sFile, &vars)) != STATUS_OK))
+                return res;
+            if ((cfg->nProduce & OUT_AUDIO) && ((res = plan_output(plan, &cfg->sFile, &vars)) != STATUS_OK))
+                return res;
+
+            // Estimate the cost of the task
+            plan_task_cost(&cost, plan, &master, &child, has_profile);
+            double flops        = cost.fAnalysis + cost.fIR + cost.fRender;
+            plan->fFlops       += flops;
+            plan->nPeak         = lsp_max(plan->nPeak, cost.nMemory);
+
+            if (i > 0)
+                fputs(",", out);
+            fputs("\n\t\t\t\t{ \"file\": ", out);
+            write_json_string(out, fname->get_utf8());
+            fprintf(out, ", \"channels\": %d, \"srate\": %d, \"frames\": %lld, ",
+                int(child.nChannels), int(child.nSampleRate), (long long)child.nFrames);
+            fprintf(out, "\"flops\": { \"analysis\": %.0f, \"ir\": %.0f, \"render\": %.0f, \"total\": %.0f }, \"memory\": %lld, ",
+                cost.fAnalysis, cost.fIR, cost.fRender, flops, (long long)cost.nMemory);
+            write_json_strings(out, "outputs", &plan->vOutputs);
+            fputs(", ", out);
+            write_json_strings(out, "issues", &plan->vIssues);
+            fputs(" }", out);
+
+            ++plan->nTasks;
+        }
+
+        fputs("\n\t\t\t]\n\t\t}", out);
+
+        return STATUS_OK;
+    }
+
+    static status_t plan_jobs(plan_t *plan, size_t threads)
+    {
+        config_t *cfg       = plan->pConfig;
+        io::InSequence is;
+        status_t res        = is.open(&cfg->sJobs);
+        if (res != STATUS_OK)
+        {
+            fprintf(stderr, "  could not open jobs file '%s'\n", cfg->sJobs.get_native());
+            return res;
+        }
+
+        size_t line         = 0;
+        while (true)
+        {
+            fgroup_t fg;
+            if ((res = read_job(&fg, &is, &line)) != STATUS_OK)
+            {
+                if (res == STATUS_EOF)
+                    res     = STATUS_OK;
+                else
+                    fprintf(stderr, "  error parsing job at line %d of file '%s'\n", int(line), cfg->sJobs.get_native());
+                break;
+            }
+
+            if ((res = resolve_group_files(cfg, &fg, threads)) != STATUS_OK)
+                break;
+            if ((res = plan_group(plan, &fg)) != STATUS_OK)
+                break;
+        }
+
+        is.close();
+        return res;
+    }
+
+    static ssize_t compare_group_names(const LSPString *a, const LSPString *b)
+    {
+        return a->compare_to(b);
+    }
+
+    static status_t plan_batch(plan_t *plan)
+    {
+        config_t *cfg       = plan->pConfig;
+        status_t res        = discover_groups(cfg);
+        if (res != STATUS_OK)
+            return res;
+
+        lltl::parray<LSPString> gnames;
+        if (!cfg->vGroups.keys(&gnames))
+            return STATUS_NO_MEM;
+        gnames.qsort(compare_group_names);
+
+        fprintf(plan->pOut, "{\n\t\"version\": %d,\n\t\"srate\": %d,\n\t\"fft_rank\": %d,\n\t\"threads\": %d,\n\t\"groups\": [",
+            PLAN_VERSION, int(cfg->nSampleRate), int(plan->nRank), int(plan->nThreads));
+
+        for (size_t i=0, n=gnames.size(); i<n; ++i)
+        {
+            fgroup_t *fg        = cfg->vGroups.get(gnames.uget(i));
+            if (fg == NULL)
+                return STATUS_UNKNOWN_ERR;
+
+            if ((res = resolve_group_files(cfg, fg, plan->nThreads)) != STATUS_OK)
+                return res;
+            res                 = plan_group(plan, fg);
+            release_group_files(fg);
+            if (res != STATUS_OK)
+                return res;
+        }
+
+        if ((!cfg->sJobs.is_empty()) && ((res = plan_jobs(plan, plan->nThreads)) != STATUS_OK))
+            return res;
+
+        fprintf(plan->pOut, "\n\t],\n\t\"total\": { \"groups\": %d, \"tasks\": %d, \"issues\": %d, \"flops\": %.0f, \"memory\": %lld }\n}\n",
+            int(plan->nGroups), int(plan->nTasks), int(plan->nIssues), plan->fFlops, (long long)plan->nPeak);
+
+        return STATUS_OK;
+    }
+
+    static void init_plan(plan_t *plan, config_t *cfg)
+    {
+        plan->pConfig       = cfg;
+        plan->pOut          = NULL;
+        plan->pLog          = NULL;
+        plan->nRank         = lsp_limit(cfg->nFftRank, FFT_MIN, FFT_MAX);
+        plan->nThreads      = worker_threads(cfg->nThreads);
+        plan->nGroups       = 0;
+        plan->nTasks        = 0;
+        plan->nIssues       = 0;
+        plan->fFlops        = 0.0;
+        plan->nPeak         = 0;
+    }
+
+    status_t estimate_group_cost(double *master_cost, double *costs, config_t *cfg, fgroup_t *fg)
+    {
+        plan_t plan;
+        plan_input_t master, child;
+        plan_cost_t cost;
+        status_t res;
+
+        init_plan(&plan, cfg);
+
+        *master_cost        = 0.0;
+        for (size_t i=0, n=fg->vFiles.size(); i<n; ++i)
+            costs[i]            = 0.0;
+
+        // The group without master file is skipped by the processing
+        if (fg->sMaster.is_empty())
+            return STATUS_OK;
+
+        bool keep_child     = (cfg->bMastering) && (cfg->nProduce & OUT_AUDIO);
+        bool need_master    = (fg->sMasterProfile.is_empty()) || ((cfg->nProduce & OUT_AUDIO) && (!cfg->bMastering));
+        if ((res = plan_input(&plan, &master, &fg->sMaster, need_master)) != STATUS_OK)
+            return res;
+        *master_cost        = (fg->sMasterProfile.is_empty()) ? profile_flops(&master, plan.nRank) : 0.0;
+
+        for (size_t i=0, n=fg->vFiles.size(); i<n; ++i)
+        {
+            LSPString *pname    = fg->vProfiles.get(i);
+            bool has_profile    = (pname != NULL) && (!pname->is_empty());
+
+            if ((res = plan_input(&plan, &child, fg->vFiles.uget(i), (!has_profile) || (keep_child))) != STATUS_OK)
+                return res;
+
+            plan_task_cost(&cost, &plan, &master, &child, has_profile);
+            costs[i]            = cost.fAnalysis + cost.fIR + cost.fRender;
+        }
+
+        return STATUS_OK;
+    }
+
+    status_t plan_file_groups(config_t *cfg)
+    {
+        plan_t plan;
+        status_t res;
+
+        init_plan(&plan, cfg);
+
+        if ((!plan.sNaming.sBase.set(&cfg->sDstPath)))
+            return STATUS_NO_MEM;
+
+        // The plan is written to the standard output or to the file
+        if (cfg->sPlan.equals_ascii("-"))
+        {
+            plan.pOut           = stdout;
+            plan.pLog           = stderr;
+        }
+        else
+        {
+            plan.pOut           = fopen(cfg->sPlan.get_native(), "w");
+            plan.pLog           = stdout;
+            if (plan.pOut == NULL)
+            {
+                fprintf(stderr, "  could not create plan file '%s'\n", cfg->sPlan.get_native());
+                return STATUS_IO_ERROR;
+            }
+        }
+
+        res                 = plan_batch(&plan);
+
+        if (plan.pOut != stdout)
+            fclose(plan.pOut);
+
+        // Release the names of output files
+        lltl::parray<LSPString> names;
+        plan.vNames.values(&names);
+        plan.vNames.flush();
+        drop_strings(&names);
+        drop_strings(&plan.vOutputs);
+        drop_strings(&plan.vIssues);
+
+        if (res != STATUS_OK)
+            return res;
+
+        fprintf(plan.pLog, "plan: %d groups, %d tasks, %.3f GFLOP, peak memory %.2f MiB per task, %d issues\n",
+            int(plan.nGroups), int(plan.nTasks), plan.fFlops * 1e-9, plan.nPeak / 1048576.0, int(plan.nIssues));
+
+        return (plan.nIssues > 0) ? STATUS_BAD_STATE : STATUS_OK;
+    }
+} /* namespace timbremill */
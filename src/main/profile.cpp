@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/dsp/dsp.h>
+#include <lsp-plug.in/io/InFileStream.h>
+#include <lsp-plug.in/io/OutFileStream.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/config/data.h>
+#include <private/profile.h>
+
+#define PROFILE_HEADER_SIZE     64
+#define PROFILE_ALIGN           64
+#define PROFILE_RANK_MAX        24
+#define PROFILE_HALF_PEAK       32768.0f
+
+namespace timbremill
+{
+    static inline void put_u16(uint8_t *dst, uint16_t v)
+    {
+        dst[0]  = uint8_t(v);
+        dst[1]  = uint8_t(v >> 8);
+    }
+
+    static inline void put_u32(uint8_t *dst, uint32_t v)
+    {
+        dst[0]  = uint8_t(v);
+        dst[1]  = uint8_t(v >> 8);
+        dst[2]  = uint8_t(v >> 16);
+        dst[3]  = uint8_t(v >> 24);
+    }
+
+    static inline void put_f32(uint8_t *dst, float v)
+    {
+        uint32_t u;
+        memcpy(&u, &v, sizeof(u));
+        put_u32(dst, u);
+    }
+
+    static inline uint16_t get_u16(const uint8_t *src)
+    {
+        return uint16_t(src[0]) | (uint16_t(src[1]) << 8);
+    }
+
+    static inline uint32_t get_u32(const uint8_t *src)
+    {
+        return uint32_t(src[0]) | (uint32_t(src[1]) << 8) | (uint32_t(src[2]) << 16) | (uint32_t(src[3]) << 24);
+    }
+
+    static inline float get_f32(const uint8_t *src)
+    {
+        uint32_t u  = get_u32(src);
+        float v;
+        memcpy(&v, &u, sizeof(v));
+        return v;
+    }
+
+    static uint16_t float_to_half(float v)
+    {
+        uint32_t x;
+        memcpy(&x, &v, sizeof(x));
+
+        uint32_t sign   = (x >> 16) & 0x8000;
+        uint32_t fexp   = (x >> 23) & 0xff;
+        uint32_t mant   = x & 0x7fffff;
+        int32_t exp     = int32_t(fexp) - 127 + 15;
+
+        if (fexp == 0xff)                           // Infinity or NaN
+            return sign | 0x7c00 | ((mant != 0) ? 0x200 : 0);
+        if (exp >= 0x1f)                            // Overflow
+            return sign | 0x7c00;
+        if (exp <= 0)
+        {
+            // Denormalized value or zero, round to nearest even
+            if (exp < -10)
+                return sign;
+            mant           |= 0x800000;
+            uint32_t shift  = 14 - exp;
+            uint32_t h      = mant >> shift;
+            uint32_t rem    = mant & ((1u << shift) - 1);
+            uint32_t mid    = 1u << (shift - 1);
+            if ((rem > mid) || ((rem == mid) && (h & 1)))
+                ++h;
+            return sign | h;
+        }
+
+        // Normalized value, round to nearest even, the carry may turn the value into infinity
+        uint32_t h      = (uint32_t(exp) << 10) | (mant >> 13);
+        uint32_t rem    = mant & 0x1fff;
+        if ((rem > 0x1000) || ((rem == 0x1000) && (h & 1)))
+            ++h;
+        return sign | h;
+    }
+
+    static float half_to_float(uint16_t h)
+    {
+        uint32_t sign   = uint32_t(h & 0x8000) << 16;
+        uint32_t exp    = (h >> 10) & 0x1f;
+        uint32_t mant   = h & 0x3ff;
+        uint32_t x;
+
+        if (exp == 0)                               // Denormalized value or zero
+        {
+            float v         = mant * (1.0f / 16777216.0f);
+            return (sign) ? -v : v;
+        }
+        else if (exp == 0x1f)                       // Infinity or NaN
+            x               = sign | 0x7f800000 | (mant << 13);
+        else
+            x               = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+
+        float v;
+        memcpy(&v, &x, sizeof(v));
+        return v;
+    }
+
+    static inline size_t profile_stride(size_t bins, ssize_t encoding)
+    {
+        size_t bytes    = bins * ((encoding == PROF_FLOAT16) ? sizeof(uint16_t) : sizeof(float));
+        return (bytes + PROFILE_ALIGN - 1) & ~size_t(PROFILE_ALIGN - 1);
+    }
+
+    status_t write_profile(const io::Path *path, const dspu::Sample *profile, const profile_info_t *info, ssize_t encoding)
+    {
+        io::OutFileStream os;
+        status_t res;
+
+        size_t channels     = profile->channels();
+        size_t fft_size     = 1 << info->nRank;
+        size_t bins         = profile->length();    // Less than the half-spectrum for the logarithmic grid
+        size_t stride       = profile_stride(bins, encoding);
+        if ((bins < 1) || (bins > (fft_size >> 1) + 1))
+            return STATUS_BAD_ARGUMENTS;
+
+        // Scale the data to use the whole dynamic range of the half-precision values
+        float scale         = 1.0f;
+        if (encoding == PROF_FLOAT16)
+        {
+            float peak          = 0.0f;
+            for (size_t i=0; i<channels; ++i)
+                peak                = lsp_max(peak, dsp::abs_max(profile->channel(i), bins));
+            if (peak > 0.0f)
+                scale               = PROFILE_HALF_PEAK / peak;
+        }
+
+        uint8_t *buf        = new uint8_t[lsp_max(stride, size_t(PROFILE_HEADER_SIZE))];
+        if (buf == NULL)
+            return STATUS_NO_MEM;
+
+        // Form the header
+        memset(buf, 0, PROFILE_HEADER_SIZE);
+        memcpy(&buf[0], "TMPF", 4);
+        put_u16(&buf[4], PROFILE_VERSION);
+        put_u16(&buf[6], encoding);
+        put_u32(&buf[8], info->nRank);
+        put_u32(&buf[12], channels);
+        put_u32(&buf[16], bins);
+        put_u32(&buf[20], info->nWindow);
+        put_u32(&buf[24], info->nSampleRate);
+        put_u32(&buf[28], info->nSourceRate);
+        put_u32(&buf[32], uint32_t(info->nFrames));
+        put_u32(&buf[36], uint32_t(info->nFrames >> 32));
+        put_f32(&buf[40], scale);
+        put_u32(&buf[44], info->nAverage);
+        put_f32(&buf[48], info->fAvgParam);
+
+        // Write the header and the data of each channel
+        if ((res = os.open(path, io::File::FM_WRITE_NEW)) == STATUS_OK)
+        {
+            if (os.write(buf, PROFILE_HEADER_SIZE) != PROFILE_HEADER_SIZE)
+                res                 = STATUS_IO_ERROR;
+        }
+
+        for (size_t i=0; (res == STATUS_OK) && (i<channels); ++i)
+        {
+            const float *src    = profile->channel(i);
+            memset(buf, 0, stride);
+            if (encoding == PROF_FLOAT16)
+            {
+                for (size_t j=0; j<bins; ++j)
+                    put_u16(&buf[j * sizeof(uint16_t)], float_to_half(src[j] * scale));
+            }
+            else
+            {
+                for (size_t j=0; j<bins; ++j)
+                    put_f32(&buf[j * sizeof(float)], src[j]);
+            }
+
+            if (os.write(buf, stride) != ssize_t(stride))
+                res                 = STATUS_IO_ERROR;
+        }
+
+        // Close the file and release resources
+        status_t cres       = os.close();
+        if (res == STATUS_OK)
+            res                 = cres;
+        delete [] buf;
+
+        return res;
+    }
+
+    status_t read_profile(dspu::Sample *profile, profile_info_t *info, const io::Path *path)
+    {
+        io::InFileStream is;
+        dspu::Sample out;
+        uint8_t hdr[PROFILE_HEADER_SIZE];
+        status_t res;
+
+        // Read and validate the header
+        if ((res = is.open(path)) != STATUS_OK)
+            return res;
+        if (is.read_fully(hdr, PROFILE_HEADER_SIZE) != PROFILE_HEADER_SIZE)
+        {
+            is.close();
+            return STATUS_CORRUPTED;
+        }
+
+        size_t version      = get_u16(&hdr[4]);
+        ssize_t encoding    = get_u16(&hdr[6]);
+        size_t rank         = get_u32(&hdr[8]);
+        size_t channels     = get_u32(&hdr[12]);
+        size_t bins         = get_u32(&hdr[16]);
+        float scale         = get_f32(&hdr[40]);
+
+        if ((memcmp(hdr, "TMPF", 4) != 0) ||
+            (version != PROFILE_VERSION) ||
+            ((encoding != PROF_FLOAT32) && (encoding != PROF_FLOAT16)) ||
+            (rank < 1) || (rank > PROFILE_RANK_MAX) ||
+            (bins < 1) || (bins > ((size_t(1) << rank) >> 1) + 1) ||
+            (channels == 0) ||
+            (!(scale > 0.0f)))
+        {
+            is.close();
+            return STATUS_BAD_FORMAT;
+        }
+
+        profile_info_t pi;
+        pi.nRank            = rank;
+        pi.nWindow          = get_u32(&hdr[20]);
+        pi.nSampleRate      = get_u32(&hdr[24]);
+        pi.nSourceRate      = get_u32(&hdr[28]);
+        pi.nFrames          = wsize_t(get_u32(&hdr[32])) | (wsize_t(get_u32(&hdr[36])) << 32);
+        pi.nAverage         = get_u32(&hdr[44]);
+        pi.fAvgParam        = get_f32(&hdr[48]);
+
+        // Allocate the data
+        size_t stride       = profile_stride(bins, encoding);
+        uint8_t *buf        = new uint8_t[stride];
+        if (buf == NULL)
+        {
+            is.close();
+            return STATUS_NO_MEM;
+        }
+        if (!out.init(channels, bins, bins))
+        {
+            delete [] buf;
+            is.close();
+            return STATUS_NO_MEM;
+        }
+
+        // Read the half-spectrum of each channel
+        float k             = 1.0f / scale;
+        for (size_t i=0; (res == STATUS_OK) && (i<channels); ++i)
+        {
+            if (is.read_fully(buf, stride) != ssize_t(stride))
+            {
+                res                 = STATUS_CORRUPTED;
+                break;
+            }
+
+            float *dst          = out.channel(i);
+            if (encoding == PROF_FLOAT16)
+            {
+                for (size_t j=0; j<bins; ++j)
+                    dst[j]              = half_to_float(get_u16(&buf[j * sizeof(uint16_t)])) * k;
+            }
+            else
+            {
+                for (size_t j=0; j<bins; ++j)
+                    dst[j]              = get_f32(&buf[j * sizeof(float)]) * k;
+            }
+        }
+
+        // Close the file and release resources
+        status_t cres       = is.close();
+        if (res == STATUS_OK)
+            res                 = cres;
+        delete [] buf;
+
+        if (res == STATUS_OK)
+        {
+            out.set_sample_rate(pi.nSampleRate);
+            profile->swap(&out);
+            *info               = pi;
+        }
+
+        return res;
+    }
+} /* namespace timbremill */
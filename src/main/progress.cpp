@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/ipc/Mutex.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/runtime/system.h>
+#include <private/plan.h>
+#include <private/progress.h>
+
+#ifdef PLATFORM_WINDOWS
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif /* PLATFORM_WINDOWS */
+
+#define PROGRESS_POLL           50      // The period of checking for the stop request (milliseconds)
+#define PROGRESS_MIN_INTERVAL   100     // The minimum interval between reports (milliseconds)
+
+namespace timbremill
+{
+    typedef struct progress_state_t
+    {
+        ssize_t             nMode;          // Reporting mode
+        FILE               *pOut;           // Output of reports
+        bool                bClose;         // Close the output at the end
+        uint8_t            *pData;          // Allocated data of the counters
+        progress_slot_t    *vSlots;         // Counters of workers
+        size_t              nWorkers;       // Number of workers
+        size_t              nSampleRate;    // Output sample rate
+        wsize_t             nInterval;      // Interval between reports (milliseconds)
+        wsize_t             nStart;         // The time of the start (milliseconds)
+        ipc::Thread        *pThread;        // Background reporting thread
+        volatile bool       bStop;          // Stop request for the reporting thread
+        size_t              nLine;          // Length of the last status line
+
+        // The fields below are accessed under the lock
+        ipc::Mutex          sLock;          // Lock of the state
+        LSPString           sUnit;          // Name of the group of the current unit
+        size_t              nUnits;         // Number of known work units
+        size_t              nStarted;       // Number of started work units
+        size_t              nDone;          // Number of completed work units
+        wsize_t             nTotal;         // Expected samples of all started units
+        wsize_t             nExpected;      // Expected samples of the current unit
+        wsize_t             nFirst;         // Processed samples at the start of the current unit
+        wsize_t             nFrames;        // Completely processed audio frames
+    } progress_state_t;
+
+    static progress_state_t progress;
+
+    static const char *stage_names[] =
+    {
+        "idle",
+        "load",
+        "analysis",
+        "ir",
+        "render",
+        "save"
+    };
+
+    static const char stage_codes[] = ".LAIRS";
+
+    static wsize_t processed_samples()
+    {
+        wsize_t count       = 0;
+        for (size_t i=0; i<progress.nWorkers; ++i)
+            count              += progress.vSlots[i].nSamples;
+        return count;
+    }
+
+    static void format_time(char *buf, size_t size, double seconds)
+    {
+        long t              = long(seconds);
+        snprintf(buf, size, "%ld:%02ld:%02ld", t / 3600, (t / 60) % 60, t % 60);
+    }
+
+    static void report_progress(bool final)
+    {
+        FILE *out           = progress.pOut;
+        wsize_t now         = system::get_time_millis();
+        double elapsed      = lsp_max(now - progress.nStart, wsize_t(1)) * 1e-3;
+        wsize_t done        = processed_samples();
+
+        // Work units which are not started yet are estimated by the average of started ones
+        progress.sLock.lock();
+        size_t units        = lsp_max(progress.nUnits, progress.nStarted);
+        size_t finished     = progress.nDone;
+        double total        = progress.nTotal;
+        if ((progress.nStarted > 0) && (units > progress.nStarted))
+            total              += (total / progress.nStarted) * (units - progress.nStarted);
+        total               = lsp_max(total, double(done));
+        double frames       = progress.nFrames;
+        const char *unit    = progress.sUnit.get_utf8();
+        char uname[256];
+        snprintf(uname, sizeof(uname), "%s", (unit != NULL) ? unit : "");
+        progress.sLock.unlock();
+
+        double ratio        = (total > 0.0) ? done / total : 0.0;
+        double rate         = done / elapsed;
+        double rtf          = (progress.nSampleRate > 0) ? frames / (progress.nSampleRate * elapsed) : 0.0;
+        double mbps         = (rate * sizeof(float)) / 1e+6;
+        double eta          = ((rate > 0.0) && (!final)) ? (total - done) / rate : 0.0;
+
+        if (progress.nMode == PROGRESS_JSON)
+        {
+            fprintf(out, "{\"elapsed\": %.1f, \"unit\": ", elapsed);
+            write_json_string(out, uname);
+            fprintf(out, ", \"units_done\": %d, \"units\": %d, \"samples_done\": %lld, \"samples_total\": %.0f, "
+                "\"progress\": %.4f, \"rtf\": %.2f, \"mbps\": %.2f, \"eta\": %.1f, \"workers\": [",
+                int(finished), int(units), (long long)done, total, ratio, rtf, mbps, eta);
+            for (size_t i=0; i<progress.nWorkers; ++i)
+            {
+                const progress_slot_t *slot = &progress.vSlots[i];
+                ssize_t stage       = lsp_limit(slot->nStage, ssize_t(0), ssize_t(PSTAGE_TOTAL - 1));
+                fprintf(out, "%s{\"stage\": \"%s\", \"samples\": %lld}",
+                    (i > 0) ? ", " : "", stage_names[stage], (long long)slot->nSamples);
+            }
+            fprintf(out, "], \"final\": %s}\n", (final) ? "true" : "false");
+        }
+        else
+        {
+            char line[512], time[32], workers[65];
+            size_t count        = lsp_min(progress.nWorkers, sizeof(workers) - 1);
+            for (size_t i=0; i<count; ++i)
+            {
+                ssize_t stage       = lsp_limit(progress.vSlots[i].nStage, ssize_t(0), ssize_t(PSTAGE_TOTAL - 1));
+                workers[i]          = stage_codes[stage];
+            }
+            workers[count]      = '\0';
+            format_time(time, sizeof(time), (final) ? elapsed : eta);
+
+            int len = snprintf(line, sizeof(line), "[%d/%d] %5.1f%%  %.1fx RT  %.1f MB/s  %s %s  %s  %.40s",
+                int(finished), int(units), ratio * 100.0, rtf, mbps, (final) ? "done in" : "ETA", time, workers, uname);
+            len                 = lsp_limit(len, 0, int(sizeof(line) - 1));
+
+            // Overwrite the previous status line
+            fprintf(out, "\r%s%*s", line, int(lsp_max(progress.nLine, size_t(len)) - len), "");
+            if (final)
+                fputc('\n', out);
+            progress.nLine      = len;
+        }
+
+        fflush(out);
+    }
+
+    static status_t progress_reporter(void *arg)
+    {
+        wsize_t next        = progress.nStart + progress.nInterval;
+        while (!progress.bStop)
+        {
+            ipc::Thread::sleep(PROGRESS_POLL);
+            wsize_t now         = system::get_time_millis();
+            if (now < next)
+                continue;
+
+            report_progress(false);
+            next                = now + progress.nInterval;
+        }
+
+        return STATUS_OK;
+    }
+
+    status_t start_progress(const config_t *cfg, size_t workers)
+    {
+        progress.nMode      = cfg->nProgress;
+        progress.pOut       = NULL;
+        progress.bClose     = false;
+        progress.pData      = NULL;
+        progress.vSlots     = NULL;
+        progress.nWorkers   = 0;
+        progress.pThread    = NULL;
+        progress.bStop      = false;
+        progress.nLine      = 0;
+        progress.nUnits     = 0;
+        progress.nStarted   = 0;
+        progress.nDone      = 0;
+        progress.nTotal     = 0;
+        progress.nExpected  = 0;
+        progress.nFirst     = 0;
+        progress.nFrames    = 0;
+
+        if (progress.nMode == PROGRESS_NONE)
+            return STATUS_OK;
+
+        // The status line is shown on the terminal, the JSON lines go to the status descriptor
+        if ((progress.nMode == PROGRESS_JSON) && (cfg->nStatusFd != 2))
+        {
+            if (cfg->nStatusFd == 1)
+                progress.pOut       = stdout;
+            else
+            {
+                // The duplicate is closed at the end, the descriptor of the caller stays open
+                int fd              = dup(cfg->nStatusFd);
+                progress.pOut       = (fd >= 0) ? fdopen(fd, "w") : NULL;
+                if ((progress.pOut == NULL) && (fd >= 0))
+                    close(fd);
+            }
+            progress.bClose     = progress.pOut != stdout;
+            if (progress.pOut == NULL)
+            {
+                fprintf(stderr, "  could not open status file descriptor %d\n", int(cfg->nStatusFd));
+                return STATUS_IO_ERROR;
+            }
+        }
+        else
+            progress.pOut       = stderr;
+
+        progress.vSlots     = alloc_aligned<progress_slot_t>(progress.pData, workers, PROGRESS_SLOT_SIZE);
+        if (progress.vSlots == NULL)
+        {
+            stop_progress();
+            return STATUS_NO_MEM;
+        }
+        for (size_t i=0; i<workers; ++i)
+        {
+            progress.vSlots[i].nSamples = 0;
+            progress.vSlots[i].nStage   = PSTAGE_IDLE;
+        }
+
+        progress.nWorkers   = workers;
+        progress.nSampleRate= cfg->nSampleRate;
+        progress.nInterval  = lsp_max(wsize_t(cfg->fProgressInterval * 1000.0f), wsize_t(PROGRESS_MIN_INTERVAL));
+        progress.nStart     = system::get_time_millis();
+
+        progress.pThread    = new ipc::Thread(progress_reporter, NULL);
+        if ((progress.pThread == NULL) || (progress.pThread->start() != STATUS_OK))
+        {
+            stop_progress();
+            return STATUS_UNKNOWN_ERR;
+        }
+
+        return STATUS_OK;
+    }
+
+    void stop_progress()
+    {
+        if (progress.pThread != NULL)
+        {
+            progress.bStop      = true;
+            progress.pThread->join();
+            delete progress.pThread;
+            progress.pThread    = NULL;
+
+            report_progress(true);
+        }
+
+        if (progress.pData != NULL)
+            free_aligned(progress.pData);
+        progress.vSlots     = NULL;
+        progress.nWorkers   = 0;
+
+        if ((progress.bClose) && (progress.pOut != NULL))
+            fclose(progress.pOut);
+        progress.pOut       = NULL;
+        progress.nMode      = PROGRESS_NONE;
+    }
+
+    progress_slot_t *progress_worker(size_t worker)
+    {
+        return (worker < progress.nWorkers) ? &progress.vSlots[worker] : NULL;
+    }
+
+    void progress_units(size_t count)
+    {
+        if (progress.nWorkers == 0)
+            return;
+
+        progress.sLock.lock();
+        progress.nUnits    += count;
+        progress.sLock.unlock();
+    }
+
+    void progress_begin_unit(const LSPString *name, wsize_t expected)
+    {
+        if (progress.nWorkers == 0)
+            return;
+
+        wsize_t done        = processed_samples();
+
+        progress.sLock.lock();
+        progress.sUnit.set(name);
+        progress.nStarted  += 1;
+        progress.nTotal    += expected;
+        progress.nExpected  = expected;
+        progress.nFirst     = done;
+        progress.sLock.unlock();
+    }
+
+    void progress_end_unit()
+    {
+        if (progress.nWorkers == 0)
+            return;
+
+        wsize_t done        = processed_samples();
+
+        progress.sLock.lock();
+        progress.nTotal     = progress.nTotal - progress.nExpected + (done - progress.nFirst);
+        progress.nExpected  = 0;
+        progress.nDone     += 1;
+        progress.sLock.unlock();
+    }
+
+    void progress_audio(wsize_t frames)
+    {
+        if (progress.nWorkers == 0)
+            return;
+
+        progress.sLock.lock();
+        progress.nFrames   += frames;
+        progress.sLock.unlock();
+    }
+} /* namespace timbremill */
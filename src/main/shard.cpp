@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/runtime/system.h>
+#include <private/discover.h>
+#include <private/plan.h>
+#include <private/shard.h>
+
+namespace timbremill
+{
+    static inline double work_unit_cost(const work_unit_t *unit)
+    {
+        return unit->fMaster + unit->fCost;
+    }
+
+    static ssize_t compare_work_units(const work_unit_t *a, const work_unit_t *b)
+    {
+        // The most expensive units go first
+        double ca       = work_unit_cost(a);
+        double cb       = work_unit_cost(b);
+        if (ca != cb)
+            return (ca > cb) ? -1 : 1;
+
+        // Units of the same cost are ordered by the group name and the first child file
+        ssize_t res     = a->pGroup->sName.compare_to(&b->pGroup->sName);
+        if (res != 0)
+            return res;
+        return (a->nFirst < b->nFirst) ? -1 : (a->nFirst > b->nFirst) ? 1 : 0;
+    }
+
+    status_t estimate_work_units(lltl::darray<work_unit_t> *units, config_t *cfg, fgroup_t *fg)
+    {
+        size_t n            = fg->vFiles.size();
+        double master       = 0.0;
+        double *costs       = NULL;
+        if (n > 0)
+        {
+            if ((costs = new double[n]) == NULL)
+                return STATUS_NO_MEM;
+        }
+
+        status_t res        = estimate_group_cost(&master, costs, cfg, fg);
+        for (size_t i=0, count=lsp_max(n, size_t(1)); (res == STATUS_OK) && (i<count); ++i)
+        {
+            work_unit_t *unit   = units->add();
+            if (unit == NULL)
+            {
+                res                 = STATUS_NO_MEM;
+                break;
+            }
+
+            unit->pGroup        = fg;
+            unit->nFirst        = i;
+            unit->nCount        = (n > 0) ? 1 : 0;
+            unit->fMaster       = master;
+            unit->fCost         = (n > 0) ? costs[i] : 0.0;
+            unit->nShard        = 0;
+        }
+
+        if (costs != NULL)
+            delete [] costs;
+
+        return res;
+    }
+
+    status_t partition_work_units(lltl::darray<work_unit_t> *dst, lltl::darray<work_unit_t> *src, size_t shards)
+    {
+        // Compute the fair share of each shard, the master file is analyzed once per group
+        double total        = 0.0;
+        for (size_t i=0, n=src->size(); i<n; ++i)
+        {
+            work_unit_t *unit   = src->uget(i);
+            if ((i == 0) || (src->uget(i - 1)->pGroup != unit->pGroup))
+                total              += unit->fMaster;
+            total              += unit->fCost;
+        }
+        shards              = lsp_max(shards, size_t(1));
+        double share        = total / shards;
+
+        // Merge the units of each group
+        for (size_t first=0, n=src->size(); first<n; )
+        {
+            work_unit_t *head   = src->uget(first);
+            double cost         = 0.0;
+            size_t last         = first;
+            for ( ; (last < n) && (src->uget(last)->pGroup == head->pGroup); ++last)
+                cost               += src->uget(last)->fCost;
+
+            // The group is split only if it does not fit into the share, each part
+            // of the group analyzes the master file again
+            size_t parts        = 1;
+            if ((share > 0.0) && (head->fMaster + cost > share))
+                parts               = lsp_limit(size_t(ceil((head->fMaster + cost) / share)), size_t(1), last - first);
+
+            // Split child files into contiguous ranges of about the same cost
+            work_unit_t *unit   = NULL;
+            double acc          = 0.0;
+            for (size_t i=first, part=0; i<last; ++i)
+            {
+                work_unit_t *su     = src->uget(i);
+                if (unit == NULL)
+                {
+                    if ((unit = dst->add()) == NULL)
+                        return STATUS_NO_MEM;
+                    unit->pGroup        = su->pGroup;
+                    unit->nFirst        = su->nFirst;
+                    unit->nCount        = 0;
+                    unit->fMaster       = su->fMaster;
+                    unit->fCost         = 0.0;
+                    unit->nShard        = 0;
+                }
+
+                unit->nCount       += su->nCount;
+                unit->fCost        += su->fCost;
+                acc                += su->fCost;
+
+                if ((part + 1 < parts) && (acc * parts >= cost * (part + 1)))
+                {
+                    unit                = NULL;
+                    ++part;
+                }
+            }
+
+            first               = last;
+        }
+
+        // Assign the most expensive units first, each one to the least loaded shard
+        lltl::parray<work_unit_t> order;
+        for (size_t i=0, n=dst->size(); i<n; ++i)
+        {
+            if (!order.add(dst->uget(i)))
+                return STATUS_NO_MEM;
+        }
+        order.qsort(compare_work_units);
+
+        double *load        = new double[shards];
+        if (load == NULL)
+            return STATUS_NO_MEM;
+        for (size_t i=0; i<shards; ++i)
+            load[i]             = 0.0;
+
+        for (size_t i=0, n=order.size(); i<n; ++i)
+        {
+            work_unit_t *unit   = order.uget(i);
+            size_t shard        = 0;
+            for (size_t j=1; j<shards; ++j)
+            {
+                if (load[j] < load[shard])
+                    shard               = j;
+            }
+
+            unit->nShard        = shard;
+            load[shard]        += work_unit_cost(unit);
+        }
+
+        delete [] load;
+
+        return STATUS_OK;
+    }
+
+    status_t open_manifest(manifest_t *m, const config_t *cfg)
+    {
+        io::Path path, dir;
+        status_t res;
+
+        m->pOut             = NULL;
+        m->nShard           = lsp_max(cfg->nShard, ssize_t(0));
+        m->nShards          = lsp_max(cfg->nShards, ssize_t(0));
+        m->nUnits           = 0;
+        m->nFiles           = 0;
+        m->nOutputs         = 0;
+        m->fCost            = 0.0;
+        m->nStart           = system::get_time_millis();
+
+        // Each shard writes the manifest to the destination path by default
+        if (!cfg->sManifest.is_empty())
+            res                 = path.set(&cfg->sManifest);
+        else if (cfg->nShards > 0)
+        {
+            LSPString name;
+            if (name.fmt_ascii("manifest-%d-of-%d.ndjson", int(cfg->nShard), int(cfg->nShards)) <= 0)
+                return STATUS_NO_MEM;
+            res                 = path.set(&cfg->sDstPath, &name);
+        }
+        else
+            return STATUS_OK;
+
+        if (res != STATUS_OK)
+            return res;
+        if ((path.get_parent(&dir) == STATUS_OK) && ((res = dir.mkdir(true)) != STATUS_OK))
+        {
+            fprintf(stderr, "  could not create directory '%s', error code: %d\n", dir.as_native(), int(res));
+            return res;
+        }
+
+        // The manifest is appended, so the records of the interrupted runs are kept
+        if ((m->pOut = fopen(path.as_native(), "a")) == NULL)
+        {
+            fprintf(stderr, "  could not open manifest file '%s'\n", path.as_native());
+            return STATUS_IO_ERROR;
+        }
+
+        return STATUS_OK;
+    }
+
+    void record_work_unit(manifest_t *m, const work_unit_t *unit,
+        lltl::parray<LSPString> *outputs, status_t res, wsize_t millis)
+    {
+        if (m->pOut == NULL)
+            return;
+
+        FILE *out           = m->pOut;
+        fprintf(out, "{\"shard\": %d, \"shards\": %d, \"group\": ", int(m->nShard), int(m->nShards));
+        write_json_string(out, unit->pGroup->sName.get_utf8());
+        fprintf(out, ", \"first\": %d, \"count\": %d, \"status\": %d, \"millis\": %lld, \"cost\": %.0f, \"outputs\": [",
+            int(unit->nFirst), int(unit->nCount), int(res), (long long)millis, work_unit_cost(unit));
+        for (size_t i=0, n=outputs->size(); i<n; ++i)
+        {
+            if (i > 0)
+                fputs(", ", out);
+            write_json_string(out, outputs->uget(i)->get_utf8());
+        }
+        fputs("]}\n", out);
+        fflush(out);
+
+        if (res == STATUS_OK)
+        {
+            ++m->nUnits;
+            m->nFiles          += unit->nCount;
+            m->nOutputs        += outputs->size();
+            m->fCost           += work_unit_cost(unit);
+        }
+
+        drop_strings(outputs);
+    }
+
+    void close_manifest(manifest_t *m, status_t res)
+    {
+        if (m->pOut == NULL)
+            return;
+
+        wsize_t millis      = system::get_time_millis() - m->nStart;
+        fprintf(m->pOut, "{\"shard\": %d, \"shards\": %d, \"summary\": { \"status\": %d, \"units\": %d, \"files\": %d, \"outputs\": %d, \"millis\": %lld, \"cost\": %.0f }}\n",
+            int(m->nShard), int(m->nShards), int(res), int(m->nUnits), int(m->nFiles), int(m->nOutputs), (long long)millis, m->fCost);
+        fclose(m->pOut);
+        m->pOut             = NULL;
+
+        if (m->nShards > 0)
+            printf("shard %d of %d: ", int(m->nShard), int(m->nShards));
+        printf("%d work units, %d child files, %d output files, %.3f GFLOP estimated, %.1f s\n",
+            int(m->nUnits), int(m->nFiles), int(m->nOutputs), m->fCost * 1e-9, millis * 1e-3);
+    }
+} /* namespace timbremill */
@@ -24,19 +24,30 @@
 #include <lsp-plug.in/dsp-units/sampling/Sample.h>
 #include <lsp-plug.in/dsp-units/units.h>
 #include <lsp-plug.in/expr/Variables.h>
+#include <lsp-plug.in/io/InSequence.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/lltl/darray.h>
+#include <lsp-plug.in/runtime/system.h>
 
+#include <private/arena.h>
 #include <private/config/config.h>
 #include <private/config/cmdline.h>
 #include <private/audio.h>
+#include <private/discover.h>
+#include <private/memory.h>
+#include <private/plan.h>
+#include <private/progress.h>
+#include <private/shard.h>
+#include <private/tool.h>
+#include <private/trace.h>
+#include <private/workers.h>
 
-#define FFT_MIN         8
-#define FFT_MAX         16
 #define DRYWET_MIN      -150.0f
 #define DRYWET_MAX      150.0f
 
 namespace timbremill
 {
-    status_t build_variables(expr::Variables *vars, config_t *cfg, fgroup_t *fg, LSPString *master, LSPString *child)
+    status_t build_group_variables(expr::Variables *vars, config_t *cfg, fgroup_t *fg)
     {
         io::Path path;
         LSPString value;
@@ -52,7 +63,7 @@ namespace timbremill
             return res;
 
         // Parse master file name
-        if ((res = path.set(master)) != STATUS_OK)
+        if ((res = path.set(&fg->sMaster)) != STATUS_OK)
             return res;
 
         if ((res = path.get_last(&value)) != STATUS_OK)
@@ -68,6 +79,18 @@ namespace timbremill
         if ((res = vars->set_string("master_name", &value)) != STATUS_OK)
             return res;
 
+        return STATUS_OK;
+    }
+
+    status_t build_variables(expr::Variables *vars, LSPString *child)
+    {
+        io::Path path;
+        LSPString value;
+        status_t res;
+
+        // Clear variables, the common variables are resolved by the group variables
+        vars->clear();
+
         // Parse child file name
         if ((res = path.set(child)) != STATUS_OK)
             return res;
@@ -97,18 +120,92 @@ namespace timbremill
         return dspu::db_to_gain(amount);
     }
 
-    status_t process_file_group(config_t *cfg, fgroup_t *fg)
+    static void init_spectral_average(spc_average_t *avg, const config_t *cfg)
+    {
+        avg->nMethod        = cfg->nAverage;
+        avg->fPower         = cfg->fAvgPower;
+        avg->fPercentile    = cfg->fPercentile;
+    }
+
+    static status_t load_input_profile(dspu::Sample *profile, profile_info_t *info, const config_t *cfg, const LSPString *name,
+        size_t fft_rank, size_t grid)
+    {
+        spc_average_t avg;
+        status_t res;
+
+        if ((res = load_profile_file(profile, info, &cfg->sSrcPath, name)) != STATUS_OK)
+            return res;
+
+        // The profile should match the analysis settings
+        if ((info->nRank != fft_rank) || (info->nSampleRate != size_t(cfg->nSampleRate)))
+        {
+            fprintf(stderr, "  profile '%s' does not match the FFT rank %d and sample rate %d\n",
+                name->get_native(), int(fft_rank), int(cfg->nSampleRate));
+            return STATUS_BAD_FORMAT;
+        }
+
+        // The frequency grid is defined by the number of points, profiles on different grids are not comparable
+        if (profile->length() != profile_points(grid, fft_rank))
+        {
+            fprintf(stderr, "  profile '%s' does not match the frequency grid of %d points\n",
+                name->get_native(), int(profile_points(grid, fft_rank)));
+            return STATUS_BAD_FORMAT;
+        }
+
+        // Profiles averaged by another method are still usable but the correction may be biased
+        init_spectral_average(&avg, cfg);
+        if ((info->nAverage != avg.nMethod) || (info->fAvgParam != spectral_average_param(&avg)))
+            fprintf(stdout, "  warning: profile '%s' was computed with another averaging method or parameter\n", name->get_native());
+
+        return STATUS_OK;
+    }
+
+    static void init_profile_info(profile_info_t *info, const config_t *cfg, const spc_average_t *avg,
+        size_t fft_rank, size_t source_rate, size_t length)
+    {
+        info->nRank         = fft_rank;
+        info->nSampleRate   = cfg->nSampleRate;
+        info->nSourceRate   = source_rate;
+        info->nWindow       = PROFILE_WINDOW_BN;
+        info->nFrames       = spectral_profile_frames(length, fft_rank);
+        info->nAverage      = avg->nMethod;
+        info->fAvgParam     = spectral_average_param(avg);
+    }
+
+    static status_t save_output_profile(const dspu::Sample *profile, const profile_info_t *info,
+        config_t *cfg, naming_t *naming, expr::Variables *vars, LSPString *child, const LSPString *fmt)
     {
-        dspu::Sample master, mp, *src, *dst, ir;
-        expr::Variables vars;
+        status_t res;
+
+        // Build variables
+        if ((res = build_variables(vars, child)) != STATUS_OK)
+        {
+            fprintf(stderr, "  error building pattern variables for profile file\n");
+            return res;
+        }
+
+        return save_profile_file(profile, info, naming, fmt, vars, cfg->nPREncoding);
+    }
+
+    status_t process_file_group(config_t *cfg, fgroup_t *fg, arena_t *arenas, naming_t *naming)
+    {
+        dspu::Sample master, mp, *src, ir, af;
+        expr::Variables gvars, vars;
         status_t res;
         ssize_t fft_rank    = lsp_limit(cfg->nFftRank, FFT_MIN, FFT_MAX);
+        size_t grid         = lsp_max(cfg->nGrid, 0);
         float dry           = drywet_to_gain(cfg->fDry);
         float wet           = drywet_to_gain(cfg->fWet);
         float ngain         = dspu::db_to_gain(cfg->fNormGain);
         float transition    = lsp_max(0.0f, cfg->fTransition);
+        float smoothing     = lsp_limit(cfg->fSmoothing, 0.0f, SMOOTHING_MAX);
+        size_t threads      = worker_threads(cfg->nThreads);
         size_t master_sr    = 0;        // The original sample rate of the master file
         size_t child_sr     = 0;        // The original sample rate of the child file
+        progress_slot_t *ps = progress_worker(0);
+        spc_average_t avg;
+
+        init_spectral_average(&avg, cfg);
 
         // Analyze group settings
         if (fg->sMaster.is_empty())
@@ -122,177 +219,538 @@ namespace timbremill
             return STATUS_OK;
 
         // Shall we produce something?
-        if ((fg->vFiles.is_empty()) && (!(cfg->nProduce & OUT_FRM)))
+        if ((fg->vFiles.is_empty()) && (!(cfg->nProduce & (OUT_FRM | OUT_PRM))))
         {
             fprintf(stdout, "  group '%s' does not have any child files, skipping\n", fg->sName.get_native());
             return STATUS_OK;
         }
 
-        // Read the master file
-        if ((res = load_audio_file(&master, &master_sr, cfg->nSampleRate, &cfg->sSrcPath, &fg->sMaster)) != STATUS_OK)
+        // The variables of the master file are computed once for the group
+        if ((res = build_group_variables(&gvars, cfg, fg)) != STATUS_OK)
+        {
+            fprintf(stderr, "  error building pattern variables for group '%s'\n", fg->sName.get_native());
             return res;
+        }
+        vars.set_resolver(&gvars);
 
-        // Compute the audio profile for master
-        if ((res = spectral_profile(&mp, &master, fft_rank)) != STATUS_OK)
+        // Read the master file if it is required for the analysis or for the rendering
+        if ((fg->sMasterProfile.is_empty()) || ((cfg->nProduce & OUT_AUDIO) && (!cfg->bMastering)))
         {
-            fprintf(stderr, "  error computing spectral profile for the master file '%s'\n", fg->sName.get_native());
-            return res;
+            progress_stage(ps, PSTAGE_LOAD);
+            if ((res = load_audio_file(&master, &master_sr, cfg->nSampleRate, &cfg->sSrcPath, &fg->sMaster)) != STATUS_OK)
+                return res;
+        }
+
+        // Load or compute the audio profile for master
+        profile_info_t minfo;
+        if (!fg->sMasterProfile.is_empty())
+        {
+            if ((res = load_input_profile(&mp, &minfo, cfg, &fg->sMasterProfile, fft_rank, grid)) != STATUS_OK)
+                return res;
+            master_sr           = minfo.nSourceRate;
+        }
+        else
+        {
+            progress_stage(ps, PSTAGE_ANALYSIS);
+            if ((res = spectral_profile(&mp, &master, fft_rank, grid, &avg, &arenas[0])) != STATUS_OK)
+            {
+                fprintf(stderr, "  error computing spectral profile for the master file '%s'\n", fg->sName.get_native());
+                return res;
+            }
+
+            init_profile_info(&minfo, cfg, &avg, fft_rank, master_sr, master.length());
+        }
+
+        // Produce binary profile of master if required
+        if (cfg->nProduce & OUT_PRM)
+        {
+            if ((res = save_output_profile(&mp, &minfo, cfg, naming, &vars, &fg->sMaster, &cfg->sPRMaster)) != STATUS_OK)
+                return res;
         }
 
         // Produce spectral profile of master if required
         if (cfg->nProduce & OUT_FRM)
         {
             // Build variables
-            if ((res = build_variables(&vars, cfg, fg, &fg->sMaster, &fg->sMaster)) != STATUS_OK)
+            if ((res = build_variables(&vars, &fg->sMaster)) != STATUS_OK)
             {
                 fprintf(stderr, "  error building pattern variables for master file\n");
                 return res;
             }
 
-            if ((res = profile_to_impulse_response(&ir, &mp, fft_rank)) != STATUS_OK)
+            if ((res = profile_to_impulse_response(&ir, &mp, fft_rank, &arenas[0])) != STATUS_OK)
             {
                 fprintf(stderr, "  error computing frequrency response for the the master file '%s'\n", fg->sName.get_native());
                 return res;
             }
             ir.set_sample_rate(cfg->nSampleRate);
-            if ((res = save_audio_file(&ir, &cfg->sDstPath, &cfg->sIR.sFRMaster, &vars)) != STATUS_OK)
+            if ((res = save_audio_file(&ir, naming, &cfg->sIR.sFRMaster, &vars, &cfg->vFormat[FOUT_FRM], 1.0f)) != STATUS_OK)
                 return res;
         }
 
-        // Process child files in the group
-        for (size_t i=0, n=fg->vFiles.size(); i<n; ++i)
+        // Process child files in the group by batches. Only profiles are kept for the whole batch,
+        // the audio data of the child file is loaded again for the rendering in mastering mode
+        for (size_t first=0, n=fg->vFiles.size(); first<n; first += IR_BATCH)
         {
-            dspu::Sample child, cp, raw_ir, af;
-            LSPString *fname = fg->vFiles.uget(i);
-            if (fname == NULL)
+            dspu::Sample child, cp[IR_BATCH], raw_ir[IR_BATCH];
+            const dspu::Sample *vcp[IR_BATCH];
+            dspu::Sample *vir[IR_BATCH];
+            size_t vsr[IR_BATCH];
+            size_t vlen[IR_BATCH];      // The length of the audio data processed for the child file
+            size_t count = lsp_min(n - first, size_t(IR_BATCH));
+
+            // Load child files and compute their spectral profiles
+            for (size_t j=0; j<count; ++j)
             {
-                fprintf(stderr, "  internal error\n");
-                return STATUS_UNKNOWN_ERR;
-            }
+                LSPString *fname = fg->vFiles.uget(first + j);
+                if (fname == NULL)
+                {
+                    fprintf(stderr, "  internal error\n");
+                    return STATUS_UNKNOWN_ERR;
+                }
 
-            // Build variables
-            if ((res = build_variables(&vars, cfg, fg, &fg->sMaster, fname)) != STATUS_OK)
-            {
-                fprintf(stderr, "  error building pattern variables for child file\n");
-                return res;
-            }
+                // Load the child file if it is required for the analysis or for the rendering
+                LSPString *pname    = fg->vProfiles.get(first + j);
+                bool has_profile    = (pname != NULL) && (!pname->is_empty());
+                vlen[j]             = 0;
+                if (!has_profile)
+                {
+                    progress_stage(ps, PSTAGE_LOAD);
+                    if ((res = load_audio_file(&child, &child_sr, cfg->nSampleRate, &cfg->sSrcPath, fname)) != STATUS_OK)
+                        return res;
+                    vlen[j]             = child.length();
+                }
 
-            // Load the child file
-            if ((res = load_audio_file(&child, &child_sr, cfg->nSampleRate, &cfg->sSrcPath, fname)) != STATUS_OK)
-                return res;
-            if (child.channels() != master.channels())
-            {
-                fprintf(stderr, "  number of channels mimatch: %d (master) vs %d (child), leaving\n",
-                    int(master.channels()), int(child.channels()));
-                return res;
-            }
+                // Load or compute the spectral profile for the child file
+                profile_info_t cinfo;
+                if (has_profile)
+                {
+                    if ((res = load_input_profile(&cp[j], &cinfo, cfg, pname, fft_rank, grid)) != STATUS_OK)
+                        return res;
+                    child_sr            = cinfo.nSourceRate;
+                }
+                else
+                {
+                    progress_stage(ps, PSTAGE_ANALYSIS);
+                    if ((res = spectral_profile(&cp[j], &child, fft_rank, grid, &avg, &arenas[0])) != STATUS_OK)
+                    {
+                        fprintf(stderr, "  error computing spectral profile for the child file '%s'\n", fname->get_native());
+                        return res;
+                    }
 
-            // Compute the spectral profile for the child file
-            if ((res = spectral_profile(&cp, &child, fft_rank)) != STATUS_OK)
-            {
-                fprintf(stderr, "  error computing spectral profile for the child file '%s'\n", fname->get_native());
-                return res;
-            }
+                    init_profile_info(&cinfo, cfg, &avg, fft_rank, child_sr, child.length());
+                }
 
-            // Produce spectral profile of child if required
-            if (cfg->nProduce & OUT_FRC)
-            {
-                if ((res = profile_to_impulse_response(&ir, &cp, fft_rank)) != STATUS_OK)
+                if (cp[j].channels() != mp.channels())
                 {
-                    fprintf(stderr, "  error computing frequrency response for the the child file '%s'\n", fname->get_native());
-                    return res;
+                    fprintf(stderr, "  number of channels mimatch: %d (master) vs %d (child), leaving\n",
+                        int(mp.channels()), int(cp[j].channels()));
+                    return STATUS_BAD_FORMAT;
                 }
-                ir.set_sample_rate(cfg->nSampleRate);
-                if ((res = save_audio_file(&ir, &cfg->sDstPath, &cfg->sIR.sFRChild, &vars)) != STATUS_OK)
-                    return res;
-            }
 
-            // Compute the impulse response of the file
-            src = (cfg->bMastering) ? &mp : &cp;
-            dst = (cfg->bMastering) ? &cp : &mp;
-            size_t sr = lsp_min(master_sr, child_sr);
+                // Do not keep the audio data of the whole batch in memory
+                child.destroy();
 
-            if ((res = timbre_impulse_response(&raw_ir, dst, src, fft_rank, cfg->fGainRange, sr, transition)) != STATUS_OK)
-            {
-                fprintf(stderr, "  error computing raw impulse response for the child file '%s'\n", fname->get_native());
-                return res;
+                // Produce binary profile of child if required
+                if (cfg->nProduce & OUT_PRC)
+                {
+                    if ((res = save_output_profile(&cp[j], &cinfo, cfg, naming, &vars, fname, &cfg->sPRChild)) != STATUS_OK)
+                        return res;
+                }
+
+                // Produce spectral profile of child if required
+                if (cfg->nProduce & OUT_FRC)
+                {
+                    // Build variables
+                    if ((res = build_variables(&vars, fname)) != STATUS_OK)
+                    {
+                        fprintf(stderr, "  error building pattern variables for child file\n");
+                        return res;
+                    }
+
+                    if ((res = profile_to_impulse_response(&ir, &cp[j], fft_rank, &arenas[0])) != STATUS_OK)
+                    {
+                        fprintf(stderr, "  error computing frequrency response for the the child file '%s'\n", fname->get_native());
+                        return res;
+                    }
+                    ir.set_sample_rate(cfg->nSampleRate);
+                    if ((res = save_audio_file(&ir, naming, &cfg->sIR.sFRChild, &vars, &cfg->vFormat[FOUT_FRC], 1.0f)) != STATUS_OK)
+                        return res;
+                }
+
+                vcp[j]      = &cp[j];
+                vir[j]      = &raw_ir[j];
+                vsr[j]      = lsp_min(master_sr, child_sr);
             }
 
-            // Need to produce raw IR file?
-            if (cfg->nProduce & OUT_RAW)
+            // Compute the impulse responses of the whole batch
+            progress_stage(ps, PSTAGE_IR);
+            if ((res = timbre_impulse_responses(vir, &mp, vcp, vsr, count, cfg->bMastering, cfg->sIR.nPhase, fft_rank, cfg->fGainRange, transition, smoothing, &arenas[0])) != STATUS_OK)
             {
-                // Save the raw IR file
-                raw_ir.set_sample_rate(cfg->nSampleRate);
-                if ((res = save_audio_file(&raw_ir, &cfg->sDstPath, &cfg->sIR.sRaw, &vars)) != STATUS_OK)
-                    return res;
+                fprintf(stderr, "  error computing raw impulse responses for the group '%s'\n", fg->sName.get_native());
+                return res;
             }
 
-            // Need to produce trimmed IR or processed audio file?
-            if (cfg->nProduce & (OUT_IR | OUT_AUDIO))
+            // Produce output files
+            for (size_t j=0; j<count; ++j)
             {
-                ssize_t latency = 0;
+                LSPString *fname = fg->vFiles.uget(first + j);
 
-                // Produce the trimmed IR file
-                if ((res = trim_impulse_response(&ir, &latency, &raw_ir, &cfg->sIR)) != STATUS_OK)
+                // Build variables
+                if ((res = build_variables(&vars, fname)) != STATUS_OK)
                 {
-                    fprintf(stderr, "  error trimming impulse response, error code: %d\n", int(res));
+                    fprintf(stderr, "  error building pattern variables for child file\n");
                     return res;
                 }
 
-                // Need to produce IR file?
-                if (cfg->nProduce & OUT_IR)
+                // Need to produce raw IR file?
+                if (cfg->nProduce & OUT_RAW)
                 {
-                    // Save the trimmed IR file
-                    ir.set_sample_rate(cfg->nSampleRate);
-                    if ((res = save_audio_file(&ir, &cfg->sDstPath, &cfg->sIR.sFile, &vars)) != STATUS_OK)
+                    // Save the raw IR file
+                    raw_ir[j].set_sample_rate(cfg->nSampleRate);
+                    if ((res = save_audio_file(&raw_ir[j], naming, &cfg->sIR.sRaw, &vars, &cfg->vFormat[FOUT_RAW], 1.0f)) != STATUS_OK)
                         return res;
                 }
 
-                // Need to produce audio file?
-                if (cfg->nProduce & OUT_AUDIO)
+                // Need to produce trimmed IR or processed audio file?
+                if (cfg->nProduce & (OUT_IR | OUT_AUDIO))
                 {
-                    src     = (cfg->bMastering) ? &child : &master;
+                    ssize_t latency = 0;
 
-                    // Convolve the trimmed IR file with the master sample
-                    if ((res = convolve(&af, src, &ir, latency, dry, wet)) != STATUS_OK)
+                    // Produce the trimmed IR file
+                    progress_stage(ps, PSTAGE_IR);
+                    if ((res = trim_impulse_response(&ir, &latency, &raw_ir[j], &cfg->sIR)) != STATUS_OK)
                     {
-                        fprintf(stderr, "  error convolving trimmed impulse response with master file, error code: %d\n", int(res));
+                        fprintf(stderr, "  error trimming impulse response, error code: %d\n", int(res));
                         return res;
                     }
+                    raw_ir[j].destroy();
 
-                    // Normalize if required
-                    if ((res = normalize(&af, ngain, cfg->nNormalize)) != STATUS_OK)
+                    // Need to produce IR file?
+                    if (cfg->nProduce & OUT_IR)
                     {
-                        fprintf(stderr, "  error normalizing output audio file, error code: %d\n", int(res));
-                        return res;
+                        // Save the trimmed IR file
+                        ir.set_sample_rate(cfg->nSampleRate);
+                        if ((res = save_audio_file(&ir, naming, &cfg->sIR.sFile, &vars, &cfg->vFormat[FOUT_IR], 1.0f)) != STATUS_OK)
+                            return res;
                     }
 
-                    // Need to perform latency compensation?
-                    if (cfg->bLatencyCompensation)
-                        compensate_latency(&af, latency);
-                    if (cfg->bMatchLength)
-                        af.resize(af.channels(), src->length(), src->length());
-
-                    // Save the convolved file
-                    af.set_sample_rate(cfg->nSampleRate);
-                    if ((res = save_audio_file(&af, &cfg->sDstPath, &cfg->sFile, &vars)) != STATUS_OK)
-                        return res;
+                    // Need to produce audio file?
+                    if (cfg->nProduce & OUT_AUDIO)
+                    {
+                        // Load the child file again for the processing in mastering mode
+                        if (cfg->bMastering)
+                        {
+                            progress_stage(ps, PSTAGE_LOAD);
+                            if ((res = load_audio_file(&child, NULL, cfg->nSampleRate, &cfg->sSrcPath, fname)) != STATUS_OK)
+                                return res;
+                        }
+                        src     = (cfg->bMastering) ? &child : &master;
+
+                        // Convolve the trimmed IR file with the master sample, compensate latency and match length
+                        float peak = 0.0f;
+                        progress_stage(ps, PSTAGE_RENDER);
+                        if ((res = render_audio(&af, &peak, src, &ir, latency, dry, wet,
+                            cfg->bLatencyCompensation, cfg->bMatchLength, cfg->nConvolver, threads, arenas)) != STATUS_OK)
+                        {
+                            fprintf(stderr, "  error convolving trimmed impulse response with master file, error code: %d\n", int(res));
+                            return res;
+                        }
+
+                        // Save the convolved file, the normalization gain is applied while encoding
+                        af.set_sample_rate(cfg->nSampleRate);
+                        progress_stage(ps, PSTAGE_SAVE);
+                        {
+                            TRACE_SCOPE("normalize");
+                            float gain  = normalizing_gain(peak, ngain, cfg->nNormalize);
+                            if ((res = save_audio_file(&af, naming, &cfg->sFile, &vars, &cfg->vFormat[FOUT_AUDIO], gain)) != STATUS_OK)
+                                return res;
+                        }
+                        child.destroy();
+                        vlen[j]     = src->length();
+                    }
                 }
+
+                progress_audio(vlen[j]);
             }
         }
 
         return STATUS_OK;
     }
 
-    status_t process_file_groups(config_t *cfg)
+    static status_t compile_file_names(naming_t *naming, config_t *cfg)
     {
-        lltl::parray<LSPString> gnames;
-        if (!cfg->vGroups.keys(&gnames))
+        const LSPString *fmt[] =
+        {
+            (cfg->nProduce & OUT_AUDIO) ? &cfg->sFile : NULL,
+            (cfg->nProduce & OUT_IR) ? &cfg->sIR.sFile : NULL,
+            (cfg->nProduce & OUT_RAW) ? &cfg->sIR.sRaw : NULL,
+            (cfg->nProduce & OUT_FRM) ? &cfg->sIR.sFRMaster : NULL,
+            (cfg->nProduce & OUT_FRC) ? &cfg->sIR.sFRChild : NULL,
+            (cfg->nProduce & OUT_PRM) ? &cfg->sPRMaster : NULL,
+            (cfg->nProduce & OUT_PRC) ? &cfg->sPRChild : NULL,
+        };
+
+        // Compile templates of all produced files once per run
+        if (!naming->sBase.set(&cfg->sDstPath))
+            return STATUS_NO_MEM;
+        for (size_t i=0, n=sizeof(fmt)/sizeof(fmt[0]); i<n; ++i)
+        {
+            if (fmt[i] == NULL)
+                continue;
+
+            status_t res = compile_file_name(naming, fmt[i], NULL);
+            if (res != STATUS_OK)
+                return res;
+        }
+
+        return STATUS_OK;
+    }
+
+    typedef struct prefetch_t
+    {
+        const config_t     *pConfig;    // Configuration
+        fgroup_t           *pGroup;     // The group to resolve
+        size_t              nThreads;   // Number of threads for scanning directories
+        status_t            nResult;    // Result of resolution
+    } prefetch_t;
+
+    static status_t prefetch_group(void *arg)
+    {
+        prefetch_t *pf  = static_cast<prefetch_t *>(arg);
+        pf->nResult     = resolve_group_files(pf->pConfig, pf->pGroup, pf->nThreads);
+        return pf->nResult;
+    }
+
+    static ssize_t compare_group_names(const LSPString *a, const LSPString *b)
+    {
+        return a->compare_to(b);
+    }
+
+    static status_t process_group_range(config_t *cfg, const work_unit_t *unit, arena_t *arenas, naming_t *naming)
+    {
+        fgroup_t *fg        = unit->pGroup;
+        fgroup_t part;
+
+        if ((!part.sName.set(&fg->sName)) ||
+            (!part.sMaster.set(&fg->sMaster)) ||
+            (!part.sMasterProfile.set(&fg->sMasterProfile)))
             return STATUS_NO_MEM;
 
-        for (size_t i=0, n=gnames.size(); i<n; ++i)
+        for (size_t i=unit->nFirst, n=unit->nFirst + unit->nCount; i<n; ++i)
+        {
+            LSPString *fname    = fg->vFiles.uget(i)->clone();
+            if ((fname == NULL) || (!part.vFiles.add(fname)))
+            {
+                if (fname != NULL)
+                    delete fname;
+                return STATUS_NO_MEM;
+            }
+
+            if (fg->vProfiles.is_empty())
+                continue;
+            LSPString *pname    = fg->vProfiles.get(i);
+            pname               = (pname != NULL) ? pname->clone() : new LSPString();
+            if ((pname == NULL) || (!part.vProfiles.add(pname)))
+            {
+                if (pname != NULL)
+                    delete pname;
+                return STATUS_NO_MEM;
+            }
+        }
+
+        // The outputs of the master file are produced only by the first range of the group
+        ssize_t produce     = cfg->nProduce;
+        if (unit->nFirst > 0)
+            cfg->nProduce      &= ~(OUT_PRM | OUT_FRM);
+        status_t res        = process_file_group(cfg, &part, arenas, naming);
+        cfg->nProduce       = produce;
+
+        return res;
+    }
+
+    static wsize_t input_samples(config_t *cfg, const LSPString *name)
+    {
+        mm::audio_stream_t info;
+        if (read_audio_info(&info, &cfg->sSrcPath, name) != STATUS_OK)
+            return 0;
+
+        // The file is resampled to the sample rate of the configuration after loading
+        wsize_t frames      = (info.srate > 0) ?
+            wsize_t((double(info.frames) * cfg->nSampleRate + info.srate - 1) / info.srate) : info.frames;
+        return frames * info.channels;
+    }
+
+    static wsize_t expected_samples(config_t *cfg, const work_unit_t *unit)
+    {
+        fgroup_t *fg        = unit->pGroup;
+        if (fg->sMaster.is_empty())
+            return 0;
+
+        // The samples are counted by the analysis and by the rendering
+        bool render         = cfg->nProduce & OUT_AUDIO;
+        bool need_master    = (fg->sMasterProfile.is_empty()) || ((render) && (!cfg->bMastering));
+        wsize_t master      = (need_master) ? input_samples(cfg, &fg->sMaster) : 0;
+        wsize_t count       = (fg->sMasterProfile.is_empty()) ? master : 0;
+
+        for (size_t i=unit->nFirst, n=unit->nFirst + unit->nCount; i<n; ++i)
         {
-            LSPString *gname = gnames.uget(i);
+            LSPString *pname    = fg->vProfiles.get(i);
+            bool has_profile    = (pname != NULL) && (!pname->is_empty());
+            wsize_t child       = ((!has_profile) || ((render) && (cfg->bMastering))) ?
+                input_samples(cfg, fg->vFiles.uget(i)) : 0;
+
+            if (!has_profile)
+                count              += child;
+            if (render)
+                count              += (cfg->bMastering) ? child : master;
+        }
+
+        return count;
+    }
+
+    static status_t process_work_unit(config_t *cfg, const work_unit_t *unit, arena_t *arenas,
+        naming_t *naming, manifest_t *manifest)
+    {
+        fgroup_t *fg        = unit->pGroup;
+        wsize_t start       = system::get_time_millis();
+        progress_slot_t *ps = progress_worker(0);
+        status_t res;
+
+        // The headers of input files are read only if the progress is reported
+        if (ps != NULL)
+            progress_begin_unit(&fg->sName, expected_samples(cfg, unit));
+
+        if ((unit->nFirst == 0) && (unit->nCount >= fg->vFiles.size()))
+            res                 = process_file_group(cfg, fg, arenas, naming);
+        else
+            res                 = process_group_range(cfg, unit, arenas, naming);
+
+        progress_stage(ps, PSTAGE_IDLE);
+        if (ps != NULL)
+            progress_end_unit();
+
+        if (naming->pOutputs != NULL)
+            record_work_unit(manifest, unit, naming->pOutputs, res, system::get_time_millis() - start);
+
+        return res;
+    }
+
+    static status_t process_jobs(config_t *cfg, arena_t *arenas, naming_t *naming, manifest_t *manifest, size_t threads)
+    {
+        io::InSequence is;
+        status_t res        = is.open(&cfg->sJobs);
+        if (res != STATUS_OK)
+        {
+            fprintf(stderr, "  could not open jobs file '%s'\n", cfg->sJobs.get_native());
+            return res;
+        }
+
+        // Only one group is kept in memory, it is processed right after it has been read
+        size_t line         = 0;
+        size_t count        = 0;
+        for (size_t index=0; ; ++index)
+        {
+            fgroup_t fg;
+            if ((res = read_job(&fg, &is, &line)) != STATUS_OK)
+            {
+                if (res == STATUS_EOF)
+                    res     = STATUS_OK;
+                else
+                    fprintf(stderr, "  error parsing job at line %d of file '%s'\n", int(line), cfg->sJobs.get_native());
+                break;
+            }
+
+            // The jobs are not known in advance, so they are distributed between shards in turn
+            if ((cfg->nShards > 0) && ((index % cfg->nShards) != size_t(cfg->nShard - 1)))
+                continue;
+            progress_units(1);
+
+            if ((res = resolve_group_files(cfg, &fg, threads)) != STATUS_OK)
+                break;
+
+            printf("processing group '%s'...\n", fg.sName.get_native());
+            if (!fg.sGlob.is_empty())
+                printf("  resolved %d child files\n", int(fg.vFiles.size()));
+
+            work_unit_t unit;
+            unit.pGroup         = &fg;
+            unit.nFirst         = 0;
+            unit.nCount         = fg.vFiles.size();
+            unit.fMaster        = 0.0;
+            unit.fCost          = 0.0;
+            unit.nShard         = lsp_max(cfg->nShard - 1, ssize_t(0));
+
+            if ((res = process_work_unit(cfg, &unit, arenas, naming, manifest)) != STATUS_OK)
+                break;
+            ++count;
+        }
+
+        is.close();
+
+        if (res == STATUS_OK)
+            printf("processed %d groups from jobs file '%s'\n", int(count), cfg->sJobs.get_native());
+
+        return res;
+    }
+
+    static status_t process_shard(config_t *cfg, lltl::parray<LSPString> *gnames, arena_t *arenas,
+        naming_t *naming, manifest_t *manifest, size_t threads)
+    {
+        lltl::darray<work_unit_t> files, units;
+        status_t res        = STATUS_OK;
+
+        // All shards estimate the whole batch to get the same partitioning
+        for (size_t i=0, n=gnames->size(); (res == STATUS_OK) && (i<n); ++i)
+        {
+            fgroup_t *fg        = cfg->vGroups.get(gnames->uget(i));
+            if (fg == NULL)
+                res                 = STATUS_UNKNOWN_ERR;
+            else if ((res = resolve_group_files(cfg, fg, threads)) == STATUS_OK)
+                res                 = estimate_work_units(&files, cfg, fg);
+        }
+        if (res == STATUS_OK)
+            res                 = partition_work_units(&units, &files, cfg->nShards);
+        for (size_t i=0, n=units.size(); (res == STATUS_OK) && (i<n); ++i)
+        {
+            if (units.uget(i)->nShard == size_t(cfg->nShard - 1))
+                progress_units(1);
+        }
+
+        for (size_t i=0, n=units.size(); (res == STATUS_OK) && (i<n); ++i)
+        {
+            work_unit_t *unit   = units.uget(i);
+            if (unit->nShard != size_t(cfg->nShard - 1))
+                continue;
+
+            fgroup_t *fg        = unit->pGroup;
+            if ((unit->nFirst == 0) && (unit->nCount >= fg->vFiles.size()))
+                printf("processing group '%s'...\n", fg->sName.get_native());
+            else
+                printf("processing group '%s', child files %d-%d of %d...\n", fg->sName.get_native(),
+                    int(unit->nFirst + 1), int(unit->nFirst + unit->nCount), int(fg->vFiles.size()));
+
+            res                 = process_work_unit(cfg, unit, arenas, naming, manifest);
+        }
+
+        for (size_t i=0, n=gnames->size(); i<n; ++i)
+        {
+            fgroup_t *fg        = cfg->vGroups.get(gnames->uget(i));
+            if (fg != NULL)
+                release_group_files(fg);
+        }
+
+        return res;
+    }
+
+    static status_t process_groups(config_t *cfg, lltl::parray<LSPString> *gnames, arena_t *arenas,
+        naming_t *naming, manifest_t *manifest, size_t threads)
+    {
+        status_t res        = STATUS_OK;
+
+        for (size_t i=0, n=gnames->size(); i<n; ++i)
+        {
+            LSPString *gname = gnames->uget(i);
             if (gname == NULL)
                 return STATUS_NO_MEM;
 
@@ -300,9 +758,43 @@ namespace timbremill
             if (fg == NULL)
                 return STATUS_UNKNOWN_ERR;
 
-            printf("processing group '%s'...\n", gname->get_native());
+            // The files of the first group are resolved in place, the files of each next
+            // group are resolved in background while the previous group is processed
+            if ((i == 0) && ((res = resolve_group_files(cfg, fg, threads)) != STATUS_OK))
+                return res;
+
+            prefetch_t pf;
+            pf.pConfig      = cfg;
+            pf.pGroup       = (i + 1 < n) ? cfg->vGroups.get(gnames->uget(i + 1)) : NULL;
+            pf.nThreads     = 1;            // The render pool already uses all threads, scan in the prefetch thread only
+            pf.nResult      = STATUS_OK;
 
-            status_t res = process_file_group(cfg, fg);
+            ipc::Thread prefetch(prefetch_group, &pf);
+            bool started    = (pf.pGroup != NULL) && (prefetch.start() == STATUS_OK);
+
+            printf("processing group '%s'...\n", gname->get_native());
+            if (!fg->sGlob.is_empty())
+                printf("  resolved %d child files\n", int(fg->vFiles.size()));
+
+            work_unit_t unit;
+            unit.pGroup     = fg;
+            unit.nFirst     = 0;
+            unit.nCount     = fg->vFiles.size();
+            unit.fMaster    = 0.0;
+            unit.fCost      = 0.0;
+            unit.nShard     = 0;
+
+            res             = process_work_unit(cfg, &unit, arenas, naming, manifest);
+            release_group_files(fg);
+
+            // Wait for the files of the next group
+            if (started)
+                prefetch.join();
+            else if ((pf.pGroup != NULL) && (res == STATUS_OK))
+                pf.nResult      = resolve_group_files(cfg, pf.pGroup, threads);
+
+            if (res == STATUS_OK)
+                res             = pf.nResult;
             if (res != STATUS_OK)
                 return res;
         }
@@ -310,6 +802,72 @@ namespace timbremill
         return STATUS_OK;
     }
 
+    status_t process_file_groups(config_t *cfg)
+    {
+        status_t res        = discover_groups(cfg);
+        if (res != STATUS_OK)
+            return res;
+
+        lltl::parray<LSPString> gnames;
+        if (!cfg->vGroups.keys(&gnames))
+            return STATUS_NO_MEM;
+        gnames.qsort(compare_group_names);
+
+        naming_t naming;
+        if ((res = compile_file_names(&naming, cfg)) != STATUS_OK)
+            return res;
+
+        // The output files of each work unit are recorded if the manifest is written
+        manifest_t manifest;
+        lltl::parray<LSPString> outputs;
+        if ((res = open_manifest(&manifest, cfg)) != STATUS_OK)
+            return res;
+        if (manifest.pOut != NULL)
+            naming.pOutputs = &outputs;
+
+        // Temporary buffers are borrowed from arenas, one arena per worker thread,
+        // the arenas are shared by all groups
+        size_t threads      = worker_threads(cfg->nThreads);
+        arena_t *arenas     = new arena_t[threads];
+        if (arenas == NULL)
+        {
+            close_manifest(&manifest, STATUS_NO_MEM);
+            return STATUS_NO_MEM;
+        }
+
+        // The progress is tracked for each worker thread
+        if ((res = start_progress(cfg, threads)) != STATUS_OK)
+        {
+            delete [] arenas;
+            close_manifest(&manifest, res);
+            return res;
+        }
+
+        if (cfg->nShards > 0)
+            res     = process_shard(cfg, &gnames, arenas, &naming, &manifest, threads);
+        else
+        {
+            progress_units(gnames.size());
+            res     = process_groups(cfg, &gnames, arenas, &naming, &manifest, threads);
+        }
+
+        // Process the groups of the jobs file while reading it
+        if ((res == STATUS_OK) && (!cfg->sJobs.is_empty()))
+            res     = process_jobs(cfg, arenas, &naming, &manifest, threads);
+
+        stop_progress();
+
+        // Report the usage of temporary buffers
+        if (res == STATUS_OK)
+            printf("temporary buffers: %.2f MiB peak, %.2f MiB reserved\n",
+                arena_peak(arenas, threads) / 1048576.0, arena_reserved(arenas, threads) / 1048576.0);
+
+        delete [] arenas;
+        close_manifest(&manifest, res);
+
+        return res;
+    }
+
     int main(int argc, const char **argv)
     {
         // Parse configuration from file and cmdline
@@ -318,13 +876,24 @@ namespace timbremill
         if (res != STATUS_OK)
             return (res == STATUS_SKIP) ? STATUS_OK : res;
 
+        // Apply the memory policy before any allocation of large buffers
+        if ((res = set_memory_policy(cfg.bHugePages, cfg.nNuma)) != STATUS_OK)
+            return res;
+        if ((res = start_trace(&cfg.sTrace)) != STATUS_OK)
+            return res;
+
         // Perform data processing
         dsp::context_t ctx;
         dsp::init();
         dsp::start(&ctx);
-        res = process_file_groups(&cfg);
+        res = (cfg.sPlan.is_empty()) ? process_file_groups(&cfg) : plan_file_groups(&cfg);
         dsp::finish(&ctx);
 
+        // All worker threads are finished, write the trace events
+        status_t tres = flush_trace();
+        if (res == STATUS_OK)
+            res = tres;
+
         // Analyze result
         if (res != STATUS_OK)
             return res;
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <private/trace.h>
+
+#ifdef TIMBREMILL_TRACING
+    #include <lsp-plug.in/common/atomic.h>
+    #include <lsp-plug.in/runtime/system.h>
+
+    #if defined(PLATFORM_LINUX)
+        #include <sys/syscall.h>
+        #include <unistd.h>
+    #elif defined(PLATFORM_WINDOWS)
+        #include <windows.h>
+    #else
+        #include <pthread.h>
+    #endif
+#endif /* TIMBREMILL_TRACING */
+
+namespace timbremill
+{
+#ifdef TIMBREMILL_TRACING
+    typedef struct trace_record_t
+    {
+        wsize_t                 nTime;      // Time of the event (nanoseconds)
+        const char             *sName;      // Name of the event
+        ssize_t                 nArg;       // Argument of the event
+        ssize_t                 nThread;    // Identifier of the thread
+        char                    nPhase;     // Phase of the event
+    } trace_record_t;
+
+    typedef struct trace_buffer_t
+    {
+        volatile int            nBusy;      // The buffer is owned by the running thread
+        wsize_t                 nCount;     // Overall number of recorded events
+        trace_record_t          vRecords[TRACE_RING_SIZE];
+    } trace_buffer_t;
+
+    /**
+     * The ring buffer bound to the thread, it is released for the reuse by other threads
+     * when the thread finishes, so the short-living worker threads do not exhaust buffers
+     */
+    struct trace_thread_t
+    {
+        private:
+            trace_thread_t & operator = (const trace_thread_t &);
+
+        public:
+            trace_buffer_t     *pBuffer;
+            ssize_t             nThread;
+            bool                bFailed;
+
+        public:
+            explicit trace_thread_t()
+            {
+                pBuffer     = NULL;
+                nThread     = 0;
+                bFailed     = false;
+            }
+
+            ~trace_thread_t();
+    };
+
+    static trace_buffer_t * volatile    vBuffers[TRACE_MAX_THREADS];
+    static volatile int                 nBuffers    = 0;
+    static volatile bool                bEnabled    = false;
+    static wsize_t                      nOrigin     = 0;
+    static LSPString                    sTracePath;
+    static thread_local trace_thread_t  sThread;
+
+    trace_thread_t::~trace_thread_t()
+    {
+        // The buffers are deleted after the events have been written
+        if ((pBuffer != NULL) && (bEnabled))
+            atomic_store(&pBuffer->nBusy, 0);
+    }
+
+    static inline wsize_t trace_time()
+    {
+        system::time_t t;
+        system::get_time(&t);
+        return wsize_t(t.seconds) * 1000000000 + t.nanos;
+    }
+
+    static inline ssize_t trace_thread_id()
+    {
+    #if defined(PLATFORM_LINUX)
+        return syscall(SYS_gettid);
+    #elif defined(PLATFORM_WINDOWS)
+        return GetCurrentThreadId();
+    #else
+        return ssize_t(uintptr_t(pthread_self()));
+    #endif
+    }
+
+    static trace_buffer_t *acquire_buffer()
+    {
+        // Reuse the buffer of the finished thread
+        size_t count        = lsp_min(size_t(atomic_load(&nBuffers)), size_t(TRACE_MAX_THREADS));
+        for (size_t i=0; i<count; ++i)
+        {
+            trace_buffer_t *b   = vBuffers[i];
+            if ((b != NULL) && (atomic_cas(&b->nBusy, 0, 1)))
+                return b;
+        }
+
+        // Register the new buffer
+        int index           = atomic_add(&nBuffers, 1);
+        if (index >= TRACE_MAX_THREADS)
+            return NULL;
+
+        trace_buffer_t *b   = new trace_buffer_t;
+        if (b == NULL)
+            return NULL;
+        b->nBusy            = 1;
+        b->nCount           = 0;
+        vBuffers[index]     = b;
+
+        return b;
+    }
+
+    void trace_event(const char *name, ssize_t arg, char phase)
+    {
+        if (!bEnabled)
+            return;
+
+        trace_buffer_t *b   = sThread.pBuffer;
+        if (b == NULL)
+        {
+            if (sThread.bFailed)
+                return;
+            if ((b = acquire_buffer()) == NULL)
+            {
+                sThread.bFailed     = true;
+                return;
+            }
+            // The buffer may be reused by another thread later, so each record keeps the thread
+            sThread.pBuffer     = b;
+            sThread.nThread     = trace_thread_id();
+        }
+
+        // Only the owner thread writes to the buffer, the oldest events are overwritten
+        trace_record_t *r   = &b->vRecords[b->nCount % TRACE_RING_SIZE];
+        r->nTime            = trace_time();
+        r->sName            = name;
+        r->nArg             = arg;
+        r->nThread          = sThread.nThread;
+        r->nPhase           = phase;
+        ++b->nCount;
+    }
+
+    status_t start_trace(const LSPString *path)
+    {
+        if (path->is_empty())
+            return STATUS_OK;
+        if (!sTracePath.set(path))
+            return STATUS_NO_MEM;
+
+        nOrigin             = trace_time();
+        bEnabled            = true;
+
+        return STATUS_OK;
+    }
+
+    status_t flush_trace()
+    {
+        if (!bEnabled)
+            return STATUS_OK;
+        bEnabled            = false;
+
+        FILE *out           = fopen(sTracePath.get_native(), "w");
+        if (out == NULL)
+        {
+            fprintf(stderr, "  could not create trace file '%s'\n", sTracePath.get_native());
+            return STATUS_IO_ERROR;
+        }
+
+        fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [", out);
+        size_t count        = lsp_min(size_t(atomic_load(&nBuffers)), size_t(TRACE_MAX_THREADS));
+        size_t events       = 0;
+        for (size_t i=0; i<count; ++i)
+        {
+            trace_buffer_t *b   = vBuffers[i];
+            if (b == NULL)
+                continue;
+
+            wsize_t first       = (b->nCount > TRACE_RING_SIZE) ? b->nCount - TRACE_RING_SIZE : 0;
+            ssize_t thread      = -1;
+            size_t depth        = 0;
+            for (wsize_t j=first; j<b->nCount; ++j)
+            {
+                const trace_record_t *r = &b->vRecords[j % TRACE_RING_SIZE];
+
+                // Each thread that used the buffer gets its own track
+                if (r->nThread != thread)
+                {
+                    thread              = r->nThread;
+                    depth               = 0;
+                    fprintf(out, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %lld, \"args\": {\"name\": \"thread %lld\"}}",
+                        (events > 0) ? "," : "", (long long)thread, (long long)thread);
+                    ++events;
+                }
+
+                // The begin events of the oldest end events may be overwritten by the ring buffer
+                if (r->nPhase == 'B')
+                    ++depth;
+                else if (depth > 0)
+                    --depth;
+                else
+                    continue;
+
+                fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %lld",
+                    r->sName, r->nPhase, (r->nTime - nOrigin) * 1e-3, (long long)thread);
+                if (r->nArg >= 0)
+                    fprintf(out, ", \"args\": {\"index\": %d}", int(r->nArg));
+                fputs("}", out);
+            }
+
+            vBuffers[i]         = NULL;
+            delete b;
+        }
+        fputs("\n]}\n", out);
+        fclose(out);
+
+        fprintf(stderr, "trace events written to '%s'\n", sTracePath.get_native());
+
+        return STATUS_OK;
+    }
+#else
+    status_t start_trace(const LSPString *path)
+    {
+        if (!path->is_empty())
+            fprintf(stderr, "  tracing is not available in this build, rebuild with TRACE=1\n");
+        return STATUS_OK;
+    }
+
+    status_t flush_trace()
+    {
+        return STATUS_OK;
+    }
+#endif /* TIMBREMILL_TRACING */
+} /* namespace timbremill */
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/dsp/dsp.h>
+#include <lsp-plug.in/ipc/Mutex.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/lltl/parray.h>
+#include <private/memory.h>
+#include <private/workers.h>
+
+namespace timbremill
+{
+    typedef struct pool_t
+    {
+        parallel_task_t     pTask;      // Task to execute
+        void               *pArg;       // Argument of the task
+        size_t              nCount;     // Number of tasks
+        size_t              nNext;      // Next task to execute
+        status_t            nResult;    // Result of execution
+        ipc::Mutex          sLock;      // Lock for the state
+    } pool_t;
+
+    typedef struct worker_t
+    {
+        pool_t             *pPool;      // The pool of tasks
+        size_t              nIndex;     // Index of the worker
+    } worker_t;
+
+    static status_t pool_worker(void *arg)
+    {
+        worker_t *w     = static_cast<worker_t *>(arg);
+        pool_t *pool    = w->pPool;
+        dsp::context_t ctx;
+
+        pin_worker(w->nIndex);
+        dsp::start(&ctx);
+
+        while (true)
+        {
+            // Fetch the next task
+            pool->sLock.lock();
+            size_t index    = pool->nNext;
+            bool done       = (index >= pool->nCount) || (pool->nResult != STATUS_OK);
+            if (!done)
+                ++pool->nNext;
+            pool->sLock.unlock();
+
+            if (done)
+                break;
+
+            // Execute the task and store the first error
+            status_t res    = pool->pTask(pool->pArg, index, w->nIndex);
+            if (res != STATUS_OK)
+            {
+                pool->sLock.lock();
+                if (pool->nResult == STATUS_OK)
+                    pool->nResult   = res;
+                pool->sLock.unlock();
+            }
+        }
+
+        dsp::finish(&ctx);
+
+        return STATUS_OK;
+    }
+
+    size_t worker_threads(ssize_t threads)
+    {
+        if (threads > 0)
+            return threads;
+
+        size_t cores = ipc::Thread::system_cores();
+        return (cores > 0) ? cores : 1;
+    }
+
+    status_t run_parallel(parallel_task_t task, void *arg, size_t count, size_t threads)
+    {
+        pool_t pool;
+        pool.pTask      = task;
+        pool.pArg       = arg;
+        pool.nCount     = count;
+        pool.nNext      = 0;
+        pool.nResult    = STATUS_OK;
+
+        // Execute tasks in the calling thread if there is no need in extra threads
+        threads         = lsp_min(threads, count);
+        if (threads <= 1)
+        {
+            for (size_t i=0; i<count; ++i)
+            {
+                status_t res = task(arg, i, 0);
+                if (res != STATUS_OK)
+                    return res;
+            }
+            return STATUS_OK;
+        }
+
+        // Start additional threads
+        worker_t *vw    = new worker_t[threads];
+        if (vw == NULL)
+            return STATUS_NO_MEM;
+        for (size_t i=0; i<threads; ++i)
+        {
+            vw[i].pPool     = &pool;
+            vw[i].nIndex    = i;
+        }
+
+        lltl::parray<ipc::Thread> workers;
+        for (size_t i=1; i<threads; ++i)
+        {
+            ipc::Thread *t  = new ipc::Thread(pool_worker, &vw[i]);
+            if (t == NULL)
+                break;
+            if ((!workers.add(t)) || (t->start() != STATUS_OK))
+            {
+                workers.premove(t);
+                delete t;
+                break;
+            }
+        }
+
+        // Help the workers and wait for them
+        pool_worker(&vw[0]);
+        for (size_t i=0, n=workers.size(); i<n; ++i)
+        {
+            ipc::Thread *t  = workers.uget(i);
+            t->join();
+            delete t;
+        }
+        workers.flush();
+        unpin_worker();
+        delete [] vw;
+
+        return pool.nResult;
+    }
+} /* namespace timbremill */
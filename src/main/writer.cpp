@@ -0,0 +1,464 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/io/OutFileStream.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/writer.h>
+
+#ifdef USE_LIBSNDFILE
+    #include <sndfile.h>
+#endif /* USE_LIBSNDFILE */
+
+#define WRITER_BLOCK_SIZE   (1 << 20)
+#define WRITER_ALIGN        0x1000
+#define WRITER_FRAMES       4096
+#define WAV_FORMAT_PCM      1
+#define WAV_FORMAT_FLOAT    3
+#define WAV_FORMAT_EXT      0xfffe
+#define WAV_FMT_SIZE        16
+#define WAV_FMT_EXT_SIZE    40
+#define WAV_HEADER_SIZE     44
+#define RF64_HEADER_SIZE    80
+#define W64_HEADER_SIZE     104
+#define HEADER_SIZE_MAX     (W64_HEADER_SIZE + WAV_FMT_EXT_SIZE - WAV_FMT_SIZE)
+
+namespace timbremill
+{
+    typedef struct dither_state_t
+    {
+        uint32_t        nSeed;          // State of the random number generator
+        float           fError;         // Quantization error for the noise shaping
+    } dither_state_t;
+
+    typedef struct wbuffer_t
+    {
+        io::OutFileStream   sOS;        // Output file stream
+        uint8_t            *vData;      // Aligned buffer data
+        size_t              nFill;      // Number of bytes stored in the buffer
+    } wbuffer_t;
+
+    static const uint8_t w64_riff_guid[]    = { 0x72, 0x69, 0x66, 0x66, 0x2e, 0x91, 0xcf, 0x11, 0xa5, 0xd6, 0x28, 0xdb, 0x04, 0xc1, 0x00, 0x00 };
+    static const uint8_t w64_wave_guid[]    = { 0x77, 0x61, 0x76, 0x65, 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a };
+    static const uint8_t w64_fmt_guid[]     = { 0x66, 0x6d, 0x74, 0x20, 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a };
+    static const uint8_t w64_data_guid[]    = { 0x64, 0x61, 0x74, 0x61, 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a };
+    static const uint8_t wav_ext_guid[]     = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+
+    // Default speaker layouts of the extensible format for 1..8 channels
+    static const uint32_t wav_channel_masks[] = { 0x4, 0x3, 0x7, 0x33, 0x37, 0x3f, 0x13f, 0x63f };
+
+    static inline void put_u16(uint8_t *dst, uint16_t v)
+    {
+        dst[0]  = uint8_t(v);
+        dst[1]  = uint8_t(v >> 8);
+    }
+
+    static inline void put_u32(uint8_t *dst, uint32_t v)
+    {
+        dst[0]  = uint8_t(v);
+        dst[1]  = uint8_t(v >> 8);
+        dst[2]  = uint8_t(v >> 16);
+        dst[3]  = uint8_t(v >> 24);
+    }
+
+    static inline void put_u64(uint8_t *dst, uint64_t v)
+    {
+        put_u32(&dst[0], uint32_t(v));
+        put_u32(&dst[4], uint32_t(v >> 32));
+    }
+
+    static inline float tpdf_noise(uint32_t *seed)
+    {
+        // Sum of two uniform distributions in range of [-0.5, 0.5) gives triangular distribution
+        uint32_t a      = *seed * 1664525u + 1013904223u;
+        uint32_t b      = a * 1664525u + 1013904223u;
+        *seed           = b;
+
+        return (float(a >> 8) - float(b >> 8)) * (1.0f / 16777216.0f);
+    }
+
+    static inline int32_t quantize(float v, float max, ssize_t dither, dither_state_t *ds)
+    {
+        float q;
+
+        if (dither == DITHER_SHAPED)
+        {
+            // First-order error feedback moves the quantization noise to high frequencies
+            v              -= ds->fError;
+            q               = roundf(v + tpdf_noise(&ds->nSeed));
+            ds->fError      = q - v;
+        }
+        else if (dither == DITHER_TPDF)
+            q               = roundf(v + tpdf_noise(&ds->nSeed));
+        else
+            q               = roundf(v);
+
+        return lsp_limit(q, -max - 1.0f, max);
+    }
+
+    static void encode_pcm(uint8_t *dst, size_t stride, size_t bytes,
+        const float *src, size_t count, float k, float max, ssize_t dither, dither_state_t *ds)
+    {
+        for (size_t i=0; i<count; ++i, dst += stride)
+        {
+            int32_t s       = quantize(src[i] * k, max, dither, ds);
+            dst[0]          = uint8_t(s);
+            dst[1]          = uint8_t(s >> 8);
+            if (bytes > 2)
+                dst[2]          = uint8_t(s >> 16);
+        }
+    }
+
+    static void encode_pcm32(uint8_t *dst, size_t stride, const float *src, size_t count, float k)
+    {
+        double kd       = double(k) * 2147483647.0;
+        for (size_t i=0; i<count; ++i, dst += stride)
+        {
+            double v        = lsp_limit(src[i] * kd, -2147483648.0, 2147483647.0);
+            put_u32(dst, uint32_t(int32_t(llrint(v))));
+        }
+    }
+
+    static void encode_float(uint8_t *dst, size_t stride, const float *src, size_t count, float k)
+    {
+        for (size_t i=0; i<count; ++i, dst += stride)
+        {
+            float v         = src[i] * k;
+            uint32_t u;
+            memcpy(&u, &v, sizeof(u));
+            put_u32(dst, u);
+        }
+    }
+
+    static void encode_frames(uint8_t *dst, const dspu::Sample *sample, size_t offset, size_t count,
+        const fformat_t *format, float gain, dither_state_t *ds)
+    {
+        size_t channels     = sample->channels();
+        size_t bytes        = (format->nEncoding == ENC_PCM16) ? 2 :
+                              (format->nEncoding == ENC_PCM24) ? 3 : 4;
+        size_t frame_size   = channels * bytes;
+
+        for (size_t i=0; i<channels; ++i)
+        {
+            const float *src    = &sample->channel(i)[offset];
+            uint8_t *cdst       = &dst[i * bytes];
+
+            switch (format->nEncoding)
+            {
+                case ENC_PCM16:
+                    encode_pcm(cdst, frame_size, 2, src, count, gain * 32767.0f, 32767.0f, format->nDither, &ds[i]);
+                    break;
+                case ENC_PCM24:
+                    encode_pcm(cdst, frame_size, 3, src, count, gain * 8388607.0f, 8388607.0f, format->nDither, &ds[i]);
+                    break;
+                case ENC_PCM32:
+                    encode_pcm32(cdst, frame_size, src, count, gain);
+                    break;
+                default:
+                    encode_float(cdst, frame_size, src, count, gain);
+                    break;
+            }
+        }
+    }
+
+    static dither_state_t *create_dither(size_t channels)
+    {
+        dither_state_t *ds  = new dither_state_t[lsp_max(channels, size_t(1))];
+        if (ds == NULL)
+            return NULL;
+
+        for (size_t i=0; i<channels; ++i)
+        {
+            ds[i].nSeed         = 0x1234567u + i * 0x9e3779b9u;
+            ds[i].fError        = 0.0f;
+        }
+
+        return ds;
+    }
+
+    static inline size_t wav_fmt_size(const dspu::Sample *sample, ssize_t encoding, size_t bytes)
+    {
+        // The extensible format is required for more than 2 channels or integer samples of more than 16 bits,
+        // the stereo floating-point data is written with the plain IEEE float format as most readers expect
+        bool pcm            = encoding != ENC_FLOAT32;
+        return ((sample->channels() > 2) || ((pcm) && (bytes > 2))) ? WAV_FMT_EXT_SIZE : WAV_FMT_SIZE;
+    }
+
+    static void put_wav_fmt(uint8_t *dst, const dspu::Sample *sample, ssize_t encoding, size_t bytes)
+    {
+        size_t channels     = sample->channels();
+        size_t frame_size   = channels * bytes;
+        uint16_t tag        = (encoding == ENC_FLOAT32) ? WAV_FORMAT_FLOAT : WAV_FORMAT_PCM;
+        bool extensible     = wav_fmt_size(sample, encoding, bytes) == WAV_FMT_EXT_SIZE;
+
+        put_u16(&dst[0], (extensible) ? WAV_FORMAT_EXT : tag);
+        put_u16(&dst[2], channels);
+        put_u32(&dst[4], sample->sample_rate());
+        put_u32(&dst[8], sample->sample_rate() * frame_size);
+        put_u16(&dst[12], frame_size);
+        put_u16(&dst[14], bytes * 8);
+        if (!extensible)
+            return;
+
+        // The extension: valid bits, channel mask and the GUID of the sub-format
+        put_u16(&dst[16], 22);
+        put_u16(&dst[18], bytes * 8);
+        put_u32(&dst[20], (channels <= 8) ? wav_channel_masks[channels - 1] : 0);
+        put_u16(&dst[24], tag);
+        memcpy(&dst[26], wav_ext_guid, sizeof(wav_ext_guid));
+    }
+
+    static size_t header_size(const dspu::Sample *sample, const fformat_t *format, size_t bytes)
+    {
+        size_t ext          = wav_fmt_size(sample, format->nEncoding, bytes) - WAV_FMT_SIZE;
+
+        switch (format->nContainer)
+        {
+            case CONT_RAW:  return 0;
+            case CONT_RF64: return RF64_HEADER_SIZE + ext;
+            case CONT_W64:  return W64_HEADER_SIZE + ext;
+            default:        break;
+        }
+
+        return WAV_HEADER_SIZE + ext;
+    }
+
+    static size_t put_header(uint8_t *dst, const dspu::Sample *sample, const fformat_t *format, size_t bytes, wsize_t data_size)
+    {
+        size_t fmt_size     = wav_fmt_size(sample, format->nEncoding, bytes);
+        size_t hdr_size     = header_size(sample, format, bytes);
+        wsize_t riff_size   = data_size + (data_size & 1) + hdr_size - 8;   // The RIFF chunks are word-aligned
+
+        switch (format->nContainer)
+        {
+            case CONT_RAW:
+                return 0;
+
+            case CONT_RF64:
+                memcpy(&dst[0], "RF64", 4);
+                put_u32(&dst[4], 0xffffffffu);
+                memcpy(&dst[8], "WAVE", 4);
+                memcpy(&dst[12], "ds64", 4);
+                put_u32(&dst[16], 28);
+                put_u64(&dst[20], riff_size);
+                put_u64(&dst[28], data_size);
+                put_u64(&dst[36], sample->length());
+                put_u32(&dst[44], 0);
+                memcpy(&dst[48], "fmt ", 4);
+                put_u32(&dst[52], fmt_size);
+                put_wav_fmt(&dst[56], sample, format->nEncoding, bytes);
+                memcpy(&dst[hdr_size - 8], "data", 4);
+                put_u32(&dst[hdr_size - 4], 0xffffffffu);
+                return hdr_size;
+
+            case CONT_W64:
+            {
+                // The data chunk of W64 file is padded to 8 bytes, the size of the extensible
+                // format chunk is already a multiple of 8 bytes
+                wsize_t padded      = (data_size + 7) & ~wsize_t(7);
+                memcpy(&dst[0], w64_riff_guid, 16);
+                put_u64(&dst[16], padded + hdr_size);
+                memcpy(&dst[24], w64_wave_guid, 16);
+                memcpy(&dst[40], w64_fmt_guid, 16);
+                put_u64(&dst[56], fmt_size + 24);
+                put_wav_fmt(&dst[64], sample, format->nEncoding, bytes);
+                memcpy(&dst[hdr_size - 24], w64_data_guid, 16);
+                put_u64(&dst[hdr_size - 8], data_size + 24);
+                return hdr_size;
+            }
+
+            default:
+                break;
+        }
+
+        memcpy(&dst[0], "RIFF", 4);
+        put_u32(&dst[4], uint32_t(riff_size));
+        memcpy(&dst[8], "WAVE", 4);
+        memcpy(&dst[12], "fmt ", 4);
+        put_u32(&dst[16], fmt_size);
+        put_wav_fmt(&dst[20], sample, format->nEncoding, bytes);
+        memcpy(&dst[hdr_size - 8], "data", 4);
+        put_u32(&dst[hdr_size - 4], uint32_t(data_size));
+        return hdr_size;
+    }
+
+    static status_t flush_buffer(wbuffer_t *wb, size_t amount)
+    {
+        if (amount == 0)
+            return STATUS_OK;
+        if (wb->sOS.write(wb->vData, amount) != ssize_t(amount))
+            return STATUS_IO_ERROR;
+
+        // Move the rest of data to the beginning of the buffer
+        wb->nFill      -= amount;
+        if (wb->nFill > 0)
+            memmove(wb->vData, &wb->vData[amount], wb->nFill);
+
+        return STATUS_OK;
+    }
+
+    static status_t write_native_file(const io::Path *path, const dspu::Sample *sample, const fformat_t *format, float gain)
+    {
+        wbuffer_t wb;
+        uint8_t *ptr        = NULL;
+        status_t res;
+
+        size_t channels     = sample->channels();
+        size_t length       = sample->length();
+        size_t bytes        = (format->nEncoding == ENC_PCM16) ? 2 :
+                              (format->nEncoding == ENC_PCM24) ? 3 : 4;
+        size_t frame_size   = channels * bytes;
+        wsize_t data_size   = wsize_t(length) * frame_size;
+        if ((format->nContainer == CONT_WAV) && ((data_size + (data_size & 1) + header_size(sample, format, bytes) - 8) > 0xffffffffu))
+        {
+            fprintf(stderr, "  the data is too large for the WAV file, use RF64 or W64 container instead\n");
+            return STATUS_OVERFLOW;
+        }
+
+        // The buffer is always flushed by blocks of the fixed size, the extra space
+        // at the end of the buffer holds the frames that cross the block boundary
+        size_t extra        = lsp_max(frame_size * WRITER_FRAMES, size_t(HEADER_SIZE_MAX));
+        size_t to_alloc     = WRITER_BLOCK_SIZE + ((extra + WRITER_ALIGN - 1) & ~size_t(WRITER_ALIGN - 1));
+        wb.vData            = alloc_aligned<uint8_t>(ptr, to_alloc, WRITER_ALIGN);
+        if (wb.vData == NULL)
+            return STATUS_NO_MEM;
+        dither_state_t *ds  = create_dither(channels);
+        if (ds == NULL)
+        {
+            free_aligned(ptr);
+            return STATUS_NO_MEM;
+        }
+
+        // Form the header and open the file
+        wb.nFill            = put_header(wb.vData, sample, format, bytes, data_size);
+        res                 = wb.sOS.open(path, io::File::FM_WRITE_NEW);
+
+        // Encode and write the data block by block
+        for (size_t off=0; (res == STATUS_OK) && (off < length); )
+        {
+            size_t count        = lsp_min(length - off, size_t(WRITER_FRAMES));
+            encode_frames(&wb.vData[wb.nFill], sample, off, count, format, gain, ds);
+            wb.nFill           += count * frame_size;
+            off                += count;
+
+            while ((res == STATUS_OK) && (wb.nFill >= WRITER_BLOCK_SIZE))
+                res                 = flush_buffer(&wb, WRITER_BLOCK_SIZE);
+        }
+
+        // Write the padding and the rest of the data
+        if (res == STATUS_OK)
+        {
+            // The W64 chunks are aligned to 8 bytes, the RIFF chunks are word-aligned
+            size_t pad          = (format->nContainer == CONT_W64) ? size_t(-data_size) & 7 :
+                                  (format->nContainer != CONT_RAW) ? size_t(data_size & 1) : 0;
+            memset(&wb.vData[wb.nFill], 0, pad);
+            wb.nFill           += pad;
+            res                 = flush_buffer(&wb, wb.nFill);
+        }
+
+        // Close the file and release resources
+        status_t cres       = wb.sOS.close();
+        if (res == STATUS_OK)
+            res                 = cres;
+        delete [] ds;
+        free_aligned(ptr);
+
+        return res;
+    }
+
+    static status_t write_flac_file(const io::Path *path, const dspu::Sample *sample, const fformat_t *format, float gain)
+    {
+    #ifdef USE_LIBSNDFILE
+        size_t channels     = sample->channels();
+        size_t length       = sample->length();
+        size_t bits         = (format->nEncoding == ENC_PCM16) ? 16 : 24;
+        float max           = (1 << (bits - 1)) - 1;
+        size_t shift        = 32 - bits;
+
+        // Open the file
+        SF_INFO info;
+        memset(&info, 0, sizeof(info));
+        info.frames         = length;
+        info.samplerate     = sample->sample_rate();
+        info.channels       = channels;
+        info.format         = SF_FORMAT_FLAC | ((bits == 16) ? SF_FORMAT_PCM_16 : SF_FORMAT_PCM_24);
+
+        SNDFILE *sf         = sf_open(path->as_native(), SFM_WRITE, &info);
+        if (sf == NULL)
+        {
+            fprintf(stderr, "  could not create FLAC file: %s\n", sf_strerror(NULL));
+            return STATUS_IO_ERROR;
+        }
+
+        // Allocate the buffer and the dither state
+        status_t res        = STATUS_OK;
+        int *buf            = new int[WRITER_FRAMES * channels];
+        dither_state_t *ds  = create_dither(channels);
+        if ((buf == NULL) || (ds == NULL))
+            res                 = STATUS_NO_MEM;
+
+        // Encode the data, libsndfile takes the integer samples aligned to the most significant bit
+        for (size_t off=0; (res == STATUS_OK) && (off < length); off += WRITER_FRAMES)
+        {
+            size_t count        = lsp_min(length - off, size_t(WRITER_FRAMES));
+            for (size_t i=0; i<channels; ++i)
+            {
+                const float *src    = &sample->channel(i)[off];
+                int *dst            = &buf[i];
+                for (size_t j=0; j<count; ++j, dst += channels)
+                    *dst                = int(uint32_t(quantize(src[j] * gain * max, max, format->nDither, &ds[i])) << shift);
+            }
+
+            if (sf_writef_int(sf, buf, count) != sf_count_t(count))
+                res                 = STATUS_IO_ERROR;
+        }
+
+        // Close the file and release resources
+        if ((sf_close(sf) != 0) && (res == STATUS_OK))
+            res                 = STATUS_IO_ERROR;
+        if (ds != NULL)
+            delete [] ds;
+        if (buf != NULL)
+            delete [] buf;
+
+        return res;
+    #else
+        fprintf(stderr, "  FLAC files are not supported on this platform\n");
+        return STATUS_NOT_SUPPORTED;
+    #endif /* USE_LIBSNDFILE */
+    }
+
+    status_t write_audio_file(const io::Path *path, const dspu::Sample *sample, const fformat_t *format, float gain)
+    {
+        if (format->nContainer != CONT_FLAC)
+            return write_native_file(path, sample, format, gain);
+
+        if ((format->nEncoding != ENC_PCM16) && (format->nEncoding != ENC_PCM24))
+        {
+            fprintf(stderr, "  FLAC files support only pcm16 and pcm24 encodings\n");
+            return STATUS_BAD_FORMAT;
+        }
+
+        return write_flac_file(path, sample, format, gain);
+    }
+} /* namespace timbremill */
@@ -41,13 +41,13 @@ MTEST_BEGIN("timbremill", profile)
         MTEST_ASSERT(base.set_native(resources()));
         MTEST_ASSERT(name.set_ascii("samples/trumpet/trp unmuted.wav"));
         MTEST_ASSERT(timbremill::load_audio_file(&s, &file_sr, SAMPLE_RATE, &base, &name) == STATUS_OK);
-        MTEST_ASSERT(timbremill::spectral_profile(&pu, &s, FFT_PRECISION) == STATUS_OK);
+        MTEST_ASSERT(timbremill::spectral_profile(&pu, &s, FFT_PRECISION, 0, NULL, NULL) == STATUS_OK);
 
         // Load the 'plunger' audio file and compute spectral profile
         MTEST_ASSERT(base.set_native(resources()));
         MTEST_ASSERT(name.set_ascii("samples/trumpet/trp plunger.wav"));
         MTEST_ASSERT(timbremill::load_audio_file(&s, &file_sr, SAMPLE_RATE, &base, &name) == STATUS_OK);
-        MTEST_ASSERT(timbremill::spectral_profile(&pp, &s, FFT_PRECISION) == STATUS_OK);
+        MTEST_ASSERT(timbremill::spectral_profile(&pp, &s, FFT_PRECISION, 0, NULL, NULL) == STATUS_OK);
 
         // Compute the correction timbre
         MTEST_ASSERT(pu.channels() == pp.channels());
@@ -66,7 +66,7 @@ MTEST_BEGIN("timbremill", profile)
         MTEST_ASSERT(fd != NULL);
 
         // Emit the output file
-        ssize_t half    = pu.length() >> 1;
+        ssize_t half    = pu.length() - 1;
         float kf        = (SAMPLE_RATE * 0.5f) / half;
         float kn        = 1.0f / half;
 
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/ptest.h>
+#include <lsp-plug.in/common/alloc.h>
+#include <lsp-plug.in/dsp/dsp.h>
+#include <lsp-plug.in/dsp-units/util/Convolver.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <private/fftconv.h>
+#include <stdlib.h>
+
+#define SAMPLE_RATE         48000
+#define SRC_LENGTH          10          // Length of the source signal (seconds)
+
+static const size_t ir_lengths[] = { 1, 5, 10, 30, 60 };
+
+PTEST_BEGIN("timbremill", convolve, 5, 1)
+
+    void realtime(float *dst, const float *src, size_t length, const dspu::Sample *ir)
+    {
+        dspu::Convolver cv;
+        if (!cv.init(ir->channel(0), ir->length(), 16, 0))
+            return;
+
+        dsp::fill_zero(dst, length + ir->length());
+        cv.process(dst, src, length);
+        cv.process(&dst[length], &dst[length], ir->length());
+        cv.destroy();
+    }
+
+    void offline(float *dst, const float *src, size_t length, const dspu::Sample *ir)
+    {
+        timbremill::ir_spectrum_t *spc = timbremill::create_ir_spectrum(ir, timbremill::fft_convolution_rank(length, ir->length()));
+        if (spc == NULL)
+            return;
+
+        timbremill::fft_convolve(dst, src, length, spc, 0, NULL);
+        timbremill::release_ir_spectrum(spc);
+    }
+
+    PTEST_MAIN
+    {
+        size_t length   = SRC_LENGTH * SAMPLE_RATE;
+        size_t max_ir   = ir_lengths[sizeof(ir_lengths)/sizeof(size_t) - 1] * SAMPLE_RATE;
+
+        uint8_t *data   = NULL;
+        float *src      = alloc_aligned<float>(data, length + length + max_ir, 64);
+        float *dst      = &src[length];
+        for (size_t i=0; i<length; ++i)
+            src[i]          = float(rand()) / RAND_MAX - 0.5f;
+
+        for (size_t i=0; i<sizeof(ir_lengths)/sizeof(size_t); ++i)
+        {
+            dspu::Sample ir;
+            size_t ir_len   = ir_lengths[i] * SAMPLE_RATE;
+            if (!ir.init(1, ir_len, ir_len))
+                break;
+
+            // Exponentially decaying noise
+            float *chan     = ir.channel(0);
+            for (size_t j=0; j<ir_len; ++j)
+                chan[j]         = (float(rand()) / RAND_MAX - 0.5f) * expf(-6.0f * j / ir_len);
+
+            char buf[80];
+            snprintf(buf, sizeof(buf), "realtime %d s", int(ir_lengths[i]));
+            printf("Testing %s IR on %d s signal...\n", buf, int(SRC_LENGTH));
+            PTEST_LOOP(buf,
+                realtime(dst, src, length, &ir);
+            );
+
+            snprintf(buf, sizeof(buf), "offline %d s", int(ir_lengths[i]));
+            printf("Testing %s IR on %d s signal...\n", buf, int(SRC_LENGTH));
+            PTEST_LOOP(buf,
+                offline(dst, src, length, &ir);
+            );
+
+            // The spectrum of the impulse response is computed once and shared between renders
+            timbremill::ir_spectrum_t *spc = timbremill::create_ir_spectrum(&ir, timbremill::fft_convolution_rank(length, ir_len));
+            if (spc == NULL)
+                break;
+
+            snprintf(buf, sizeof(buf), "cached %d s", int(ir_lengths[i]));
+            printf("Testing %s IR on %d s signal...\n", buf, int(SRC_LENGTH));
+            PTEST_LOOP(buf,
+                timbremill::fft_convolve(dst, src, length, spc, 0, NULL);
+            );
+            timbremill::release_ir_spectrum(spc);
+
+            PTEST_SEPARATOR;
+        }
+
+        free_aligned(data);
+    }
+
+PTEST_END
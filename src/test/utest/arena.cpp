@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/helpers.h>
+#include <private/arena.h>
+
+UTEST_BEGIN("timbremill", arena)
+
+    UTEST_MAIN
+    {
+        timbremill::arena_t arena;
+        float *vp[4];
+
+        // Borrow buffers and check alignment
+        float *a    = timbremill::arena_borrow(&arena, 1000);
+        float *b    = timbremill::arena_borrow(&arena, 100000);
+        UTEST_ASSERT((a != NULL) && (b != NULL) && (a != b));
+        UTEST_ASSERT((uintptr_t(a) % ARENA_ALIGN) == 0);
+        UTEST_ASSERT((uintptr_t(b) % ARENA_ALIGN) == 0);
+        UTEST_ASSERT(arena.nAllocations == 2);
+        UTEST_ASSERT(arena.nBorrowed == arena.nReserved);
+        size_t peak = arena.nPeak;
+        UTEST_ASSERT(peak == arena.nBorrowed);
+
+        // Returned blocks should be reused by the best fit
+        timbremill::arena_return(&arena, a);
+        timbremill::arena_return(&arena, b);
+        UTEST_ASSERT(arena.nBorrowed == 0);
+        UTEST_ASSERT(timbremill::arena_borrow(&arena, 500) == a);
+        UTEST_ASSERT(timbremill::arena_borrow(&arena, 90000) == b);
+        UTEST_ASSERT(arena.nAllocations == 2);
+        UTEST_ASSERT(arena.nPeak == peak);
+        timbremill::arena_return(&arena, a);
+        timbremill::arena_return(&arena, b);
+
+        // Planar buffers should be aligned and should not overlap
+        float *p    = timbremill::arena_borrow_planar(&arena, vp, 4, 1001);
+        UTEST_ASSERT(p == a);
+        for (size_t i=0; i<4; ++i)
+        {
+            UTEST_ASSERT((uintptr_t(vp[i]) % ARENA_ALIGN) == 0);
+            if (i > 0)
+                UTEST_ASSERT(vp[i] >= &vp[i-1][1001]);
+        }
+        timbremill::arena_return(&arena, p);
+
+        // Too small free blocks should be dropped when the new block is allocated
+        float *c    = timbremill::arena_borrow(&arena, 1000000);
+        UTEST_ASSERT(c != NULL);
+        UTEST_ASSERT(arena.nAllocations == 3);
+        UTEST_ASSERT(arena.vFree.size() == 1);
+        UTEST_ASSERT(arena.nPeak == arena.nBorrowed);
+        timbremill::arena_return(&arena, c);
+
+        arena.clear();
+        UTEST_ASSERT(arena.nReserved == 0);
+    }
+
+UTEST_END
@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/helpers.h>
+#include <lsp-plug.in/dsp/dsp.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <private/audio.h>
+
+#define SAMPLE_RATE         48000
+#define CHANNELS            2
+#define LENGTH              10000
+#define FFT_PRECISION       10
+#define LONG_LENGTH         (1 << 20)
+#define IR_LENGTH           1000
+
+UTEST_BEGIN("timbremill", audio)
+
+    bool samples_equal(const dspu::Sample *a, const dspu::Sample *b)
+    {
+        if ((a->channels() != b->channels()) || (a->length() != b->length()))
+            return false;
+
+        for (size_t i=0; i<a->channels(); ++i)
+        {
+            const float *ca = a->channel(i);
+            const float *cb = b->channel(i);
+            for (size_t j=0; j<a->length(); ++j)
+                if (!float_equals_adaptive(ca[j], cb[j]))
+                    return false;
+        }
+
+        return true;
+    }
+
+    void test_average(const dspu::Sample *mean, const dspu::Sample *src, ssize_t method, float param)
+    {
+        dspu::Sample p;
+        timbremill::spc_average_t avg;
+
+        avg.nMethod     = method;
+        avg.fPower      = param;
+        avg.fPercentile = param;
+        UTEST_ASSERT(timbremill::spectral_profile(&p, src, FFT_PRECISION, 0, &avg, NULL) == STATUS_OK);
+        UTEST_ASSERT(p.channels() == mean->channels());
+        UTEST_ASSERT(p.length() == mean->length());
+
+        // The steady signal should have the same peak for all averaging methods
+        for (size_t i=0; i<mean->channels(); ++i)
+        {
+            size_t k    = dsp::max_index(mean->channel(i), mean->length());
+            UTEST_ASSERT_MSG(float_equals_relative(p.channel(i)[k], mean->channel(i)[k], 0.2f),
+                "Averaging method %d: %f vs %f", int(method), p.channel(i)[k], mean->channel(i)[k]);
+        }
+    }
+
+    void test_extreme_percentiles(const dspu::Sample *mean, const dspu::Sample *src)
+    {
+        dspu::Sample p[3];
+        timbremill::spc_average_t avg;
+        static const float percentiles[] = { 0.0f, 50.0f, 100.0f };
+
+        // The lowest and the highest frame magnitudes should be found for 0 and 100 percentiles
+        for (size_t i=0; i<3; ++i)
+        {
+            avg.nMethod     = timbremill::AVG_PERCENTILE;
+            avg.fPower      = 1.0f;
+            avg.fPercentile = percentiles[i];
+            UTEST_ASSERT(timbremill::spectral_profile(&p[i], src, FFT_PRECISION, 0, &avg, NULL) == STATUS_OK);
+            UTEST_ASSERT(p[i].channels() == mean->channels());
+            UTEST_ASSERT(p[i].length() == mean->length());
+        }
+
+        for (size_t i=0; i<mean->channels(); ++i)
+        {
+            const float *lo = p[0].channel(i);
+            const float *md = p[1].channel(i);
+            const float *hi = p[2].channel(i);
+            for (size_t j=0; j<mean->length(); ++j)
+                UTEST_ASSERT_MSG((lo[j] <= md[j]) && (md[j] <= hi[j]),
+                    "Percentiles at bin %d: %f, %f, %f", int(j), lo[j], md[j], hi[j]);
+
+            // The steady signal has the maximum magnitude close to the average
+            size_t k    = dsp::max_index(mean->channel(i), mean->length());
+            UTEST_ASSERT_MSG(float_equals_relative(hi[k], mean->channel(i)[k], 0.2f),
+                "Percentile 100: %f vs %f", hi[k], mean->channel(i)[k]);
+        }
+    }
+
+    void test_robust_average()
+    {
+        dspu::Sample s, pm, pq;
+        timbremill::spc_average_t avg;
+
+        // The quiet tone with the loud click
+        UTEST_ASSERT(s.init(1, LENGTH, LENGTH));
+        s.set_sample_rate(SAMPLE_RATE);
+        float *dst = s.channel(0);
+        for (size_t j=0; j<LENGTH; ++j)
+            dst[j]      = 0.001f * sinf((2.0f * M_PI * 440.0f * j) / SAMPLE_RATE);
+        dst[LENGTH/2]  += 1.0f;
+
+        // The click dominates the mean of high frequencies but not the median
+        avg.nMethod     = timbremill::AVG_MEDIAN;
+        avg.fPower      = 1.0f;
+        avg.fPercentile = 50.0f;
+        UTEST_ASSERT(timbremill::spectral_profile(&pm, &s, FFT_PRECISION, 0, NULL, NULL) == STATUS_OK);
+        UTEST_ASSERT(timbremill::spectral_profile(&pq, &s, FFT_PRECISION, 0, &avg, NULL) == STATUS_OK);
+
+        size_t k = pm.length() - 16;
+        UTEST_ASSERT_MSG(pq.channel(0)[k] < pm.channel(0)[k] * 0.1f,
+            "Median %f is not below the mean %f", pq.channel(0)[k], pm.channel(0)[k]);
+    }
+
+    void test_energy_window()
+    {
+        dspu::Sample ir, trimmed;
+        timbremill::irfile_t params;
+        size_t head, count;
+        ssize_t latency;
+
+        // The decaying IR with the peak in the middle, the energy of each next sample is 4 times less
+        UTEST_ASSERT(ir.init(1, IR_LENGTH, IR_LENGTH));
+        ir.set_sample_rate(SAMPLE_RATE);
+        float *dst = ir.channel(0);
+        dsp::fill_zero(dst, IR_LENGTH);
+        for (size_t i=400, k=0; i<IR_LENGTH; ++i, ++k)
+            dst[i]      = (k == 0) ? 1.0f : dst[i-1] * 0.5f;
+
+        // 1% of energy is left outside the window after 3 steps, 0.0001% after 9 steps
+        timbremill::energy_window(&head, &count, &ir, -20.0f);
+        UTEST_ASSERT_MSG((head == 397) && (count == 7), "head=%d, count=%d", int(head), int(count));
+        timbremill::energy_window(&head, &count, &ir, -60.0f);
+        UTEST_ASSERT_MSG((head == 391) && (count == 19), "head=%d, count=%d", int(head), int(count));
+
+        // The automatic trimming cuts the window and computes the latency relative to the middle of the IR
+        params.bAutoTrim    = true;
+        params.fTrimEnergy  = -20.0f;
+        UTEST_ASSERT(timbremill::trim_impulse_response(&trimmed, &latency, &ir, &params) == STATUS_OK);
+        UTEST_ASSERT(trimmed.channels() == 1);
+        UTEST_ASSERT(trimmed.length() == 7);
+        UTEST_ASSERT(latency == IR_LENGTH/2 - 397);
+        for (size_t i=0; i<trimmed.length(); ++i)
+            UTEST_ASSERT(float_equals_absolute(trimmed.channel(0)[i], dst[397 + i]));
+    }
+
+    void magnitude_spectrum(float *dst, const float *ir, size_t length)
+    {
+        size_t bins = 1 << FFT_PRECISION;
+        float buf[1 << FFT_PRECISION], fft[2 << FFT_PRECISION];
+
+        dsp::fill_zero(buf, bins);
+        dsp::copy(buf, ir, lsp_min(length, bins));
+        dsp::pcomplex_r2c(fft, buf, bins);
+        dsp::packed_direct_fft(fft, fft, FFT_PRECISION);
+        dsp::pcomplex_mod(dst, fft, bins);
+    }
+
+    float head_energy(const float *ir, size_t head, size_t length)
+    {
+        double e = 0.0, total = 0.0;
+        for (size_t i=0; i<length; ++i)
+        {
+            double v    = ir[i] * ir[i];
+            total      += v;
+            if (i < head)
+                e          += v;
+        }
+        return e / total;
+    }
+
+    void test_minimum_phase()
+    {
+        dspu::Sample m, c, lin, mp;
+        dspu::Sample *vd[1];
+        const dspu::Sample *vc[1] = { &c };
+        size_t sr = SAMPLE_RATE;
+        size_t bins = 1 << FFT_PRECISION;
+        size_t length = (bins >> 1) + 1;
+        float ml[1 << FFT_PRECISION], mm[1 << FFT_PRECISION];
+
+        // The smooth correction which reaches the unit gain below the transition frequency
+        UTEST_ASSERT(m.init(1, length, length));
+        UTEST_ASSERT(c.init(1, length, length));
+        m.set_sample_rate(SAMPLE_RATE);
+        c.set_sample_rate(SAMPLE_RATE);
+        for (size_t j=0; j<length; ++j)
+        {
+            m.channel(0)[j]     = 1.0f;
+            c.channel(0)[j]     = (j < 256) ? 1.0f + 0.25f * (1.0f + cosf((M_PI * j) / 256)) : 1.0f;
+        }
+
+        vd[0]   = &lin;
+        UTEST_ASSERT(timbremill::timbre_impulse_responses(vd, &m, vc, &sr, 1, false, timbremill::PHASE_LINEAR,
+            FFT_PRECISION, 48.0f, 0.5f, 0.0f, NULL) == STATUS_OK);
+        vd[0]   = &mp;
+        UTEST_ASSERT(timbremill::timbre_impulse_responses(vd, &m, vc, &sr, 1, false, timbremill::PHASE_MINIMUM,
+            FFT_PRECISION, 48.0f, 0.5f, 0.0f, NULL) == STATUS_OK);
+        UTEST_ASSERT(lin.length() == bins);
+        UTEST_ASSERT(mp.length() == bins >> 1);
+
+        // Both impulse responses have the same magnitude spectrum
+        magnitude_spectrum(ml, lin.channel(0), lin.length());
+        magnitude_spectrum(mm, mp.channel(0), mp.length());
+        for (size_t j=0; j<bins; ++j)
+            UTEST_ASSERT_MSG(float_equals_relative(ml[j], mm[j], 1e-2f),
+                "Magnitude of bin %d differs: %f (linear) vs %f (minimum)", int(j), ml[j], mm[j]);
+
+        // The energy of the minimum-phase IR is concentrated at the beginning,
+        // the linear-phase IR is centered
+        float el    = head_energy(lin.channel(0), 64, lin.length());
+        float em    = head_energy(mp.channel(0), 64, mp.length());
+        UTEST_ASSERT_MSG(em > 0.99f, "Energy of the minimum-phase IR head is %f", em);
+        UTEST_ASSERT_MSG(el < 0.01f, "Energy of the linear-phase IR head is %f", el);
+    }
+
+    void test_smoothing()
+    {
+        dspu::Sample m, c, raw, smooth;
+        dspu::Sample *vd[1];
+        const dspu::Sample *vc[1] = { &c };
+        size_t sr = SAMPLE_RATE;
+        size_t length = (1 << (FFT_PRECISION - 1)) + 1;
+        size_t head, raw_count, smooth_count;
+
+        // The child profile has the bin-level ripple
+        UTEST_ASSERT(m.init(1, length, length));
+        UTEST_ASSERT(c.init(1, length, length));
+        m.set_sample_rate(SAMPLE_RATE);
+        c.set_sample_rate(SAMPLE_RATE);
+        for (size_t j=0; j<length; ++j)
+        {
+            m.channel(0)[j]     = 1.0f;
+            c.channel(0)[j]     = 1.0f + 0.5f * sinf(j * 2.1f);
+        }
+
+        // The smoothing removes the ripple, so the energy of the IR is concentrated around the center
+        vd[0]   = &raw;
+        UTEST_ASSERT(timbremill::timbre_impulse_responses(vd, &m, vc, &sr, 1, false, timbremill::PHASE_LINEAR,
+            FFT_PRECISION, 48.0f, 0.5f, 0.0f, NULL) == STATUS_OK);
+        vd[0]   = &smooth;
+        UTEST_ASSERT(timbremill::timbre_impulse_responses(vd, &m, vc, &sr, 1, false, timbremill::PHASE_LINEAR,
+            FFT_PRECISION, 48.0f, 0.5f, 1.0f / 3.0f, NULL) == STATUS_OK);
+
+        timbremill::energy_window(&head, &raw_count, &raw, -40.0f);
+        timbremill::energy_window(&head, &smooth_count, &smooth, -40.0f);
+        UTEST_ASSERT_MSG(smooth_count < raw_count, "Smoothed IR window %d is not shorter than %d",
+            int(smooth_count), int(raw_count));
+    }
+
+    void test_grid(const dspu::Sample *ps, const dspu::Sample *s)
+    {
+        dspu::Sample pg, lin, grd;
+        dspu::Sample *vd[1];
+        const dspu::Sample *vc[1];
+        size_t sr = SAMPLE_RATE;
+
+        // The number of points is limited by the number of bins
+        UTEST_ASSERT(timbremill::profile_points(0, FFT_PRECISION) == ps->length());
+        UTEST_ASSERT(timbremill::profile_points(100000, FFT_PRECISION) == ps->length());
+        UTEST_ASSERT(timbremill::profile_points(64, FFT_PRECISION) == 64);
+        UTEST_ASSERT(timbremill::profile_points(1, FFT_PRECISION) == 16);
+
+        // The grid is linear at low frequencies
+        UTEST_ASSERT(timbremill::spectral_profile(&pg, s, FFT_PRECISION, 64, NULL, NULL) == STATUS_OK);
+        UTEST_ASSERT(pg.channels() == ps->channels());
+        UTEST_ASSERT(pg.length() == 64);
+        for (size_t i=0; i<ps->channels(); ++i)
+        {
+            for (size_t j=0; j<16; ++j)
+                UTEST_ASSERT(float_equals_adaptive(pg.channel(i)[j], ps->channel(i)[j]));
+        }
+
+        // The unit correction on the grid gives the same IR as the unit correction on bins,
+        // the gain range is disabled so the spectral floor does not depend on the grid
+        vd[0]   = &lin;
+        vc[0]   = ps;
+        UTEST_ASSERT(timbremill::timbre_impulse_responses(vd, ps, vc, &sr, 1, false, timbremill::PHASE_LINEAR,
+            FFT_PRECISION, 0.0f, 0.5f, 0.0f, NULL) == STATUS_OK);
+        vd[0]   = &grd;
+        vc[0]   = &pg;
+        UTEST_ASSERT(timbremill::timbre_impulse_responses(vd, &pg, vc, &sr, 1, false, timbremill::PHASE_LINEAR,
+            FFT_PRECISION, 0.0f, 0.5f, 0.0f, NULL) == STATUS_OK);
+        UTEST_ASSERT(grd.channels() == lin.channels());
+        UTEST_ASSERT(grd.length() == lin.length());
+        for (size_t i=0; i<lin.channels(); ++i)
+        {
+            for (size_t j=0; j<lin.length(); ++j)
+                UTEST_ASSERT(fabsf(grd.channel(i)[j] - lin.channel(i)[j]) < 1e-4f);
+        }
+    }
+
+    UTEST_MAIN
+    {
+        float buf[CHANNELS][LENGTH], out[CHANNELS][LENGTH];
+        float *data[CHANNELS], *odata[CHANNELS];
+        dspu::Sample s, sp, dp, ir, ps, pd, cs, cd, ls, lir;
+        size_t srate = 0;
+        float peak = 0.0f;
+
+        // Generate the planar signal
+        for (size_t i=0; i<CHANNELS; ++i)
+        {
+            data[i]     = buf[i];
+            odata[i]    = out[i];
+            for (size_t j=0; j<LENGTH; ++j)
+                buf[i][j]   = sinf((2.0f * M_PI * 440.0f * (i + 1) * j) / SAMPLE_RATE);
+        }
+
+        // Load the data from planar buffers and from the sample
+        UTEST_ASSERT(timbremill::load_audio_file(&s, &srate, SAMPLE_RATE, data, CHANNELS, LENGTH, SAMPLE_RATE) == STATUS_OK);
+        UTEST_ASSERT(srate == SAMPLE_RATE);
+        UTEST_ASSERT(s.channels() == CHANNELS);
+        UTEST_ASSERT(s.length() == LENGTH);
+        UTEST_ASSERT(timbremill::load_audio_file(&sp, &srate, SAMPLE_RATE, &s) == STATUS_OK);
+        UTEST_ASSERT(samples_equal(&s, &sp));
+
+        // Compute spectral profiles using both interfaces
+        UTEST_ASSERT(timbremill::spectral_profile(&ps, &s, FFT_PRECISION, 0, NULL, NULL) == STATUS_OK);
+        UTEST_ASSERT(timbremill::spectral_profile(&pd, data, CHANNELS, LENGTH, SAMPLE_RATE, FFT_PRECISION, 0, NULL, NULL) == STATUS_OK);
+        UTEST_ASSERT(samples_equal(&ps, &pd));
+        UTEST_ASSERT(ps.length() == (1 << (FFT_PRECISION - 1)) + 1);
+
+        // Check averaging methods of frame magnitudes
+        test_average(&ps, &s, timbremill::AVG_MEAN, 0.0f);
+        test_average(&ps, &s, timbremill::AVG_POWER, 2.0f);
+        test_average(&ps, &s, timbremill::AVG_LOG, 0.0f);
+        test_average(&ps, &s, timbremill::AVG_MEDIAN, 0.0f);
+        test_average(&ps, &s, timbremill::AVG_PERCENTILE, 75.0f);
+        test_extreme_percentiles(&ps, &s);
+        test_robust_average();
+        test_energy_window();
+        test_minimum_phase();
+        test_smoothing();
+        test_grid(&ps, &s);
+
+        // Convolve with the unit impulse response using both interfaces
+        UTEST_ASSERT(ir.init(CHANNELS, 16, 16));
+        for (size_t i=0; i<CHANNELS; ++i)
+            ir.channel(i)[0]    = 1.0f;
+        UTEST_ASSERT(timbremill::convolve(&cs, &s, &ir, 0, 0.0f, 1.0f, timbremill::CONV_REALTIME, 1) == STATUS_OK);
+        UTEST_ASSERT(cs.length() == timbremill::convolution_length(LENGTH, 16, 0));
+        UTEST_ASSERT(timbremill::convolve(odata, LENGTH, data, CHANNELS, LENGTH, &ir, 0, 0.0f, 1.0f, timbremill::CONV_REALTIME, 1) == STATUS_OK);
+        UTEST_ASSERT(timbremill::load_audio_file(&cd, NULL, SAMPLE_RATE, odata, CHANNELS, LENGTH, SAMPLE_RATE) == STATUS_OK);
+        cs.set_length(LENGTH);
+        UTEST_ASSERT(samples_equal(&cs, &cd));
+
+        // The offline convolution engine should give the same result
+        UTEST_ASSERT(timbremill::convolve(&cd, &s, &ir, 0, 0.0f, 1.0f, timbremill::CONV_OFFLINE, 1) == STATUS_OK);
+        UTEST_ASSERT(cd.length() == timbremill::convolution_length(LENGTH, 16, 0));
+        cd.set_length(LENGTH);
+        UTEST_ASSERT(samples_equal(&cs, &cd));
+
+        // The multi-threaded rendering should give the same result
+        UTEST_ASSERT(timbremill::convolve(&cd, &s, &ir, 0, 0.0f, 1.0f, timbremill::CONV_OFFLINE, 4) == STATUS_OK);
+        cd.set_length(LENGTH);
+        UTEST_ASSERT(samples_equal(&cs, &cd));
+
+        // Long signals are split into time segments and stitched together
+        UTEST_ASSERT(ls.init(1, LONG_LENGTH, LONG_LENGTH));
+        UTEST_ASSERT(lir.init(1, IR_LENGTH, IR_LENGTH));
+        for (size_t i=0; i<LONG_LENGTH; ++i)
+            ls.channel(0)[i]    = sinf((2.0f * M_PI * 440.0f * i) / SAMPLE_RATE);
+        for (size_t i=0; i<IR_LENGTH; ++i)
+            lir.channel(0)[i]   = expf(-10.0f * i / IR_LENGTH) * cosf(i * 0.1f) * 0.01f;
+        UTEST_ASSERT(timbremill::convolve(&cs, &ls, &lir, 0, 0.0f, 1.0f, timbremill::CONV_OFFLINE, 1) == STATUS_OK);
+        UTEST_ASSERT(timbremill::convolve(&cd, &ls, &lir, 0, 0.0f, 1.0f, timbremill::CONV_OFFLINE, 4) == STATUS_OK);
+        UTEST_ASSERT(samples_equal(&cs, &cd));
+
+        // The shared spectrum of the impulse response can be used for multiple renders
+        timbremill::ir_spectrum_t *spc = timbremill::create_ir_spectrum(&lir, timbremill::fft_convolution_rank(LONG_LENGTH, IR_LENGTH));
+        UTEST_ASSERT(spc != NULL);
+        UTEST_ASSERT(timbremill::acquire_ir_spectrum(spc) == spc);
+        UTEST_ASSERT(timbremill::convolve(&cd, &ls, spc, 0, 0.0f, 1.0f, 1) == STATUS_OK);
+        UTEST_ASSERT(samples_equal(&cs, &cd));
+        timbremill::release_ir_spectrum(spc);
+        UTEST_ASSERT(timbremill::convolve(&cd, &ls, spc, 0, 0.0f, 1.0f, 4) == STATUS_OK);
+        UTEST_ASSERT(samples_equal(&cs, &cd));
+        timbremill::release_ir_spectrum(spc);
+
+        // The fused render should match the separate convolution, latency compensation and length match
+        UTEST_ASSERT(timbremill::convolve(&cs, &ls, &lir, IR_LENGTH/2, 0.5f, 1.0f, timbremill::CONV_OFFLINE, 1) == STATUS_OK);
+        timbremill::compensate_latency(&cs, IR_LENGTH/2);
+        cs.resize(cs.channels(), LONG_LENGTH, LONG_LENGTH);
+        UTEST_ASSERT(timbremill::render_audio(&cd, &peak, &ls, &lir, IR_LENGTH/2, 0.5f, 1.0f, true, true, timbremill::CONV_OFFLINE, 4, NULL) == STATUS_OK);
+        UTEST_ASSERT(samples_equal(&cs, &cd));
+        UTEST_ASSERT(float_equals_adaptive(peak, dsp::abs_max(cs.channel(0), cs.length())));
+
+        // Store the sample back to the planar buffers
+        UTEST_ASSERT(timbremill::save_audio_file(odata, CHANNELS, LENGTH, &s) == STATUS_OK);
+        for (size_t i=0; i<CHANNELS; ++i)
+        {
+            for (size_t j=0; j<LENGTH; ++j)
+                UTEST_ASSERT(float_equals_absolute(out[i][j], buf[i][j]));
+        }
+    }
+
+UTEST_END
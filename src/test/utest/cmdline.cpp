@@ -33,13 +33,18 @@ UTEST_BEGIN("timbremill", cmdline)
         LSPString key;
         timbremill::fgroup_t *g;
 
-        UTEST_ASSERT(cfg->vGroups.size() == 2);
+        UTEST_ASSERT(cfg->vGroups.size() == 3);
 
         // Validate root parameters
         UTEST_ASSERT(cfg->nSampleRate == 88200);
         UTEST_ASSERT(cfg->nFftRank == 8);
+        UTEST_ASSERT(cfg->nGrid == 64);
+        UTEST_ASSERT(cfg->nAverage == timbremill::AVG_PERCENTILE);
+        UTEST_ASSERT(float_equals_absolute(cfg->fAvgPower, 3.0f));
+        UTEST_ASSERT(float_equals_absolute(cfg->fPercentile, 90.0f));
         UTEST_ASSERT(cfg->nProduce == (timbremill::OUT_IR | timbremill::OUT_AUDIO));
         UTEST_ASSERT(float_equals_absolute(cfg->fTransition, 1.5f));
+        UTEST_ASSERT(float_equals_absolute(cfg->fSmoothing, 1.0f / 3.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->fDry, -19.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->fWet, -7.0f));
         UTEST_ASSERT(cfg->sSrcPath.equals_ascii("/home/user/in"));
@@ -50,12 +55,36 @@ UTEST_BEGIN("timbremill", cmdline)
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fTailCut, 6.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fFadeIn, 3.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fFadeOut, 51.0f));
+        UTEST_ASSERT(cfg->sIR.bAutoTrim == true);
+        UTEST_ASSERT(float_equals_absolute(cfg->sIR.fTrimEnergy, -70.0f));
+        UTEST_ASSERT(cfg->sIR.nPhase == timbremill::PHASE_MINIMUM);
         UTEST_ASSERT(cfg->bMastering == true);
         UTEST_ASSERT(cfg->sFile.equals_ascii("%{master_name}-${file_name} - processed.wav"));
         UTEST_ASSERT(float_equals_absolute(cfg->fNormGain, -12.0f));
         UTEST_ASSERT(cfg->nNormalize == timbremill::NORM_ALWAYS);
         UTEST_ASSERT(cfg->bLatencyCompensation == false);
         UTEST_ASSERT(cfg->bMatchLength == true);
+        UTEST_ASSERT(cfg->nConvolver == timbremill::CONV_REALTIME);
+        UTEST_ASSERT(cfg->nThreads == 2);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_AUDIO].nContainer == timbremill::CONT_W64);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_AUDIO].nEncoding == timbremill::ENC_PCM16);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_AUDIO].nDither == timbremill::DITHER_TPDF);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_IR].nContainer == timbremill::CONT_FLAC);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_IR].nEncoding == timbremill::ENC_PCM16);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_RAW].nContainer == timbremill::CONT_FLAC);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_RAW].nEncoding == timbremill::ENC_PCM16);
+        UTEST_ASSERT(cfg->nPREncoding == timbremill::PROF_FLOAT32);
+        UTEST_ASSERT(cfg->bHugePages == true);
+        UTEST_ASSERT(cfg->nNuma == timbremill::NUMA_LOCAL);
+        UTEST_ASSERT(cfg->sJobs.equals_ascii("/home/user/jobs.ndjson"));
+        UTEST_ASSERT(cfg->sPlan.equals_ascii("/home/user/plan.json"));
+        UTEST_ASSERT(cfg->nShard == 2);
+        UTEST_ASSERT(cfg->nShards == 4);
+        UTEST_ASSERT(cfg->sManifest.equals_ascii("/home/user/manifest.ndjson"));
+        UTEST_ASSERT(cfg->nProgress == timbremill::PROGRESS_JSON);
+        UTEST_ASSERT(float_equals_absolute(cfg->fProgressInterval, 2.5f));
+        UTEST_ASSERT(cfg->nStatusFd == 3);
+        UTEST_ASSERT(cfg->sTrace.equals_ascii("/home/user/trace.json"));
 
         // Validate "group1"
         UTEST_ASSERT(key.set_ascii("group1"));
@@ -89,12 +118,17 @@ UTEST_BEGIN("timbremill", cmdline)
             "-f",   "%{master_name}-${file_name} - processed.wav",
             "-p",   "ir, audio",
             "-fr",  "8",
+            "-gp",  "64",
+            "-av",  "percentile",
+            "-pct", "90",
             "-ir",  "%{master_name}-${file_name} - IR.wav",
             "-iw",  "%{master_name}-${file_name} - Raw IR.wav",
             "-ihc", "46",
             "-itc", "6",
             "-ifi", "3",
             "-ifo", "51",
+            "-iat", "-70",
+            "-ip",  "minimum",
             "-sr",  "88200",
             "-s",   "/home/user/in",
             "-dg",  "-19",
@@ -103,6 +137,24 @@ UTEST_BEGIN("timbremill", cmdline)
             "-ng",  "-12",
             "-n",   "ALWAYS",
             "-ml",  "true",
+            "-cv",  "realtime",
+            "-t",   "2",
+            "-e",   "pcm16",
+            "-dt",  "tpdf",
+            "-ct",  "w64",
+            "-ic",  "flac",
+            "-ie",  "pcm16",
+            "-pe",  "float",
+            "-nu",  "local",
+            "-j",   "/home/user/jobs.ndjson",
+            "-pl",  "/home/user/plan.json",
+            "-sh",  "2/4",
+            "-mn",  "/home/user/manifest.ndjson",
+            "-pg",  "json",
+            "-pgi", "2.5",
+            "-sfd", "3",
+            "-sm",  "1/3 oct",
+            "-tr",  "/home/user/trace.json",
             "-tz",  "1.5",
             "-c",
             NULL
@@ -131,6 +183,10 @@ UTEST_BEGIN("timbremill", cmdline)
             "-mf",  "master-file.wav",
             "-cf",  "child-file1.wav",
             "-cf",  "child-file2.wav",
+            "-mp",  "master-file.tmpf",
+            "-cp",  "child-file1.tmpf",
+            "-cp",  "child-file2.tmpf",
+            "-prc", "out-profile.tmpf",
             "-f",   "out-file.wav",
             "-lc",  "true",
             NULL
@@ -157,8 +213,13 @@ UTEST_BEGIN("timbremill", cmdline)
         // Validate root parameters
         UTEST_ASSERT(cfg->nSampleRate == 48000);
         UTEST_ASSERT(cfg->nFftRank == 12);
-        UTEST_ASSERT(cfg->nProduce == timbremill::OUT_AUDIO);
+        UTEST_ASSERT(cfg->nGrid == 0);
+        UTEST_ASSERT(cfg->nAverage == timbremill::AVG_MEAN);
+        UTEST_ASSERT(float_equals_absolute(cfg->fAvgPower, 2.0f));
+        UTEST_ASSERT(float_equals_absolute(cfg->fPercentile, 50.0f));
+        UTEST_ASSERT(cfg->nProduce == (timbremill::OUT_AUDIO | timbremill::OUT_PRC));
         UTEST_ASSERT(float_equals_absolute(cfg->fTransition, 0.5f));
+        UTEST_ASSERT(float_equals_absolute(cfg->fSmoothing, 0.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->fDry, -1000.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->fWet, 0.0f));
         UTEST_ASSERT(cfg->sSrcPath.equals_ascii(""));
@@ -169,12 +230,35 @@ UTEST_BEGIN("timbremill", cmdline)
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fTailCut, 0.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fFadeIn, 0.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fFadeOut, 0.0f));
+        UTEST_ASSERT(cfg->sIR.bAutoTrim == false);
+        UTEST_ASSERT(float_equals_absolute(cfg->sIR.fTrimEnergy, -90.0f));
+        UTEST_ASSERT(cfg->sIR.nPhase == timbremill::PHASE_LINEAR);
         UTEST_ASSERT(cfg->bMastering == false);
         UTEST_ASSERT(cfg->sFile.equals_ascii("out-file.wav"));
         UTEST_ASSERT(float_equals_absolute(cfg->fNormGain, 0.0f));
         UTEST_ASSERT(cfg->nNormalize == timbremill::NORM_NONE);
         UTEST_ASSERT(cfg->bLatencyCompensation == true);
         UTEST_ASSERT(cfg->bMatchLength == false);
+        UTEST_ASSERT(cfg->nConvolver == timbremill::CONV_OFFLINE);
+        UTEST_ASSERT(cfg->nThreads == 0);
+        UTEST_ASSERT(cfg->sPRChild.equals_ascii("out-profile.tmpf"));
+        UTEST_ASSERT(cfg->nPREncoding == timbremill::PROF_FLOAT32);
+        UTEST_ASSERT(cfg->bHugePages == false);
+        UTEST_ASSERT(cfg->nNuma == timbremill::NUMA_NONE);
+        UTEST_ASSERT(cfg->sJobs.is_empty());
+        UTEST_ASSERT(cfg->sPlan.is_empty());
+        UTEST_ASSERT(cfg->nShard == 0);
+        UTEST_ASSERT(cfg->nShards == 0);
+        UTEST_ASSERT(cfg->sManifest.is_empty());
+        UTEST_ASSERT(cfg->nProgress == timbremill::PROGRESS_NONE);
+        UTEST_ASSERT(cfg->nStatusFd == 2);
+        UTEST_ASSERT(cfg->sTrace.is_empty());
+        for (size_t i=0; i<timbremill::FOUT_TOTAL; ++i)
+        {
+            UTEST_ASSERT(cfg->vFormat[i].nContainer == timbremill::CONT_WAV);
+            UTEST_ASSERT(cfg->vFormat[i].nEncoding == timbremill::ENC_FLOAT32);
+            UTEST_ASSERT(cfg->vFormat[i].nDither == timbremill::DITHER_NONE);
+        }
 
         // Validate "test-group"
         UTEST_ASSERT(key.set_ascii("test-group"));
@@ -185,6 +269,10 @@ UTEST_BEGIN("timbremill", cmdline)
             UTEST_ASSERT(g->vFiles.size() == 2);
             UTEST_ASSERT(g->vFiles.get(0)->equals_ascii("child-file1.wav"));
             UTEST_ASSERT(g->vFiles.get(1)->equals_ascii("child-file2.wav"));
+            UTEST_ASSERT(g->sMasterProfile.equals_ascii("master-file.tmpf"));
+            UTEST_ASSERT(g->vProfiles.size() == 2);
+            UTEST_ASSERT(g->vProfiles.get(0)->equals_ascii("child-file1.tmpf"));
+            UTEST_ASSERT(g->vProfiles.get(1)->equals_ascii("child-file2.tmpf"));
         }
     }
 
@@ -21,6 +21,8 @@
 
 #include <lsp-plug.in/test-fw/utest.h>
 #include <lsp-plug.in/test-fw/helpers.h>
+#include <lsp-plug.in/io/InSequence.h>
+#include <lsp-plug.in/io/InStringSequence.h>
 #include <private/config/config.h>
 
 UTEST_BEGIN("timbremill", config)
@@ -30,14 +32,19 @@ UTEST_BEGIN("timbremill", config)
         LSPString key;
         timbremill::fgroup_t *g;
 
-        UTEST_ASSERT(cfg->vGroups.size() == 2);
+        UTEST_ASSERT(cfg->vGroups.size() == 3);
 
         // Validate root parameters
         UTEST_ASSERT(cfg->nSampleRate == 44100);
         UTEST_ASSERT(cfg->nFftRank == 16);
+        UTEST_ASSERT(cfg->nGrid == 1024);
+        UTEST_ASSERT(cfg->nAverage == timbremill::AVG_POWER);
+        UTEST_ASSERT(float_equals_absolute(cfg->fAvgPower, 3.0f));
+        UTEST_ASSERT(float_equals_absolute(cfg->fPercentile, 50.0f));
         UTEST_ASSERT(cfg->nProduce == (timbremill::OUT_RAW | timbremill::OUT_AUDIO));
         UTEST_ASSERT(float_equals_absolute(cfg->fGainRange, 72.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->fTransition, 1.5f));
+        UTEST_ASSERT(float_equals_absolute(cfg->fSmoothing, 1.0f / 6.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->fDry, -18.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->fWet, -6.0f));
         UTEST_ASSERT(cfg->sSrcPath.equals_ascii("/home/test"));
@@ -48,12 +55,35 @@ UTEST_BEGIN("timbremill", config)
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fTailCut, 5.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fFadeIn, 2.0f));
         UTEST_ASSERT(float_equals_absolute(cfg->sIR.fFadeOut, 50.0f));
+        UTEST_ASSERT(cfg->sIR.bAutoTrim == true);
+        UTEST_ASSERT(float_equals_absolute(cfg->sIR.fTrimEnergy, -80.0f));
+        UTEST_ASSERT(cfg->sIR.nPhase == timbremill::PHASE_MINIMUM);
         UTEST_ASSERT(cfg->bMastering == true);
         UTEST_ASSERT(cfg->sFile.equals_ascii("%{master_name}/test-${file_name} - processed.wav"));
         UTEST_ASSERT(float_equals_absolute(cfg->fNormGain, -10.0f));
         UTEST_ASSERT(cfg->nNormalize == timbremill::NORM_ABOVE);
         UTEST_ASSERT(cfg->bLatencyCompensation == false);
         UTEST_ASSERT(cfg->bMatchLength == true);
+        UTEST_ASSERT(cfg->nConvolver == timbremill::CONV_REALTIME);
+        UTEST_ASSERT(cfg->nThreads == 4);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_AUDIO].nContainer == timbremill::CONT_RF64);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_AUDIO].nEncoding == timbremill::ENC_PCM24);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_AUDIO].nDither == timbremill::DITHER_SHAPED);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_IR].nContainer == timbremill::CONT_W64);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_IR].nEncoding == timbremill::ENC_FLOAT32);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_IR].nDither == timbremill::DITHER_NONE);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_RAW].nContainer == timbremill::CONT_WAV);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_RAW].nEncoding == timbremill::ENC_PCM24);
+        UTEST_ASSERT(cfg->vFormat[timbremill::FOUT_RAW].nDither == timbremill::DITHER_NONE);
+        UTEST_ASSERT(cfg->sPRMaster.equals_ascii("%{master_name}/test-${file_name} - master.tmpf"));
+        UTEST_ASSERT(cfg->sPRChild.equals_ascii("%{master_name}/test-${file_name} - child.tmpf"));
+        UTEST_ASSERT(cfg->nPREncoding == timbremill::PROF_FLOAT16);
+        UTEST_ASSERT(cfg->bHugePages == true);
+        UTEST_ASSERT(cfg->nNuma == timbremill::NUMA_INTERLEAVE);
+        UTEST_ASSERT(cfg->sDiscover.bEnabled == true);
+        UTEST_ASSERT(cfg->sDiscover.sPath.equals_ascii("instruments"));
+        UTEST_ASSERT(cfg->sDiscover.sMaster.equals_ascii("*unmuted*.wav"));
+        UTEST_ASSERT(cfg->sDiscover.sFiles.equals_ascii("**/*.wav"));
 
         // Validate "group1"
         UTEST_ASSERT(key.set_ascii("group1"));
@@ -64,6 +94,11 @@ UTEST_BEGIN("timbremill", config)
             UTEST_ASSERT(g->vFiles.get(0)->equals_ascii("out-file1.wav"));
             UTEST_ASSERT(g->vFiles.get(1)->equals_ascii("out-file2.wav"));
             UTEST_ASSERT(g->vFiles.get(2)->equals_ascii("out-file3.wav"));
+            UTEST_ASSERT(g->sMasterProfile.equals_ascii("file1.tmpf"));
+            UTEST_ASSERT(g->vProfiles.size() == 3);
+            UTEST_ASSERT(g->vProfiles.get(0)->equals_ascii("out-file1.tmpf"));
+            UTEST_ASSERT(g->vProfiles.get(1)->is_empty());
+            UTEST_ASSERT(g->vProfiles.get(2)->equals_ascii("out-file3.tmpf"));
         }
 
         // Validate "group1"
@@ -74,6 +109,17 @@ UTEST_BEGIN("timbremill", config)
             UTEST_ASSERT(g->vFiles.size() == 2);
             UTEST_ASSERT(g->vFiles.get(0)->equals_ascii("a-out.wav"));
             UTEST_ASSERT(g->vFiles.get(1)->equals_ascii("b-out.wav"));
+            UTEST_ASSERT(g->sMasterProfile.is_empty());
+            UTEST_ASSERT(g->vProfiles.is_empty());
+        }
+
+        // Validate "group3"
+        UTEST_ASSERT(key.set_ascii("group3"));
+        UTEST_ASSERT((g = cfg->vGroups.get(&key)) != NULL);
+        {
+            UTEST_ASSERT(g->sMaster.equals_ascii("c.wav"));
+            UTEST_ASSERT(g->vFiles.is_empty());
+            UTEST_ASSERT(g->sGlob.equals_ascii("group3/**/*.wav"));
         }
     }
 
@@ -92,9 +138,146 @@ UTEST_BEGIN("timbremill", config)
     }
 
 
+    void test_load_jobs(const char *filename)
+    {
+        io::Path path;
+        io::InSequence is;
+        size_t line = 0;
+
+        UTEST_ASSERT(path.fmt("%s/config/%s", resources(), filename) > 0);
+        printf("Testing jobs file %s...\n", path.as_native());
+        UTEST_ASSERT(is.open(&path) == STATUS_OK);
+
+        // The first job
+        {
+            timbremill::fgroup_t g;
+            UTEST_ASSERT(timbremill::read_job(&g, &is, &line) == STATUS_OK);
+            UTEST_ASSERT(line == 1);
+            UTEST_ASSERT(g.sName.equals_ascii("trumpet"));
+            UTEST_ASSERT(g.sMaster.equals_ascii("trumpet/trp unmuted.wav"));
+            UTEST_ASSERT(g.vFiles.size() == 2);
+            UTEST_ASSERT(g.vFiles.get(0)->equals_ascii("trumpet/trp plunger.wav"));
+            UTEST_ASSERT(g.vFiles.get(1)->equals_ascii("trumpet/trp harmon.wav"));
+        }
+
+        // The second job goes after the empty line
+        {
+            timbremill::fgroup_t g;
+            UTEST_ASSERT(timbremill::read_job(&g, &is, &line) == STATUS_OK);
+            UTEST_ASSERT(line == 3);
+            UTEST_ASSERT(g.sName.equals_ascii("horn"));
+            UTEST_ASSERT(g.sMaster.equals_ascii("horn/unmuted.wav"));
+            UTEST_ASSERT(g.vFiles.is_empty());
+            UTEST_ASSERT(g.sGlob.equals_ascii("horn/**/*.wav"));
+        }
+
+        // No more jobs
+        {
+            timbremill::fgroup_t g;
+            UTEST_ASSERT(timbremill::read_job(&g, &is, &line) == STATUS_EOF);
+        }
+
+        UTEST_ASSERT(is.close() == STATUS_OK);
+    }
+
+    void check_smoothing(const char *text, status_t code, float expected)
+    {
+        LSPString s;
+        float value = -1.0f;
+
+        UTEST_ASSERT(s.set_utf8(text));
+        status_t res = timbremill::parse_smoothing(&value, &s);
+        UTEST_ASSERT_MSG(res == code, "Smoothing '%s': status %d, expected %d", text, int(res), int(code));
+        if (code == STATUS_OK)
+            UTEST_ASSERT_MSG(float_equals_absolute(value, expected), "Smoothing '%s': %f, expected %f", text, value, expected);
+    }
+
+    void check_json_smoothing(const char *text, bool valid, float expected)
+    {
+        timbremill::config_t cfg;
+        io::InStringSequence is;
+
+        UTEST_ASSERT(is.wrap(text) == STATUS_OK);
+        status_t res = timbremill::parse_config(&cfg, &is);
+        UTEST_ASSERT_MSG((res == STATUS_OK) == valid, "Configuration '%s': status %d", text, int(res));
+        if (valid)
+            UTEST_ASSERT_MSG(float_equals_absolute(cfg.fSmoothing, expected), "Configuration '%s': %f, expected %f",
+                text, cfg.fSmoothing, expected);
+        UTEST_ASSERT(is.close() == STATUS_OK);
+    }
+
+    void test_smoothing()
+    {
+        printf("Testing smoothing values...\n");
+
+        check_smoothing("1/3 oct", STATUS_OK, 1.0f / 3.0f);
+        check_smoothing(" 1 / 6 ", STATUS_OK, 1.0f / 6.0f);
+        check_smoothing("1/24 OCT", STATUS_OK, 1.0f / 24.0f);
+        check_smoothing("0.5", STATUS_OK, 0.5f);
+        check_smoothing("2 oct", STATUS_OK, 2.0f);
+        check_smoothing("none", STATUS_OK, 0.0f);
+        check_smoothing("off", STATUS_OK, 0.0f);
+        check_smoothing("", STATUS_OK, 0.0f);
+
+        check_smoothing("inf", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("nan", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("1/inf", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("-1/3", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("1/-3", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("1/0", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("3 oct", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("1/3/4", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("1 oct/3", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("1/3 octave", STATUS_INVALID_VALUE, 0.0f);
+        check_smoothing("third", STATUS_INVALID_VALUE, 0.0f);
+
+        check_json_smoothing("{ \"smoothing\": \"1/3 oct\" }", true, 1.0f / 3.0f);
+        check_json_smoothing("{ \"smoothing\": 0.25 }", true, 0.25f);
+        check_json_smoothing("{ \"smoothing\": 2 }", true, 2.0f);
+        check_json_smoothing("{ \"smoothing\": -0.5 }", false, 0.0f);
+        check_json_smoothing("{ \"smoothing\": 3 }", false, 0.0f);
+        check_json_smoothing("{ \"smoothing\": 1e30 }", false, 0.0f);
+    }
+
+    void check_json_auto_trim(const char *text, bool valid, bool enabled, float energy)
+    {
+        timbremill::config_t cfg;
+        io::InStringSequence is;
+
+        UTEST_ASSERT(is.wrap(text) == STATUS_OK);
+        status_t res = timbremill::parse_config(&cfg, &is);
+        UTEST_ASSERT_MSG((res == STATUS_OK) == valid, "Configuration '%s': status %d", text, int(res));
+        if (valid)
+        {
+            UTEST_ASSERT_MSG(cfg.sIR.bAutoTrim == enabled, "Configuration '%s': auto trim %s, expected %s",
+                text, (cfg.sIR.bAutoTrim) ? "on" : "off", (enabled) ? "on" : "off");
+            UTEST_ASSERT_MSG(float_equals_absolute(cfg.sIR.fTrimEnergy, energy), "Configuration '%s': %f, expected %f",
+                text, cfg.sIR.fTrimEnergy, energy);
+        }
+        UTEST_ASSERT(is.close() == STATUS_OK);
+    }
+
+    void test_auto_trim()
+    {
+        printf("Testing auto trim values...\n");
+
+        check_json_auto_trim("{ \"ir\": { } }", true, false, -90.0f);
+        check_json_auto_trim("{ \"ir\": { \"auto_trim\": true } }", true, true, -90.0f);
+        check_json_auto_trim("{ \"ir\": { \"auto_trim\": false } }", true, false, -90.0f);
+        check_json_auto_trim("{ \"ir\": { \"auto_trim\": null } }", true, false, -90.0f);
+        check_json_auto_trim("{ \"ir\": { \"auto_trim\": { } } }", true, true, -90.0f);
+        check_json_auto_trim("{ \"ir\": { \"auto_trim\": { \"energy\": -60 } } }", true, true, -60.0f);
+        check_json_auto_trim("{ \"ir\": { \"auto_trim\": { \"enabled\": false, \"energy\": -60 } } }", true, false, -60.0f);
+        check_json_auto_trim("{ \"ir\": { \"auto_trim\": { \"enabled\": true } } }", true, true, -90.0f);
+        check_json_auto_trim("{ \"ir\": { \"auto_trim\": \"yes\" } }", false, false, 0.0f);
+    }
+
     UTEST_MAIN
     {
         test_load_config("test.json");
+        test_load_jobs("jobs.ndjson");
+        test_smoothing();
+        test_auto_trim();
     }
 
 UTEST_END
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <private/discover.h>
+
+UTEST_BEGIN("timbremill", discover)
+
+    void check_match(const char *pattern, const char *path, bool match)
+    {
+        LSPString p, s;
+        UTEST_ASSERT(p.set_utf8(pattern));
+        UTEST_ASSERT(s.set_utf8(path));
+        UTEST_ASSERT_MSG(timbremill::glob_match(&p, &s) == match,
+            "Pattern '%s' %s match the path '%s'", pattern, (match) ? "should" : "should not", path);
+    }
+
+    void create_file(const LSPString *root, const char *name)
+    {
+        io::Path path, dir;
+        UTEST_ASSERT(path.fmt("%s/%s", root->get_native(), name) > 0);
+        UTEST_ASSERT(path.get_parent(&dir) == STATUS_OK);
+        UTEST_ASSERT(dir.mkdir(true) == STATUS_OK);
+
+        FILE *fd = fopen(path.as_native(), "w");
+        UTEST_ASSERT(fd != NULL);
+        fclose(fd);
+    }
+
+    void test_match()
+    {
+        printf("Testing glob patterns...\n");
+
+        check_match("*.wav", "a.wav", true);
+        check_match("*.wav", "dir/a.wav", false);
+        check_match("a?c.wav", "abc.wav", true);
+        check_match("a?c.wav", "a/c.wav", false);
+        check_match("**/*.wav", "a.wav", true);
+        check_match("**/*.wav", "x/y/a.wav", true);
+        check_match("trumpet/**/*.wav", "trumpet/a.wav", true);
+        check_match("trumpet/**/*.wav", "trumpet/mute/a.wav", true);
+        check_match("trumpet/**/*.wav", "horn/a.wav", false);
+        check_match("x/*/y.wav", "x/a/y.wav", true);
+        check_match("x/*/y.wav", "x/a/b/y.wav", false);
+        check_match("*unmuted*.wav", "trumpet unmuted 1.wav", true);
+    }
+
+    void test_files(const LSPString *root)
+    {
+        lltl::parray<LSPString> files;
+        LSPString pattern;
+
+        printf("Testing search of files in %s...\n", root->get_native());
+
+        UTEST_ASSERT(pattern.set_ascii("trumpet/**/*.wav"));
+        UTEST_ASSERT(timbremill::glob_files(&files, root, NULL, &pattern, 4) == STATUS_OK);
+        UTEST_ASSERT(files.size() == 3);
+        UTEST_ASSERT(files.uget(0)->equals_ascii("trumpet/a/1.wav"));
+        UTEST_ASSERT(files.uget(1)->equals_ascii("trumpet/b/c/2.wav"));
+        UTEST_ASSERT(files.uget(2)->equals_ascii("trumpet/unmuted.wav"));
+
+        for (size_t i=0, n=files.size(); i<n; ++i)
+            delete files.uget(i);
+        files.flush();
+    }
+
+    void test_groups(const LSPString *root)
+    {
+        timbremill::config_t cfg;
+        timbremill::fgroup_t *fg;
+        LSPString key;
+
+        printf("Testing discovery of groups in %s...\n", root->get_native());
+
+        UTEST_ASSERT(cfg.sSrcPath.set(root));
+        UTEST_ASSERT(cfg.sDiscover.sMaster.set_ascii("*unmuted*.wav"));
+        cfg.sDiscover.bEnabled  = true;
+
+        UTEST_ASSERT(timbremill::discover_groups(&cfg) == STATUS_OK);
+        UTEST_ASSERT(cfg.vGroups.size() == 2);
+
+        UTEST_ASSERT(key.set_ascii("trumpet"));
+        UTEST_ASSERT((fg = cfg.vGroups.get(&key)) != NULL);
+        UTEST_ASSERT(fg->sMaster.is_empty());
+        UTEST_ASSERT(timbremill::resolve_group_files(&cfg, fg, 4) == STATUS_OK);
+        UTEST_ASSERT(fg->sMaster.equals_ascii("trumpet/unmuted.wav"));
+        UTEST_ASSERT(fg->vFiles.size() == 2);
+        UTEST_ASSERT(fg->vFiles.uget(0)->equals_ascii("trumpet/a/1.wav"));
+        UTEST_ASSERT(fg->vFiles.uget(1)->equals_ascii("trumpet/b/c/2.wav"));
+
+        timbremill::release_group_files(fg);
+        UTEST_ASSERT(fg->vFiles.is_empty());
+    }
+
+    UTEST_MAIN
+    {
+        LSPString root;
+        UTEST_ASSERT(root.fmt_utf8("%s/utest-%s", tempdir(), full_name()) > 0);
+
+        create_file(&root, "trumpet/unmuted.wav");
+        create_file(&root, "trumpet/a/1.wav");
+        create_file(&root, "trumpet/b/c/2.wav");
+        create_file(&root, "trumpet/b/c/notes.txt");
+        create_file(&root, "horn/unmuted.wav");
+
+        test_match();
+        test_files(&root);
+        test_groups(&root);
+    }
+
+UTEST_END
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/expr/Variables.h>
+#include <lsp-plug.in/io/Path.h>
+#include <private/naming.h>
+
+UTEST_BEGIN("timbremill", naming)
+
+    UTEST_MAIN
+    {
+        timbremill::naming_t naming;
+        expr::Variables vars;
+        LSPString fmt, name;
+        io::Path path, expected;
+
+        UTEST_ASSERT(naming.sBase.set_utf8(tempdir()));
+        UTEST_ASSERT(fmt.set_ascii("utest-naming/${master_name}/${file_name}.wav"));
+        UTEST_ASSERT(name.set_ascii("master"));
+        UTEST_ASSERT(vars.set_string("master_name", &name) == STATUS_OK);
+
+        // Compile the template once
+        expr::Expression *x1 = NULL, *x2 = NULL;
+        UTEST_ASSERT(timbremill::compile_file_name(&naming, &fmt, &x1) == STATUS_OK);
+        UTEST_ASSERT(timbremill::compile_file_name(&naming, &fmt, &x2) == STATUS_OK);
+        UTEST_ASSERT((x1 != NULL) && (x1 == x2));
+        UTEST_ASSERT(naming.vTemplates.size() == 1);
+
+        // Generate the names of two files in the same directory
+        for (size_t i=0; i<2; ++i)
+        {
+            UTEST_ASSERT(name.fmt_ascii("file%d", int(i)) > 0);
+            UTEST_ASSERT(vars.set_string("file_name", &name) == STATUS_OK);
+            UTEST_ASSERT(timbremill::output_file_path(&path, &naming, &fmt, &vars) == STATUS_OK);
+            UTEST_ASSERT(expected.fmt("%s/utest-naming/master/file%d.wav", tempdir(), int(i)) > 0);
+            printf("Generated file name: %s\n", path.as_native());
+            UTEST_ASSERT(path.equals(&expected));
+        }
+
+        // The directory should be created once
+        UTEST_ASSERT(naming.vDirs.size() == 1);
+        UTEST_ASSERT(path.get_parent(&expected) == STATUS_OK);
+        UTEST_ASSERT(expected.is_dir());
+    }
+
+UTEST_END
@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/helpers.h>
+#include <lsp-plug.in/fmt/json/Parser.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/lltl/pphash.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <private/audio.h>
+#include <private/fftconv.h>
+#include <private/plan.h>
+#include <private/tool.h>
+#include <private/writer.h>
+#include <stdlib.h>
+
+#ifdef PLATFORM_UNIX_COMPATIBLE
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif /* PLATFORM_UNIX_COMPATIBLE */
+
+#define SAMPLE_RATE         48000
+#define FFT_RANK            10
+#define THREADS             2
+#define MASTER_LENGTH       48000
+#define CHILD_LENGTH        24000
+
+UTEST_BEGIN("timbremill", plan)
+
+    typedef lltl::pphash<LSPString, LSPString> values_t;
+
+    void create_file(const LSPString *root, const char *name, size_t channels, size_t length)
+    {
+        io::Path path, dir;
+        dspu::Sample s;
+        timbremill::fformat_t fmt;
+
+        UTEST_ASSERT(path.fmt("%s/%s", root->get_native(), name) > 0);
+        UTEST_ASSERT(path.get_parent(&dir) == STATUS_OK);
+        UTEST_ASSERT(dir.mkdir(true) == STATUS_OK);
+
+        UTEST_ASSERT(s.init(channels, length, length));
+        s.set_sample_rate(SAMPLE_RATE);
+        for (size_t i=0; i<channels; ++i)
+        {
+            float *dst = s.channel(i);
+            for (size_t j=0; j<length; ++j)
+                dst[j]      = 0.5f * sinf(j * 0.01f * (i + 1));
+        }
+
+        fmt.nContainer  = timbremill::CONT_WAV;
+        fmt.nEncoding   = timbremill::ENC_PCM16;
+        fmt.nDither     = timbremill::DITHER_NONE;
+        UTEST_ASSERT(timbremill::write_audio_file(&path, &s, &fmt, 1.0f) == STATUS_OK);
+    }
+
+    void init_config(timbremill::config_t *cfg, const LSPString *root, const char *plan)
+    {
+        timbremill::fgroup_t *fg;
+        LSPString *s;
+
+        UTEST_ASSERT(cfg->sSrcPath.fmt_utf8("%s/src", root->get_utf8()) > 0);
+        UTEST_ASSERT(cfg->sDstPath.fmt_utf8("%s/dst", root->get_utf8()) > 0);
+        UTEST_ASSERT(cfg->sFile.set_ascii("${group}/${file}"));
+        UTEST_ASSERT(cfg->sPlan.set_utf8(plan));
+        cfg->nSampleRate            = SAMPLE_RATE;
+        cfg->nFftRank               = FFT_RANK;
+        cfg->nThreads               = THREADS;
+        cfg->nProduce               = timbremill::OUT_AUDIO;
+
+        // The 'horn' group is discovered, its mono child does not match the stereo master
+        cfg->sDiscover.bEnabled     = true;
+        UTEST_ASSERT(cfg->sDiscover.sPath.set_ascii("groups"));
+        UTEST_ASSERT(cfg->sDiscover.sMaster.set_ascii("master.wav"));
+        UTEST_ASSERT(cfg->sDiscover.sFiles.set_ascii("*.wav"));
+
+        // The 'trumpet' group lists the same child twice and the missing child
+        UTEST_ASSERT((fg = new timbremill::fgroup_t()) != NULL);
+        UTEST_ASSERT(fg->sName.set_ascii("trumpet"));
+        UTEST_ASSERT(fg->sMaster.set_ascii("groups/horn/master.wav"));
+        UTEST_ASSERT(cfg->vGroups.create(&fg->sName, fg));
+
+        const char *files[] = { "groups/horn/a.wav", "groups/horn/a.wav", "missing.wav" };
+        for (size_t i=0; i<sizeof(files)/sizeof(const char *); ++i)
+        {
+            UTEST_ASSERT((s = new LSPString()) != NULL);
+            UTEST_ASSERT(s->set_ascii(files[i]));
+            UTEST_ASSERT(fg->vFiles.add(s));
+        }
+    }
+
+    void put_value(values_t *values, const LSPString *key, LSPString *value)
+    {
+        UTEST_ASSERT_MSG(!values->contains(key), "Duplicate JSON property '%s'", key->get_native());
+        UTEST_ASSERT(values->create(key, value));
+    }
+
+    void read_value(values_t *values, json::Parser *p, json::event_t *ev, const LSPString *key)
+    {
+        LSPString *value;
+        LSPString child;
+
+        switch (ev->type)
+        {
+            case json::JE_OBJECT_START:
+                while (true)
+                {
+                    UTEST_ASSERT(p->read_next(ev) == STATUS_OK);
+                    if (ev->type == json::JE_OBJECT_END)
+                        break;
+                    UTEST_ASSERT(ev->type == json::JE_PROPERTY);
+                    UTEST_ASSERT(child.set(key));
+                    if (!child.is_empty())
+                        UTEST_ASSERT(child.append('.'));
+                    UTEST_ASSERT(child.append(&ev->sValue));
+                    UTEST_ASSERT(p->read_next(ev) == STATUS_OK);
+                    read_value(values, p, ev, &child);
+                }
+                break;
+
+            case json::JE_ARRAY_START:
+                for (size_t i=0; ; ++i)
+                {
+                    UTEST_ASSERT(p->read_next(ev) == STATUS_OK);
+                    if (ev->type == json::JE_ARRAY_END)
+                    {
+                        // Store the number of elements as the 'size' property of the array
+                        UTEST_ASSERT(child.fmt_utf8("%s.size", key->get_utf8()) > 0);
+                        UTEST_ASSERT((value = new LSPString()) != NULL);
+                        UTEST_ASSERT(value->fmt_ascii("%d", int(i)) > 0);
+                        put_value(values, &child, value);
+                        break;
+                    }
+                    UTEST_ASSERT(child.fmt_utf8("%s.%d", key->get_utf8(), int(i)) > 0);
+                    read_value(values, p, ev, &child);
+                }
+                break;
+
+            case json::JE_STRING:
+                UTEST_ASSERT((value = ev->sValue.clone()) != NULL);
+                put_value(values, key, value);
+                break;
+
+            case json::JE_INTEGER:
+                UTEST_ASSERT((value = new LSPString()) != NULL);
+                UTEST_ASSERT(value->fmt_ascii("%lld", (long long)ev->iValue) > 0);
+                put_value(values, key, value);
+                break;
+
+            case json::JE_DOUBLE:
+                UTEST_ASSERT((value = new LSPString()) != NULL);
+                UTEST_ASSERT(value->fmt_ascii("%.17g", ev->fValue) > 0);
+                put_value(values, key, value);
+                break;
+
+            default:
+                UTEST_FAIL_MSG("Unexpected JSON event type %d for property '%s'", int(ev->type), key->get_native());
+                break;
+        }
+    }
+
+    void read_plan(values_t *values, const io::Path *path)
+    {
+        json::Parser p;
+        json::event_t ev;
+        LSPString root;
+
+        printf("Reading plan %s...\n", path->as_native());
+
+        // The legacy mode accepts only the strict JSON
+        UTEST_ASSERT(p.open(path, json::JSON_LEGACY) == STATUS_OK);
+        UTEST_ASSERT(p.read_next(&ev) == STATUS_OK);
+        UTEST_ASSERT(ev.type == json::JE_OBJECT_START);
+        read_value(values, &p, &ev, &root);
+        UTEST_ASSERT(p.read_next(&ev) == STATUS_EOF);
+        UTEST_ASSERT(p.close() == STATUS_OK);
+    }
+
+    void drop_values(values_t *values)
+    {
+        lltl::parray<LSPString> list;
+        UTEST_ASSERT(values->values(&list));
+        values->flush();
+        for (size_t i=0, n=list.size(); i<n; ++i)
+            delete list.uget(i);
+    }
+
+    void check_string(values_t *values, const char *key, const char *expected)
+    {
+        LSPString k, e;
+        UTEST_ASSERT(k.set_utf8(key));
+        UTEST_ASSERT(e.set_utf8(expected));
+        LSPString *v = values->get(&k);
+        UTEST_ASSERT_MSG(v != NULL, "Missing JSON property '%s'", key);
+        UTEST_ASSERT_MSG(v->equals(&e), "Property '%s' is '%s', expected '%s'", key, v->get_utf8(), expected);
+    }
+
+    void check_suffix(values_t *values, const char *key, const char *suffix)
+    {
+        LSPString k;
+        UTEST_ASSERT(k.set_utf8(key));
+        LSPString *v = values->get(&k);
+        UTEST_ASSERT_MSG(v != NULL, "Missing JSON property '%s'", key);
+        UTEST_ASSERT_MSG(v->ends_with_ascii(suffix), "Property '%s' is '%s', expected suffix '%s'", key, v->get_utf8(), suffix);
+    }
+
+    void get_number(double *dst, values_t *values, const char *key)
+    {
+        LSPString k;
+        UTEST_ASSERT(k.set_utf8(key));
+        LSPString *v = values->get(&k);
+        UTEST_ASSERT_MSG(v != NULL, "Missing JSON property '%s'", key);
+        *dst        = strtod(v->get_utf8(), NULL);
+    }
+
+    void check_number(values_t *values, const char *key, double expected)
+    {
+        double v    = -1.0;
+        get_number(&v, values, key);
+
+        // The numbers are written rounded to the integer value
+        UTEST_ASSERT_MSG(fabs(v - expected) <= 1.0 + fabs(expected) * 1e-9,
+            "Property '%s' is %.0f, expected %.0f", key, v, expected);
+    }
+
+    void check_task_cost(values_t *values, const char *task, size_t channels, size_t length, double *flops, double *memory)
+    {
+        char key[64];
+        size_t fft_size     = 1 << FFT_RANK;
+        double fft          = 5.0 * fft_size * FFT_RANK;
+
+        // The audio of the master file is rendered with linear-phase impulse response of the full length
+        size_t ir_length    = fft_size;
+        ssize_t latency     = fft_size >> 1;
+        size_t conv_rank    = timbremill::fft_convolution_rank(MASTER_LENGTH, ir_length);
+
+        double analysis     = double(channels) * timbremill::spectral_profile_frames(length, FFT_RANK) * (fft + 8.0 * fft_size);
+        double ir           = double(channels) * (fft + 16.0 * fft_size);
+        double render       = double(channels) * (timbremill::fft_convolution_cost(MASTER_LENGTH, ir_length, conv_rank) + 4.0 * MASTER_LENGTH);
+
+        double resident     = double(IR_BATCH) * channels * sizeof(float) * (fft_size + (fft_size >> 1) + 1) +
+                              2.0 * MASTER_LENGTH * sizeof(float);
+        double transient    = double(channels) * (length + length) * sizeof(float);
+        double output       = double(channels) * timbremill::convolution_length(MASTER_LENGTH, ir_length, latency) * sizeof(float) +
+                              double(THREADS) * (2 << conv_rank) * sizeof(float);
+
+        *flops              = analysis + ir + render;
+        *memory             = resident + lsp_max(transient, output);
+
+        snprintf(key, sizeof(key), "%s.flops.analysis", task);
+        check_number(values, key, analysis);
+        snprintf(key, sizeof(key), "%s.flops.ir", task);
+        check_number(values, key, ir);
+        snprintf(key, sizeof(key), "%s.flops.render", task);
+        check_number(values, key, render);
+        snprintf(key, sizeof(key), "%s.flops.total", task);
+        check_number(values, key, *flops);
+        snprintf(key, sizeof(key), "%s.memory", task);
+        check_number(values, key, *memory);
+    }
+
+    void check_plan(values_t *values)
+    {
+        double flops, memory, master, total_flops = 0.0, total_memory = 0.0;
+        char key[64];
+
+        check_number(values, "version", 1);
+        check_number(values, "srate", SAMPLE_RATE);
+        check_number(values, "fft_rank", FFT_RANK);
+        check_number(values, "threads", THREADS);
+        check_number(values, "groups.size", 2);
+
+        // Both groups share the same master file
+        master              = 2.0 * timbremill::spectral_profile_frames(MASTER_LENGTH, FFT_RANK) *
+                              (5.0 * (1 << FFT_RANK) * FFT_RANK + 8.0 * (1 << FFT_RANK));
+        for (size_t i=0; i<2; ++i)
+        {
+            snprintf(key, sizeof(key), "groups.%d.master.file", int(i));
+            check_string(values, key, "groups/horn/master.wav");
+            snprintf(key, sizeof(key), "groups.%d.master.channels", int(i));
+            check_number(values, key, 2);
+            snprintf(key, sizeof(key), "groups.%d.master.srate", int(i));
+            check_number(values, key, SAMPLE_RATE);
+            snprintf(key, sizeof(key), "groups.%d.master.frames", int(i));
+            check_number(values, key, MASTER_LENGTH);
+            snprintf(key, sizeof(key), "groups.%d.master.flops", int(i));
+            check_number(values, key, master);
+            snprintf(key, sizeof(key), "groups.%d.master.issues.size", int(i));
+            check_number(values, key, 0);
+            total_flops        += master;
+        }
+
+        // The discovered group: the mono child does not match the master
+        check_string(values, "groups.0.name", "horn");
+        check_number(values, "groups.0.tasks.size", 2);
+        check_string(values, "groups.0.tasks.0.file", "groups/horn/a.wav");
+        check_number(values, "groups.0.tasks.0.channels", 2);
+        check_number(values, "groups.0.tasks.0.frames", CHILD_LENGTH);
+        check_number(values, "groups.0.tasks.0.outputs.size", 1);
+        check_suffix(values, "groups.0.tasks.0.outputs.0", "horn/a.wav");
+        check_number(values, "groups.0.tasks.0.issues.size", 0);
+        check_task_cost(values, "groups.0.tasks.0", 2, CHILD_LENGTH, &flops, &memory);
+        total_flops        += flops;
+        total_memory        = lsp_max(total_memory, memory);
+
+        check_string(values, "groups.0.tasks.1.file", "groups/horn/b.wav");
+        check_number(values, "groups.0.tasks.1.channels", 1);
+        check_number(values, "groups.0.tasks.1.frames", CHILD_LENGTH);
+        check_suffix(values, "groups.0.tasks.1.outputs.0", "horn/b.wav");
+        check_number(values, "groups.0.tasks.1.issues.size", 1);
+        check_task_cost(values, "groups.0.tasks.1", 1, CHILD_LENGTH, &flops, &memory);
+        total_flops        += flops;
+        total_memory        = lsp_max(total_memory, memory);
+
+        // The configured group: the duplicate output and the missing child
+        check_string(values, "groups.1.name", "trumpet");
+        check_number(values, "groups.1.tasks.size", 3);
+        check_suffix(values, "groups.1.tasks.0.outputs.0", "trumpet/a.wav");
+        check_number(values, "groups.1.tasks.0.issues.size", 0);
+        check_task_cost(values, "groups.1.tasks.0", 2, CHILD_LENGTH, &flops, &memory);
+        total_flops        += flops;
+        total_memory        = lsp_max(total_memory, memory);
+
+        check_suffix(values, "groups.1.tasks.1.outputs.0", "trumpet/a.wav");
+        check_number(values, "groups.1.tasks.1.issues.size", 1);
+        check_task_cost(values, "groups.1.tasks.1", 2, CHILD_LENGTH, &flops, &memory);
+        total_flops        += flops;
+        total_memory        = lsp_max(total_memory, memory);
+
+        check_string(values, "groups.1.tasks.2.file", "missing.wav");
+        check_number(values, "groups.1.tasks.2.channels", 0);
+        check_number(values, "groups.1.tasks.2.frames", 0);
+        check_suffix(values, "groups.1.tasks.2.outputs.0", "trumpet/missing.wav");
+        check_number(values, "groups.1.tasks.2.issues.size", 1);
+        get_number(&flops, values, "groups.1.tasks.2.flops.total");
+        get_number(&memory, values, "groups.1.tasks.2.memory");
+        total_flops        += flops;
+        total_memory        = lsp_max(total_memory, memory);
+
+        // The summary of the batch
+        check_number(values, "total.groups", 2);
+        check_number(values, "total.tasks", 5);
+        check_number(values, "total.issues", 3);
+        check_number(values, "total.flops", total_flops);
+        check_number(values, "total.memory", total_memory);
+    }
+
+    void test_plan_file(const LSPString *root)
+    {
+        timbremill::config_t cfg;
+        values_t values;
+        io::Path path;
+
+        printf("Testing plan written to the file...\n");
+
+        UTEST_ASSERT(path.fmt("%s/plan.json", root->get_native()) > 0);
+        init_config(&cfg, root, path.as_utf8());
+        UTEST_ASSERT(timbremill::plan_file_groups(&cfg) == STATUS_BAD_STATE);
+
+        read_plan(&values, &path);
+        check_plan(&values);
+        drop_values(&values);
+    }
+
+    void test_plan_stdout(const LSPString *root)
+    {
+    #ifdef PLATFORM_UNIX_COMPATIBLE
+        timbremill::config_t cfg;
+        values_t values;
+        io::Path path;
+
+        printf("Testing plan written to the standard output...\n");
+
+        UTEST_ASSERT(path.fmt("%s/stdout.json", root->get_native()) > 0);
+        init_config(&cfg, root, "-");
+
+        // Redirect the standard output to the file, all messages should go to the standard error
+        fflush(stdout);
+        int saved   = dup(STDOUT_FILENO);
+        int fd      = open(path.as_native(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        UTEST_ASSERT(saved >= 0);
+        UTEST_ASSERT(fd >= 0);
+        UTEST_ASSERT(dup2(fd, STDOUT_FILENO) >= 0);
+        close(fd);
+
+        status_t res = timbremill::plan_file_groups(&cfg);
+
+        fflush(stdout);
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+        UTEST_ASSERT(res == STATUS_BAD_STATE);
+
+        read_plan(&values, &path);
+        check_plan(&values);
+        drop_values(&values);
+    #endif /* PLATFORM_UNIX_COMPATIBLE */
+    }
+
+    UTEST_MAIN
+    {
+        LSPString root;
+        UTEST_ASSERT(root.fmt_utf8("%s/utest-%s", tempdir(), full_name()) > 0);
+
+        create_file(&root, "src/groups/horn/master.wav", 2, MASTER_LENGTH);
+        create_file(&root, "src/groups/horn/a.wav", 2, CHILD_LENGTH);
+        create_file(&root, "src/groups/horn/b.wav", 1, CHILD_LENGTH);
+
+        test_plan_file(&root);
+        test_plan_stdout(&root);
+    }
+
+UTEST_END
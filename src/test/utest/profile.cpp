@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/helpers.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <private/audio.h>
+#include <private/profile.h>
+
+#define SAMPLE_RATE         48000
+#define CHANNELS            2
+#define LENGTH              10000
+#define FFT_PRECISION       10
+
+UTEST_BEGIN("timbremill", profile)
+
+    void test_profile(const dspu::Sample *ps, ssize_t encoding, float tolerance)
+    {
+        dspu::Sample pd;
+        timbremill::profile_info_t si, di;
+        io::Path path;
+
+        si.nRank        = FFT_PRECISION;
+        si.nSampleRate  = SAMPLE_RATE;
+        si.nSourceRate  = 44100;
+        si.nWindow      = PROFILE_WINDOW_BN;
+        si.nFrames      = timbremill::spectral_profile_frames(LENGTH, FFT_PRECISION);
+        si.nAverage     = timbremill::AVG_PERCENTILE;
+        si.fAvgParam    = 90.0f;
+
+        UTEST_ASSERT(path.fmt("%s/utest-%s-%d.tmpf", tempdir(), full_name(), int(encoding)) > 0);
+        printf("Writing profile file %s...\n", path.as_native());
+        UTEST_ASSERT(timbremill::write_profile(&path, ps, &si, encoding) == STATUS_OK);
+        UTEST_ASSERT(timbremill::read_profile(&pd, &di, &path) == STATUS_OK);
+
+        // Validate the header
+        UTEST_ASSERT(di.nRank == si.nRank);
+        UTEST_ASSERT(di.nSampleRate == si.nSampleRate);
+        UTEST_ASSERT(di.nSourceRate == si.nSourceRate);
+        UTEST_ASSERT(di.nWindow == si.nWindow);
+        UTEST_ASSERT(di.nFrames == si.nFrames);
+        UTEST_ASSERT(di.nAverage == si.nAverage);
+        UTEST_ASSERT(float_equals_absolute(di.fAvgParam, si.fAvgParam));
+
+        // Validate the full spectrum restored from the half spectrum
+        UTEST_ASSERT(pd.channels() == ps->channels());
+        UTEST_ASSERT(pd.length() == ps->length());
+        UTEST_ASSERT(pd.sample_rate() == SAMPLE_RATE);
+        for (size_t i=0; i<ps->channels(); ++i)
+        {
+            const float *a  = ps->channel(i);
+            const float *b  = pd.channel(i);
+            for (size_t j=0; j<ps->length(); ++j)
+                UTEST_ASSERT(float_equals_relative(a[j], b[j], tolerance));
+        }
+    }
+
+    UTEST_MAIN
+    {
+        dspu::Sample s, ps, pg;
+
+        // Generate the signal and compute it's profile
+        UTEST_ASSERT(s.init(CHANNELS, LENGTH, LENGTH));
+        s.set_sample_rate(SAMPLE_RATE);
+        for (size_t i=0; i<CHANNELS; ++i)
+        {
+            float *dst = s.channel(i);
+            for (size_t j=0; j<LENGTH; ++j)
+                dst[j]      = sinf((2.0f * M_PI * 440.0f * (i + 1) * j) / SAMPLE_RATE);
+        }
+        UTEST_ASSERT(timbremill::spectral_profile(&ps, &s, FFT_PRECISION, 0, NULL, NULL) == STATUS_OK);
+
+        // Store and load the profile with different encodings
+        test_profile(&ps, timbremill::PROF_FLOAT32, 1e-6f);
+        test_profile(&ps, timbremill::PROF_FLOAT16, 1e-3f);
+
+        // The profile on the logarithmic grid is stored with less points
+        UTEST_ASSERT(timbremill::spectral_profile(&pg, &s, FFT_PRECISION, 64, NULL, NULL) == STATUS_OK);
+        UTEST_ASSERT(pg.length() == 64);
+        test_profile(&pg, timbremill::PROF_FLOAT32, 1e-6f);
+    }
+
+UTEST_END
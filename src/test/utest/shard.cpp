@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/helpers.h>
+#include <private/shard.h>
+
+#define SHARDS          3
+
+UTEST_BEGIN("timbremill", shard)
+
+    void add_group(lltl::darray<timbremill::work_unit_t> *units, timbremill::fgroup_t *g,
+        const char *name, size_t files, double master, double cost)
+    {
+        UTEST_ASSERT(g->sName.set_ascii(name));
+        for (size_t i=0, n=lsp_max(files, size_t(1)); i<n; ++i)
+        {
+            timbremill::work_unit_t *u = units->add();
+            UTEST_ASSERT(u != NULL);
+            u->pGroup       = g;
+            u->nFirst       = i;
+            u->nCount       = (files > 0) ? 1 : 0;
+            u->fMaster      = master;
+            u->fCost        = (files > 0) ? cost : 0.0;
+            u->nShard       = 0;
+        }
+    }
+
+    void check_group(lltl::darray<timbremill::work_unit_t> *units, timbremill::fgroup_t *g, size_t files, size_t parts)
+    {
+        size_t next = 0, count = 0;
+        for (size_t i=0, n=units->size(); i<n; ++i)
+        {
+            timbremill::work_unit_t *u = units->uget(i);
+            if (u->pGroup != g)
+                continue;
+            UTEST_ASSERT_MSG(u->nFirst == next, "Group '%s' has a gap at file %d", g->sName.get_native(), int(next));
+            next       += u->nCount;
+            ++count;
+        }
+
+        UTEST_ASSERT_MSG(next == files, "Group '%s' covers %d files of %d", g->sName.get_native(), int(next), int(files));
+        UTEST_ASSERT_MSG(count == parts, "Group '%s' has %d parts instead of %d", g->sName.get_native(), int(count), int(parts));
+    }
+
+    UTEST_MAIN
+    {
+        lltl::darray<timbremill::work_unit_t> src, dst, again;
+        timbremill::fgroup_t big, mid, small, tiny;
+
+        add_group(&src, &big, "big", 8, 5.0, 10.0);
+        add_group(&src, &mid, "mid", 3, 5.0, 5.0);
+        add_group(&src, &small, "small", 0, 2.0, 0.0);
+        add_group(&src, &tiny, "tiny", 1, 1.0, 1.0);
+
+        printf("Partitioning %d work units between %d shards...\n", int(src.size()), SHARDS);
+        UTEST_ASSERT(timbremill::partition_work_units(&dst, &src, SHARDS) == STATUS_OK);
+
+        // Only the group which exceeds the share of the shard is split
+        check_group(&dst, &big, 8, 3);
+        check_group(&dst, &mid, 3, 1);
+        check_group(&dst, &small, 0, 1);
+        check_group(&dst, &tiny, 1, 1);
+
+        // The load of each shard does not exceed the share by more than one unit
+        double load[SHARDS], share = 109.0 / SHARDS, max_cost = 0.0;
+        for (size_t i=0; i<SHARDS; ++i)
+            load[i]     = 0.0;
+        for (size_t i=0, n=dst.size(); i<n; ++i)
+        {
+            timbremill::work_unit_t *u = dst.uget(i);
+            UTEST_ASSERT(u->nShard < SHARDS);
+            load[u->nShard]    += u->fMaster + u->fCost;
+            max_cost            = lsp_max(max_cost, u->fMaster + u->fCost);
+        }
+        for (size_t i=0; i<SHARDS; ++i)
+        {
+            printf("  shard %d: load %.1f\n", int(i + 1), load[i]);
+            UTEST_ASSERT(load[i] > 0.0);
+            UTEST_ASSERT(load[i] <= share + max_cost);
+        }
+
+        // The partitioning is deterministic
+        UTEST_ASSERT(timbremill::partition_work_units(&again, &src, SHARDS) == STATUS_OK);
+        UTEST_ASSERT(again.size() == dst.size());
+        for (size_t i=0, n=dst.size(); i<n; ++i)
+        {
+            timbremill::work_unit_t *a = dst.uget(i);
+            timbremill::work_unit_t *b = again.uget(i);
+            UTEST_ASSERT(a->pGroup == b->pGroup);
+            UTEST_ASSERT(a->nFirst == b->nFirst);
+            UTEST_ASSERT(a->nCount == b->nCount);
+            UTEST_ASSERT(a->nShard == b->nShard);
+        }
+    }
+
+UTEST_END
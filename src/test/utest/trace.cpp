@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/fmt/json/Parser.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/ipc/Thread.h>
+#include <lsp-plug.in/lltl/darray.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/trace.h>
+
+#define NAME_LENGTH         32
+#define STACK_SIZE          8
+
+UTEST_BEGIN("timbremill", trace)
+
+#ifdef TIMBREMILL_TRACING
+    typedef struct event_t
+    {
+        char        sName[NAME_LENGTH];
+        char        nPhase;
+        ssize_t     nThread;
+    } event_t;
+
+    static status_t traced_thread(void *arg)
+    {
+        TRACE_SCOPE(static_cast<const char *>(arg));
+        return STATUS_OK;
+    }
+
+    void run_thread(const char *name)
+    {
+        ipc::Thread t(traced_thread, const_cast<char *>(name));
+        UTEST_ASSERT(t.start() == STATUS_OK);
+        UTEST_ASSERT(t.join() == STATUS_OK);
+    }
+
+    void read_event(event_t *ev, json::Parser *p)
+    {
+        json::event_t je;
+        LSPString prop;
+        bool name = false, phase = false, ts = false, pid = false, tid = false;
+
+        while (true)
+        {
+            UTEST_ASSERT(p->read_next(&je) == STATUS_OK);
+            if (je.type == json::JE_OBJECT_END)
+                break;
+            UTEST_ASSERT(je.type == json::JE_PROPERTY);
+            prop.swap(&je.sValue);
+            UTEST_ASSERT(p->read_next(&je) == STATUS_OK);
+
+            if (prop.equals_ascii("name"))
+            {
+                UTEST_ASSERT(je.type == json::JE_STRING);
+                UTEST_ASSERT(je.sValue.length() < NAME_LENGTH);
+                strcpy(ev->sName, je.sValue.get_utf8());
+                name    = true;
+            }
+            else if (prop.equals_ascii("ph"))
+            {
+                UTEST_ASSERT(je.type == json::JE_STRING);
+                UTEST_ASSERT(je.sValue.length() == 1);
+                ev->nPhase  = je.sValue.char_at(0);
+                phase   = true;
+            }
+            else if (prop.equals_ascii("ts"))
+            {
+                UTEST_ASSERT((je.type == json::JE_DOUBLE) || (je.type == json::JE_INTEGER));
+                ts      = true;
+            }
+            else if (prop.equals_ascii("pid"))
+            {
+                UTEST_ASSERT(je.type == json::JE_INTEGER);
+                pid     = true;
+            }
+            else if (prop.equals_ascii("tid"))
+            {
+                UTEST_ASSERT(je.type == json::JE_INTEGER);
+                ev->nThread = je.iValue;
+                tid     = true;
+            }
+            else if (prop.equals_ascii("args"))
+            {
+                UTEST_ASSERT(je.type == json::JE_OBJECT_START);
+                UTEST_ASSERT(p->skip_current() == STATUS_OK);
+            }
+            else
+                UTEST_FAIL_MSG("Unexpected property '%s' of the trace event", prop.get_native());
+        }
+
+        UTEST_ASSERT(name && phase && pid && tid);
+        UTEST_ASSERT_MSG((ts) || (ev->nPhase == 'M'), "Event '%s' does not have timestamp", ev->sName);
+    }
+
+    void read_trace(lltl::darray<event_t> *events, const io::Path *path)
+    {
+        json::Parser p;
+        json::event_t je;
+        event_t *ev;
+        bool found = false;
+
+        printf("Reading trace %s...\n", path->as_native());
+
+        // The legacy mode accepts only the strict JSON
+        UTEST_ASSERT(p.open(path, json::JSON_LEGACY) == STATUS_OK);
+        UTEST_ASSERT(p.read_next(&je) == STATUS_OK);
+        UTEST_ASSERT(je.type == json::JE_OBJECT_START);
+
+        while (true)
+        {
+            UTEST_ASSERT(p.read_next(&je) == STATUS_OK);
+            if (je.type == json::JE_OBJECT_END)
+                break;
+            UTEST_ASSERT(je.type == json::JE_PROPERTY);
+
+            if (!je.sValue.equals_ascii("traceEvents"))
+            {
+                UTEST_ASSERT(p.read_next(&je) == STATUS_OK);
+                UTEST_ASSERT(p.skip_current() == STATUS_OK);
+                continue;
+            }
+
+            UTEST_ASSERT(p.read_next(&je) == STATUS_OK);
+            UTEST_ASSERT(je.type == json::JE_ARRAY_START);
+            while (true)
+            {
+                UTEST_ASSERT(p.read_next(&je) == STATUS_OK);
+                if (je.type == json::JE_ARRAY_END)
+                    break;
+                UTEST_ASSERT(je.type == json::JE_OBJECT_START);
+                UTEST_ASSERT((ev = events->add()) != NULL);
+                read_event(ev, &p);
+            }
+            found   = true;
+        }
+
+        UTEST_ASSERT(found);
+        UTEST_ASSERT(p.read_next(&je) == STATUS_EOF);
+        UTEST_ASSERT(p.close() == STATUS_OK);
+    }
+
+    ssize_t find_thread(lltl::darray<event_t> *events, const char *name)
+    {
+        for (size_t i=0, n=events->size(); i<n; ++i)
+        {
+            const event_t *ev = events->uget(i);
+            if (!strcmp(ev->sName, name))
+                return ev->nThread;
+        }
+        return -1;
+    }
+
+    size_t count_events(lltl::darray<event_t> *events, const char *name, char phase)
+    {
+        size_t count = 0;
+        for (size_t i=0, n=events->size(); i<n; ++i)
+        {
+            const event_t *ev = events->uget(i);
+            if ((!strcmp(ev->sName, name)) && (ev->nPhase == phase))
+                ++count;
+        }
+        return count;
+    }
+
+    void check_events(lltl::darray<event_t> *events)
+    {
+        const char *stack[STACK_SIZE];
+        size_t depth        = 0;
+        ssize_t thread      = -1;
+
+        // Each track starts with the name of the thread, the end events match the begin events
+        for (size_t i=0, n=events->size(); i<n; ++i)
+        {
+            const event_t *ev   = events->uget(i);
+            if (ev->nPhase == 'M')
+            {
+                UTEST_ASSERT(!strcmp(ev->sName, "thread_name"));
+                thread              = ev->nThread;
+                depth               = 0;
+                continue;
+            }
+
+            UTEST_ASSERT_MSG(ev->nThread == thread, "Event %d of thread %d follows the name of thread %d",
+                int(i), int(ev->nThread), int(thread));
+            if (ev->nPhase == 'B')
+            {
+                UTEST_ASSERT(depth < STACK_SIZE);
+                stack[depth++]      = ev->sName;
+            }
+            else
+            {
+                UTEST_ASSERT_MSG(ev->nPhase == 'E', "Unexpected phase '%c' of event %d", ev->nPhase, int(i));
+                UTEST_ASSERT_MSG(depth > 0, "Unmatched end event '%s' at %d", ev->sName, int(i));
+                --depth;
+                UTEST_ASSERT_MSG(!strcmp(stack[depth], ev->sName), "End event '%s' at %d does not match the begin event '%s'",
+                    ev->sName, int(i), stack[depth]);
+            }
+        }
+    }
+#endif /* TIMBREMILL_TRACING */
+
+    UTEST_MAIN
+    {
+    #ifdef TIMBREMILL_TRACING
+        lltl::darray<event_t> events;
+        io::Path path;
+
+        UTEST_ASSERT(path.fmt("%s/utest-%s.json", tempdir(), full_name()) > 0);
+        UTEST_ASSERT(timbremill::start_trace(path.as_string()) == STATUS_OK);
+
+        // Overflow the ring buffer: the begin event of the outer scope and of the oldest inner scope
+        // are overwritten, the end events of them should be dropped
+        {
+            TRACE_SCOPE("outer");
+            for (size_t i=0; i<TRACE_RING_SIZE; ++i)
+            {
+                TRACE_SCOPE_ARG("inner", i);
+            }
+        }
+
+        // The second thread reuses the ring buffer of the first thread
+        run_thread("first");
+        run_thread("second");
+
+        UTEST_ASSERT(timbremill::flush_trace() == STATUS_OK);
+
+        read_trace(&events, &path);
+        check_events(&events);
+
+        UTEST_ASSERT(count_events(&events, "outer", 'B') == 0);
+        UTEST_ASSERT(count_events(&events, "outer", 'E') == 0);
+        UTEST_ASSERT(count_events(&events, "inner", 'B') == (TRACE_RING_SIZE - 2) / 2);
+        UTEST_ASSERT(count_events(&events, "inner", 'E') == (TRACE_RING_SIZE - 2) / 2);
+        UTEST_ASSERT(count_events(&events, "first", 'B') == 1);
+        UTEST_ASSERT(count_events(&events, "second", 'E') == 1);
+
+        // Each thread has its own identifier even if the ring buffer is shared
+        ssize_t main_tid    = find_thread(&events, "inner");
+        ssize_t first_tid   = find_thread(&events, "first");
+        ssize_t second_tid  = find_thread(&events, "second");
+        UTEST_ASSERT(main_tid != first_tid);
+        UTEST_ASSERT(main_tid != second_tid);
+        UTEST_ASSERT(first_tid != second_tid);
+    #else
+        printf("Tracing is not available in this build, rebuild with TRACE=1\n");
+    #endif /* TIMBREMILL_TRACING */
+    }
+
+UTEST_END
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2026 Linux Studio Plugins Project <https://lsp-plug.in/>
+ *           (C) 2026 Vladimir Sadovnikov <sadko4u@gmail.com>
+ *
+ * This file is part of timbre-mill
+ * Created on: 18 окт. 2026 г.
+ *
+ * timbre-mill is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * timbre-mill is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with timbre-mill. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <lsp-plug.in/test-fw/utest.h>
+#include <lsp-plug.in/test-fw/helpers.h>
+#include <lsp-plug.in/io/Path.h>
+#include <lsp-plug.in/stdlib/math.h>
+#include <lsp-plug.in/stdlib/stdio.h>
+#include <lsp-plug.in/stdlib/string.h>
+#include <private/writer.h>
+
+#define SAMPLE_RATE         48000
+#define LENGTH              1000
+#define GAIN                0.5f
+
+UTEST_BEGIN("timbremill", writer)
+
+    static uint32_t get_u16(const uint8_t *p)
+    {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8);
+    }
+
+    static uint32_t get_u32(const uint8_t *p)
+    {
+        return get_u16(p) | (get_u16(&p[2]) << 16);
+    }
+
+    static uint64_t get_u64(const uint8_t *p)
+    {
+        return uint64_t(get_u32(p)) | (uint64_t(get_u32(&p[4])) << 32);
+    }
+
+    static size_t encoding_bytes(ssize_t encoding)
+    {
+        return (encoding == timbremill::ENC_PCM16) ? 2 :
+               (encoding == timbremill::ENC_PCM24) ? 3 : 4;
+    }
+
+    void read_file(uint8_t **data, size_t *size, const io::Path *path)
+    {
+        FILE *fd = fopen(path->as_native(), "rb");
+        UTEST_ASSERT(fd != NULL);
+        UTEST_ASSERT(fseek(fd, 0, SEEK_END) == 0);
+        long length = ftell(fd);
+        UTEST_ASSERT(length >= 0);
+        UTEST_ASSERT(fseek(fd, 0, SEEK_SET) == 0);
+
+        uint8_t *buf = static_cast<uint8_t *>(malloc(length + 1));
+        UTEST_ASSERT(buf != NULL);
+        UTEST_ASSERT(fread(buf, 1, length, fd) == size_t(length));
+        fclose(fd);
+
+        *data = buf;
+        *size = length;
+    }
+
+    void check_fmt(const uint8_t *fmt, size_t fmt_size, size_t channels, ssize_t encoding)
+    {
+        size_t bytes    = encoding_bytes(encoding);
+        uint32_t tag    = (encoding == timbremill::ENC_FLOAT32) ? 3 : 1;
+        bool extensible = (channels > 2) || ((tag == 1) && (bytes > 2));
+
+        UTEST_ASSERT(fmt_size == ((extensible) ? 40 : 16));
+        UTEST_ASSERT(get_u16(&fmt[0]) == ((extensible) ? 0xfffe : tag));
+        UTEST_ASSERT(get_u16(&fmt[2]) == channels);
+        UTEST_ASSERT(get_u32(&fmt[4]) == SAMPLE_RATE);
+        UTEST_ASSERT(get_u32(&fmt[8]) == SAMPLE_RATE * channels * bytes);
+        UTEST_ASSERT(get_u16(&fmt[12]) == channels * bytes);
+        UTEST_ASSERT(get_u16(&fmt[14]) == bytes * 8);
+        if (!extensible)
+            return;
+
+        UTEST_ASSERT(get_u16(&fmt[16]) == 22);
+        UTEST_ASSERT(get_u16(&fmt[18]) == bytes * 8);
+        UTEST_ASSERT(get_u32(&fmt[20]) == ((channels == 1) ? 0x4 : (channels == 2) ? 0x3 : 0x7));
+        UTEST_ASSERT(get_u16(&fmt[24]) == tag);
+        UTEST_ASSERT(get_u32(&fmt[26]) == 0x00000000);     // The rest of KSDATAFORMAT_SUBTYPE GUID
+        UTEST_ASSERT(get_u32(&fmt[30]) == 0x00800010);
+        UTEST_ASSERT(get_u32(&fmt[34]) == 0x3800aa00);
+        UTEST_ASSERT(get_u16(&fmt[38]) == 0x719b);
+    }
+
+    void check_header(size_t *data_offset, const uint8_t *data, size_t size, ssize_t container,
+        size_t channels, size_t length, ssize_t encoding)
+    {
+        size_t data_size    = length * channels * encoding_bytes(encoding);
+        size_t padded       = data_size + (data_size & 1);      // The RIFF chunks are word-aligned
+        size_t fmt_size, offset;
+
+        switch (container)
+        {
+            case timbremill::CONT_RAW:
+                UTEST_ASSERT(size == data_size);
+                *data_offset = 0;
+                return;
+
+            case timbremill::CONT_RF64:
+                UTEST_ASSERT(memcmp(&data[0], "RF64", 4) == 0);
+                UTEST_ASSERT(get_u32(&data[4]) == 0xffffffffu);
+                UTEST_ASSERT(memcmp(&data[8], "WAVE", 4) == 0);
+                UTEST_ASSERT(memcmp(&data[12], "ds64", 4) == 0);
+                UTEST_ASSERT(get_u32(&data[16]) == 28);
+                UTEST_ASSERT(get_u64(&data[20]) == size - 8);
+                UTEST_ASSERT(get_u64(&data[28]) == data_size);
+                UTEST_ASSERT(get_u64(&data[36]) == length);
+                UTEST_ASSERT(memcmp(&data[48], "fmt ", 4) == 0);
+                fmt_size    = get_u32(&data[52]);
+                check_fmt(&data[56], fmt_size, channels, encoding);
+                offset      = 56 + fmt_size;
+                UTEST_ASSERT(memcmp(&data[offset], "data", 4) == 0);
+                UTEST_ASSERT(get_u32(&data[offset + 4]) == 0xffffffffu);
+                offset     += 8;
+                UTEST_ASSERT(size == offset + padded);
+                UTEST_ASSERT((padded == data_size) || (data[size - 1] == 0));
+                *data_offset = offset;
+                return;
+
+            case timbremill::CONT_W64:
+                UTEST_ASSERT(memcmp(&data[0], "riff", 4) == 0);
+                UTEST_ASSERT(get_u64(&data[16]) == size);
+                UTEST_ASSERT(memcmp(&data[24], "wave", 4) == 0);
+                UTEST_ASSERT(memcmp(&data[40], "fmt ", 4) == 0);
+                fmt_size    = get_u64(&data[56]) - 24;
+                check_fmt(&data[64], fmt_size, channels, encoding);
+                offset      = 64 + fmt_size;
+                UTEST_ASSERT(memcmp(&data[offset], "data", 4) == 0);
+                UTEST_ASSERT(get_u64(&data[offset + 16]) == data_size + 24);
+                offset     += 24;
+                UTEST_ASSERT((offset % 8) == 0);
+                UTEST_ASSERT(size == offset + ((data_size + 7) & ~size_t(7)));
+                *data_offset = offset;
+                return;
+
+            default:
+                break;
+        }
+
+        UTEST_ASSERT(memcmp(&data[0], "RIFF", 4) == 0);
+        UTEST_ASSERT(get_u32(&data[4]) == size - 8);
+        UTEST_ASSERT(memcmp(&data[8], "WAVE", 4) == 0);
+        UTEST_ASSERT(memcmp(&data[12], "fmt ", 4) == 0);
+        fmt_size    = get_u32(&data[16]);
+        check_fmt(&data[20], fmt_size, channels, encoding);
+        offset      = 20 + fmt_size;
+        UTEST_ASSERT(memcmp(&data[offset], "data", 4) == 0);
+        UTEST_ASSERT(get_u32(&data[offset + 4]) == data_size);
+        offset     += 8;
+        UTEST_ASSERT(size == offset + padded);
+        UTEST_ASSERT((padded == data_size) || (data[size - 1] == 0));
+        *data_offset = offset;
+    }
+
+    int32_t decode_int(const uint8_t *p, size_t bytes)
+    {
+        uint32_t v  = (bytes == 2) ? get_u16(p) :
+                      (bytes == 3) ? get_u16(p) | (uint32_t(p[2]) << 16) : get_u32(p);
+        size_t shift = 32 - bytes * 8;
+        return int32_t(v << shift) >> shift;
+    }
+
+    int32_t expected_int(float v, ssize_t encoding)
+    {
+        if (encoding == timbremill::ENC_PCM32)
+        {
+            double kd   = double(GAIN) * 2147483647.0;
+            return int32_t(llrint(lsp_limit(v * kd, -2147483648.0, 2147483647.0)));
+        }
+
+        float max   = (encoding == timbremill::ENC_PCM16) ? 32767.0f : 8388607.0f;
+        return int32_t(lsp_limit(roundf(v * (GAIN * max)), -max - 1.0f, max));
+    }
+
+    void test_format(const dspu::Sample *s, ssize_t container, ssize_t encoding, ssize_t dither)
+    {
+        io::Path path;
+        timbremill::fformat_t fmt;
+        uint8_t *data = NULL;
+        size_t size = 0, offset = 0, channels = s->channels(), length = s->length();
+        size_t bytes = encoding_bytes(encoding);
+        size_t dithered = 0;
+
+        fmt.nContainer  = container;
+        fmt.nEncoding   = encoding;
+        fmt.nDither     = dither;
+
+        UTEST_ASSERT(path.fmt("%s/utest-%s-%d-%d-%d-%d.bin", tempdir(), full_name(),
+            int(channels), int(container), int(encoding), int(dither)) > 0);
+        printf("Writing audio file %s...\n", path.as_native());
+        UTEST_ASSERT(timbremill::write_audio_file(&path, s, &fmt, GAIN) == STATUS_OK);
+
+        read_file(&data, &size, &path);
+        check_header(&offset, data, size, container, channels, length, encoding);
+
+        // Validate the interleaved samples
+        for (size_t j=0; j<length; ++j)
+        {
+            for (size_t i=0; i<channels; ++i)
+            {
+                const uint8_t *p    = &data[offset + (j * channels + i) * bytes];
+                float v             = s->channel(i)[j];
+
+                if (encoding == timbremill::ENC_FLOAT32)
+                {
+                    uint32_t u      = get_u32(p);
+                    float f;
+                    memcpy(&f, &u, sizeof(f));
+                    UTEST_ASSERT(f == v * GAIN);
+                    continue;
+                }
+
+                int32_t a           = decode_int(p, bytes);
+                int32_t b           = expected_int(v, encoding);
+                if (dither == timbremill::DITHER_NONE)
+                {
+                    UTEST_ASSERT_MSG(a == b, "Sample %d of channel %d: %d vs %d", int(j), int(i), int(a), int(b));
+                    continue;
+                }
+
+                // The dither changes the value by few least significant bits
+                int32_t d           = (a > b) ? a - b : b - a;
+                UTEST_ASSERT_MSG(d <= ((dither == timbremill::DITHER_SHAPED) ? 3 : 1),
+                    "Sample %d of channel %d: %d vs %d", int(j), int(i), int(a), int(b));
+                if (d != 0)
+                    ++dithered;
+            }
+        }
+        if (dither != timbremill::DITHER_NONE)
+            UTEST_ASSERT(dithered > 0);
+
+        free(data);
+    }
+
+    UTEST_MAIN
+    {
+        static const ssize_t containers[] =
+        {
+            timbremill::CONT_WAV, timbremill::CONT_W64, timbremill::CONT_RF64, timbremill::CONT_RAW
+        };
+        static const ssize_t encodings[] =
+        {
+            timbremill::ENC_PCM16, timbremill::ENC_PCM24, timbremill::ENC_PCM32, timbremill::ENC_FLOAT32
+        };
+
+        // The ramp exceeds the full scale after the gain is applied to test the clipping
+        dspu::Sample s1, s2, s3;
+        UTEST_ASSERT(s1.init(1, LENGTH - 1, LENGTH - 1));
+        UTEST_ASSERT(s2.init(2, LENGTH, LENGTH));
+        UTEST_ASSERT(s3.init(3, LENGTH, LENGTH));
+        s1.set_sample_rate(SAMPLE_RATE);
+        s2.set_sample_rate(SAMPLE_RATE);
+        s3.set_sample_rate(SAMPLE_RATE);
+        for (size_t j=0; j<LENGTH; ++j)
+        {
+            float v     = 5.0f * j / (LENGTH - 1) - 2.5f;
+            for (size_t i=0; i<2; ++i)
+                s2.channel(i)[j]    = (i & 1) ? -v : v;
+            for (size_t i=0; i<3; ++i)
+                s3.channel(i)[j]    = v * (i + 1) * 0.25f;
+            if (j < s1.length())
+                s1.channel(0)[j]    = v;
+        }
+
+        // Each container with each encoding
+        for (size_t i=0; i<sizeof(containers)/sizeof(containers[0]); ++i)
+            for (size_t j=0; j<sizeof(encodings)/sizeof(encodings[0]); ++j)
+                test_format(&s2, containers[i], encodings[j], timbremill::DITHER_NONE);
+
+        // More than 2 channels require the extensible format even for 16 bits
+        test_format(&s3, timbremill::CONT_WAV, timbremill::ENC_PCM16, timbremill::DITHER_NONE);
+        test_format(&s3, timbremill::CONT_RF64, timbremill::ENC_FLOAT32, timbremill::DITHER_NONE);
+
+        // The odd size of the data chunk requires the padding byte
+        test_format(&s1, timbremill::CONT_WAV, timbremill::ENC_PCM24, timbremill::DITHER_NONE);
+        test_format(&s1, timbremill::CONT_RF64, timbremill::ENC_PCM24, timbremill::DITHER_NONE);
+        test_format(&s1, timbremill::CONT_W64, timbremill::ENC_PCM24, timbremill::DITHER_NONE);
+
+        // The dither keeps the value within few least significant bits
+        test_format(&s2, timbremill::CONT_WAV, timbremill::ENC_PCM16, timbremill::DITHER_TPDF);
+        test_format(&s2, timbremill::CONT_WAV, timbremill::ENC_PCM24, timbremill::DITHER_SHAPED);
+    }
+
+UTEST_END